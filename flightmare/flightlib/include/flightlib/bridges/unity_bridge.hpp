@@ -6,6 +6,8 @@
 
 // std libs
 #include <unistd.h>
+#include <algorithm>
+#include <chrono>
 #include <experimental/filesystem>
 #include <fstream>
 #include <map>
@@ -22,6 +24,8 @@
 #include "flightlib/bridges/unity_message_types.hpp"
 #include "flightlib/common/logger.hpp"
 #include "flightlib/common/math.hpp"
+#include "flightlib/common/point_cloud.hpp"
+#include "flightlib/common/rolling_histogram.hpp"
 #include "flightlib/common/quad_state.hpp"
 #include "flightlib/common/types.hpp"
 #include "flightlib/objects/quadrotor.hpp"
@@ -33,6 +37,17 @@ using json = nlohmann::json;
 
 namespace flightlib {
 
+// stages of one rendered frame, in order
+enum RenderStage : int {
+  Serialize = 0,
+  Send = 1,
+  RoundTrip = 2,
+  Decode = 3,
+  ImageCopy = 4,
+  Total = 5,
+  NumRenderStages = 6
+};
+
 class UnityBridge {
  public:
   // constructor & destructor
@@ -46,8 +61,17 @@ class UnityBridge {
   // public get functions
   bool getRender(const FrameID frame_id);
   bool handleOutput();
+  // waits for the reply to the request tagged with frame_id, replies to
+  // older requests are dropped without touching the camera images. false if
+  // a reply to a newer request arrives instead
+  bool handleOutput(const FrameID frame_id);
   bool getPointCloud(PointCloudMessage_t &pointcloud_msg,
                      Scalar time_out = 600.0);
+  // streams the point cloud over the socket. Needs a Unity build with the
+  // streaming endpoint, older builds (e.g. the bundled release) write the PLY
+  // file instead, which is reported as an error
+  bool getPointCloud(PointCloudMessage_t &pointcloud_msg,
+                     PointCloud &point_cloud, Scalar time_out = 600.0);
 
   // public set functions
   bool setScene(const SceneID &scene_id);
@@ -60,6 +84,30 @@ class UnityBridge {
   // public auxiliary functions
   inline void setPubPort(const std::string &pub_port) { pub_port_ = pub_port; };
   inline void setSubPort(const std::string &sub_port) { sub_port_ = sub_port; };
+  // only send changed vehicles/objects, with a full keyframe every
+  // keyframe_interval frames. Requires ID-matched updates on the Unity side.
+  bool setDeltaUpdates(const bool on, const int keyframe_interval = 30);
+  // send cameras and layers that were enabled or disabled with the next
+  // render request and skip disabled cameras when decoding the reply.
+  // Requires a Unity build that applies them to the reply of that request,
+  // off by default. Has to be set before the vehicles are added.
+  inline void setCameraUpdates(const bool on) { camera_updates_ = on; };
+  // the message of the last frame that was sent as delta update
+  inline const DeltaPubMessage_t &getDeltaMessage(void) const {
+    return delta_msg_;
+  };
+
+  // render timing, per stage rolling statistics
+  const RollingHistogram &getRenderTiming(const RenderStage stage) const;
+  // [stage x (mean, p50, p90, p99, max)] in seconds
+  Matrix<> getRenderTimingStats(void) const;
+  std::vector<std::string> getRenderTimingNames(void) const;
+  inline int64_t getNumFrames(void) const { return num_frames_; };
+  inline int64_t getPacketLatency(void) const { return u_packet_latency_; };
+  // print the timing every `interval` seconds, disabled if <= 0
+  inline void setTimingLogInterval(const Scalar interval) {
+    timing_log_interval_ = interval;
+  };
   // create unity bridge
   static std::shared_ptr<UnityBridge> getInstance(void) {
     static std::shared_ptr<UnityBridge> bridge_ptr =
@@ -73,6 +121,7 @@ class UnityBridge {
   //
   SettingsMessage_t settings_;
   PubMessage_t pub_msg_;
+  DeltaPubMessage_t delta_msg_;
   Logger logger_{"UnityBridge"};
 
   std::vector<std::shared_ptr<Quadrotor>> unity_quadrotors_;
@@ -88,15 +137,35 @@ class UnityBridge {
   zmqpp::socket sub_{context_, zmqpp::socket_type::subscribe};
   bool sendInitialSettings(void);
   bool handleSettings(void);
+  // collision flags and camera images of a received reply
+  bool decodeOutput(zmqpp::message &msg, const SubMessage_t &sub_msg,
+                    const int64_t t_received);
+  bool updateDeltaMessage(void);
+  // pick up cameras/layers that were enabled or disabled since the last
+  // frame, returns true if anything changed
+  bool updateCameraSettings(void);
 
   // timing variables
   int64_t num_frames_;
   int64_t last_downloaded_utime_;
   int64_t last_download_debug_utime_;
   int64_t u_packet_latency_;
+  int64_t last_sent_utime_{0};
+  std::vector<RollingHistogram> render_timing_;
+  Scalar timing_log_interval_{0.0};
+  static int64_t getUtime(void);
+  void logRenderTiming(void);
 
   // axuiliary variables
   const Scalar unity_connection_time_out_{60.0};
   bool unity_ready_{false};
+
+  // camera and layer changes after connecting
+  bool camera_updates_{false};
+
+  // delta updates
+  bool delta_updates_{false};
+  int keyframe_interval_{30};
+  int frames_since_keyframe_{0};
 };
 }  // namespace flightlib
\ No newline at end of file
@@ -46,7 +46,8 @@ struct Camera_t {
   // metadata
   bool is_depth{false};
   int output_index{0};
-  //
+  // render the camera at all, and which post processing layers
+  bool enabled{true};
   std::vector<bool> enabled_layers;
   // Transformation matrix from camera to vehicle body 4 x 4
   // use 1-D vector for json convention
@@ -105,6 +106,26 @@ struct PubMessage_t {
   FrameID frame_id{0};
   std::vector<Vehicle_t> vehicles;
   std::vector<Object_t> objects;
+  // tag the message as keyframe, only with delta updates
+  bool delta_updates{false};
+};
+
+// Pose of a vehicle or object, used for delta updates
+struct PoseUpdate_t {
+  std::string ID;
+  // unity coordinate system left hand, y up
+  std::vector<Scalar> position{0.0, 0.0, 0.0};
+  // unity quaternion (x, y, z, w)
+  std::vector<Scalar> rotation{0.0, 0.0, 0.0, 1.0};
+  std::vector<Scalar> size{1.0, 1.0, 1.0};  // scale
+};
+
+// Only the entities that changed since the last frame, matched by ID.
+// A full PubMessage_t (keyframe) is sent periodically.
+struct DeltaPubMessage_t {
+  FrameID frame_id{0};
+  std::vector<PoseUpdate_t> vehicles;
+  std::vector<PoseUpdate_t> objects;
 };
 
 //
@@ -127,6 +148,16 @@ struct PointCloudMessage_t {
   Scalar resolution{0.15};
   std::string path{"point_clouds_data/"};
   std::string file_name{"default"};
+  // send the points back over the socket instead of writing a PLY file
+  bool stream{false};
+  int chunk_size{65536};  // points per chunk
+};
+
+// header of a streamed point cloud chunk, followed by raw float xyz data
+struct PointCloudChunk_t {
+  int chunk_index{0};
+  int num_chunks{0};
+  size_t num_points{0};  // total number of points in the cloud
 };
 
 /*********************
@@ -143,6 +174,7 @@ inline void to_json(json &j, const Camera_t &o) {
            {"farClipPlane", o.far_clip_plane},
            {"T_BC", o.T_BC},
            {"isDepth", o.is_depth},
+           {"enabled", o.enabled},
            {"enabledLayers", o.enabled_layers},
            {"depthScale", o.depth_scale},
            {"outputIndex", o.output_index}};
@@ -187,6 +219,23 @@ inline void to_json(json &j, const SettingsMessage_t &o) {
 inline void to_json(json &j, const PubMessage_t &o) {
   j = json{
     {"frame_id", o.frame_id}, {"vehicles", o.vehicles}, {"objects", o.objects}};
+  if (o.delta_updates) j["keyframe"] = true;
+}
+
+// PoseUpdate_t
+inline void to_json(json &j, const PoseUpdate_t &o) {
+  j = json{{"ID", o.ID},
+           {"position", o.position},
+           {"rotation", o.rotation},
+           {"size", o.size}};
+}
+
+// Publish delta messages to unity
+inline void to_json(json &j, const DeltaPubMessage_t &o) {
+  j = json{{"frame_id", o.frame_id},
+           {"keyframe", false},
+           {"vehicles", o.vehicles},
+           {"objects", o.objects}};
 }
 
 // Publish messages to unity
@@ -208,7 +257,15 @@ inline void to_json(json &j, const PointCloudMessage_t &o) {
            {"origin", o.origin},
            {"resolution", o.resolution},
            {"path", o.path},
-           {"file_name", o.file_name}};
+           {"file_name", o.file_name},
+           {"stream", o.stream},
+           {"chunk_size", o.chunk_size}};
+}
+
+inline void from_json(const json &j, PointCloudChunk_t &o) {
+  o.chunk_index = j.at("chunk_index").get<int>();
+  o.num_chunks = j.at("num_chunks").get<int>();
+  o.num_points = j.at("num_points").get<size_t>();
 }
 
 // Struct for outputting parsed received messages to handler functions
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "flightlib/common/types.hpp"
+
+namespace flightlib {
+
+/*
+ * In-memory point cloud, stored as packed float xyz triplets.
+ *
+ * The buffer is filled incrementally from raw chunks (e.g. streamed from
+ * Unity), so consumers like the motion planner can use it without going
+ * through a PLY file on disk. `points()` maps the buffer as a 3 x N matrix
+ * without copying.
+ */
+class PointCloud {
+ public:
+  using PointsMap = Map<const Matrix<3, Dynamic>>;
+
+  PointCloud();
+  ~PointCloud();
+
+  // incremental decoding
+  void reset(const size_t expected_points = 0);
+  bool appendChunk(const uint8_t* data, const size_t num_bytes);
+
+  // public get functions
+  inline size_t size(void) const { return buffer_.size() / 3; };
+  inline bool empty(void) const { return buffer_.empty(); };
+  inline const float* data(void) const { return buffer_.data(); };
+  inline PointsMap points(void) const {
+    return PointsMap(buffer_.data(), 3, size());
+  };
+  bool getBounds(Ref<Vector<3>> min_bounds, Ref<Vector<3>> max_bounds) const;
+
+ private:
+  std::vector<float> buffer_;
+  // trailing bytes of a point split across two chunks
+  std::vector<uint8_t> partial_;
+};
+
+}  // namespace flightlib
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace flightlib {
+
+/*
+ * Bounded single-producer/single-consumer ring buffer.
+ *
+ * The buffer implements "latest-frame-wins" semantics: pushing into a full
+ * buffer drops the oldest element instead of the newest one. Producer and
+ * consumer never take a lock; each slot carries a sequence number that hands
+ * ownership back and forth (Vyukov-style bounded queue). When the buffer is
+ * full, the slot the producer writes next holds the oldest element. The
+ * producer claims it with the same compare-and-swap on the dequeue position
+ * the consumer pops with, so exactly one side owns the slot: either the
+ * producer drops the element and overwrites it, or the consumer pops it and
+ * the producer waits until the slot is released.
+ *
+ * The consumer additionally keeps the most recently popped element in a
+ * consumer-owned slot, so `peekLatest()` can hand out a reference to the
+ * newest element without copying it.
+ *
+ * push() must only be called from one thread, pop()/popLatest()/peekLatest()
+ * only from one (other) thread.
+ */
+template<typename T>
+class RingBuffer {
+ public:
+  explicit RingBuffer(const size_t capacity = 2)
+    : mask_(roundUpPowerOfTwo(capacity) - 1), cells_(mask_ + 1) {
+    for (size_t i = 0; i < cells_.size(); i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  /// Producer: insert an element, dropping the oldest one if full.
+  void push(T item) {
+    const size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[pos & mask_];
+    while (cell.sequence.load(std::memory_order_acquire) != pos) {
+      // buffer is full and the slot holds the oldest element, claim it like
+      // a pop. If the consumer claimed it first, wait until it has moved the
+      // element out and released the slot.
+      size_t oldest = pos - capacity();
+      if (dequeue_pos_.compare_exchange_strong(oldest, oldest + 1,
+                                               std::memory_order_relaxed)) {
+        num_dropped_.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+      std::this_thread::yield();
+    }
+    cell.data = std::move(item);
+    enqueue_pos_.store(pos + 1, std::memory_order_relaxed);
+    cell.sequence.store(pos + 1, std::memory_order_release);
+  }
+
+  /// Consumer: take the oldest element.
+  bool pop(T& item) {
+    if (!tryPop(item)) return false;
+    latest_ = item;
+    has_latest_ = true;
+    fresh_ = false;
+    return true;
+  }
+
+  /// Consumer: take the newest element and discard every older one.
+  bool popLatest(T& item) {
+    drain();
+    if (!fresh_) return false;
+    item = latest_;
+    fresh_ = false;
+    return true;
+  }
+
+  /// Consumer: reference to the newest element without copying or
+  /// consuming it. Returns nullptr if nothing was ever received. The pointer
+  /// stays valid until the next consumer call.
+  const T* peekLatest(void) {
+    drain();
+    return has_latest_ ? &latest_ : nullptr;
+  }
+
+  /// Consumer: discard every element.
+  void clear(void) {
+    drain();
+    fresh_ = false;
+  }
+
+  inline size_t capacity(void) const { return mask_ + 1; };
+  inline uint64_t numDropped(void) const {
+    return num_dropped_.load(std::memory_order_relaxed);
+  };
+  inline size_t size(void) const {
+    const size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+    const size_t head = dequeue_pos_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  };
+  inline bool empty(void) const { return size() == 0; };
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static size_t roundUpPowerOfTwo(const size_t n) {
+    // at least two slots, otherwise "full" and "ready" become ambiguous
+    size_t cap = 2;
+    while (cap < n) cap <<= 1;
+    return cap;
+  }
+
+  // claim the oldest slot; callable from both producer and consumer
+  bool tryPop(T& item) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      const size_t seq = cell.sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          item = std::move(cell.data);
+          cell.data = T();
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void drain(void) {
+    T item;
+    while (tryPop(item)) {
+      latest_ = std::move(item);
+      has_latest_ = true;
+      fresh_ = true;
+    }
+  }
+
+  const size_t mask_;
+  std::vector<Cell> cells_;
+
+  // keep producer and consumer indices on separate cache lines
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+  std::atomic<uint64_t> num_dropped_{0};
+
+  // consumer-owned
+  alignas(64) T latest_;
+  bool has_latest_{false};
+  bool fresh_{false};
+};
+
+}  // namespace flightlib
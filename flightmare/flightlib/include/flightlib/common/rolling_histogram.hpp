@@ -0,0 +1,55 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "flightlib/common/types.hpp"
+
+namespace flightlib {
+
+/*
+ * Rolling window of timing samples.
+ *
+ * Keeps the last `window` samples in a circular buffer and reports
+ * statistics (mean, min, max, percentiles) and a histogram over them. Unlike
+ * `Timer`, old samples fall out of the window, so the statistics follow the
+ * current behaviour of a long running process.
+ */
+class RollingHistogram {
+ public:
+  RollingHistogram(const std::string name = "", const size_t window = 300);
+  ~RollingHistogram() {}
+
+  /// Add one sample (in seconds).
+  void add(const Scalar sample);
+
+  /// Reset saved samples.
+  void reset();
+
+  // Accessors
+  Scalar mean() const;
+  Scalar min() const;
+  Scalar max() const;
+  Scalar last() const;
+  Scalar percentile(const Scalar p) const;
+  size_t count() const;
+  const std::string& name() const { return name_; }
+
+  /// Counts per bin, bins equally spaced in [0, max_value], the last bin
+  /// also collects everything above max_value.
+  std::vector<int> histogram(const int num_bins, const Scalar max_value) const;
+
+  /// Custom stream operator for outputs.
+  friend std::ostream& operator<<(std::ostream& os,
+                                  const RollingHistogram& hist);
+
+ private:
+  std::string name_;
+  std::vector<Scalar> samples_;
+  size_t window_;
+  size_t next_{0};
+  Scalar last_{0.0};
+};
+
+}  // namespace flightlib
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "flightlib/common/types.hpp"
+
+namespace flightlib {
+
+/*
+ * Voxelized occupancy grid with a Euclidean signed distance field (ESDF).
+ *
+ * The grid is built once from a point cloud: every voxel that contains a
+ * point is occupied. Two layers are derived from that occupancy:
+ *  - the collision layer, the occupancy dilated by an axis aligned box
+ *    (`inflate()`), so checking a box shaped robot is a single lookup.
+ *  - the ESDF (`computeESDF()`), the distance in meters from every voxel
+ *    center to the closest occupied voxel, negative inside obstacles. It is
+ *    computed with the exact separable distance transform of Felzenszwalb and
+ *    Huttenlocher in O(number of voxels).
+ *
+ * Segments are checked against the collision layer by walking every voxel
+ * they cross, which is the swept volume of the box at grid resolution. Where
+ * the ESDF guarantees clearance the walk skips ahead instead.
+ *
+ * Queries outside of the grid are treated as free space.
+ *
+ * Every voxel takes about 14 bytes (occupancy, collision and ESDF layers,
+ * plus the work buffers while computing the ESDF), so build() rejects grids
+ * with more than max_voxels voxels instead of allocating them.
+ */
+class VoxelGrid {
+ public:
+  // about 700 MB
+  static constexpr size_t kDefaultMaxVoxels = 50000000;
+
+  VoxelGrid();
+  ~VoxelGrid();
+
+  // occupancy from points, the grid covers their bounds plus margin. false
+  // and the grid is left unchanged if it would have more than max_voxels
+  bool build(const Ref<const Matrix<3, Dynamic>> points,
+             const Scalar resolution, const Scalar margin = 0.0,
+             const size_t max_voxels = kDefaultMaxVoxels);
+  // collision layer: occupancy dilated by a box with the given half extents
+  bool inflate(const Ref<const Vector<3>> half_extents);
+  bool computeESDF(void);
+
+  // public get functions
+  bool isOccupied(const Ref<const Vector<3>> point) const;
+  bool isInCollision(const Ref<const Vector<3>> point) const;
+  Scalar getDistance(const Ref<const Vector<3>> point) const;
+  // true if any voxel crossed by the segment collides, t_collision is the
+  // fraction of the segment where it enters the first colliding voxel
+  bool isInCollision(const Ref<const Vector<3>> start,
+                     const Ref<const Vector<3>> end,
+                     Scalar* t_collision = nullptr) const;
+  bool contains(const Ref<const Vector<3>> point) const;
+
+  inline Scalar getResolution(void) const { return resolution_; };
+  inline Vector<3> getOrigin(void) const { return origin_; };
+  inline Eigen::Vector3i getDims(void) const { return dims_; };
+  inline size_t size(void) const { return occupancy_.size(); };
+  inline bool hasESDF(void) const { return !esdf_.empty(); };
+
+ private:
+  // -1 if the point is outside of the grid
+  int64_t index(const Ref<const Vector<3>> point) const;
+  // 1-D squared distance transform of f into d, v and z are work buffers
+  static void distanceTransform(const std::vector<Scalar>& f, const int n,
+                                std::vector<Scalar>& d, std::vector<int>& v,
+                                std::vector<Scalar>& z);
+  // squared distance transform of the grid along one axis
+  void transformAxis(std::vector<Scalar>& grid, const int axis) const;
+  // dilate the layer along one axis by radius voxels
+  void dilateAxis(std::vector<uint8_t>& layer, const int axis,
+                  const int radius) const;
+
+  Scalar resolution_{0.0};
+  Vector<3> origin_{0.0, 0.0, 0.0};
+  Eigen::Vector3i dims_{0, 0, 0};
+  Eigen::Matrix<int64_t, 3, 1> strides_{0, 0, 0};
+  // dilation of the collision layer in voxels
+  Eigen::Vector3i radius_{0, 0, 0};
+
+  std::vector<uint8_t> occupancy_;
+  std::vector<uint8_t> collision_;
+  std::vector<Scalar> esdf_;
+};
+
+}  // namespace flightlib
@@ -53,11 +53,17 @@ class QuadrotorEnv final : public EnvBase {
 
   // - public set functions
   bool loadParam(const YAML::Node &cfg);
+  bool loadCameraParam(const YAML::Node &cfg);
 
   // - public get functions
   bool getObs(Ref<Vector<>> obs) override;
   bool getAct(Ref<Vector<>> act) const;
   bool getAct(Command *const cmd) const;
+  // latest frame of the onboard camera, no copy (nullptr if none)
+  const cv::Mat *peekImage(const int image_layer) const;
+  inline std::shared_ptr<RGBCamera> getCamera(void) const {
+    return rgb_camera_;
+  };
 
   // - auxiliar functions
   bool isTerminalState(Scalar &reward) override;
@@ -69,6 +75,7 @@ class QuadrotorEnv final : public EnvBase {
  private:
   // quadrotor
   std::shared_ptr<Quadrotor> quadrotor_ptr_;
+  std::shared_ptr<RGBCamera> rgb_camera_;
   QuadState quad_state_;
   Command cmd_;
   Logger logger_{"QaudrotorEnv"};
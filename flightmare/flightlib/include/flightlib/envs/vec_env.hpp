@@ -9,6 +9,9 @@
 // openmp
 #include <omp.h>
 
+// opencv
+#include <opencv2/imgproc/imgproc.hpp>
+
 // flightlib
 #include "flightlib/bridges/unity_bridge.hpp"
 #include "flightlib/common/logger.hpp"
@@ -38,9 +41,13 @@ class VecEnv {
 
   // public set functions
   void setSeed(const int seed);
+  bool setImageOutput(const int downsample, const bool grayscale);
 
   // public get functions
   void getObs(Ref<MatrixRowMajor<>> obs);
+  // latest frame of every env, written into one [num_envs, H * W * C] tensor
+  bool getImages(const int image_layer, Ref<MatrixRowMajor<>> images);
+  std::vector<int> getImageShape(const int image_layer);
   size_t getEpisodeLength(void);
 
   // - auxiliary functions
@@ -54,6 +61,10 @@ class VecEnv {
   bool setUnity(bool render);
   bool connectUnity();
   void disconnectUnity();
+  // render timing, [stage x (mean, p50, p90, p99, max)] in seconds
+  bool getRenderTimingStats(Ref<MatrixRowMajor<>> stats);
+  std::vector<std::string> getRenderTimingNames(void);
+  void setRenderTimingLog(const Scalar interval);
 
   // public functions
   inline int getSeed(void) { return seed_; };
@@ -63,6 +74,7 @@ class VecEnv {
   inline int getActDim(void) { return act_dim_; };
   inline int getExtraInfoDim(void) { return extra_info_names_.size(); };
   inline int getNumOfEnvs(void) { return envs_.size(); };
+  inline EnvBase& getEnv(const int env_id) { return *envs_[env_id]; };
   inline std::vector<std::string>& getExtraInfoNames() {
     return extra_info_names_;
   };
@@ -90,6 +102,10 @@ class VecEnv {
   RenderMessage_t unity_output_;
   uint16_t receive_id_{0};
 
+  // image tensor export
+  int image_downsample_{1};
+  bool image_grayscale_{false};
+
   // auxiliar variables
   int seed_, num_envs_, obs_dim_, act_dim_;
   Matrix<> obs_dummy_;
@@ -62,9 +62,16 @@ class Quadrotor : ObjectBase {
 
   //
   inline Scalar getMass(void) { return dynamics_.getMass(); };
-  inline void setSize(const Ref<Vector<3>> size) { size_ = size; };
+  inline void setSize(const Ref<Vector<3>> size) {
+    size_ = size;
+    dirty_ = true;
+  };
   inline void setCollision(const bool collision) { collision_ = collision; };
 
+  // pose changed since the last render message
+  inline bool isDirty(void) const { return dirty_; };
+  inline void clearDirty(void) { dirty_ = false; };
+
  private:
   // quadrotor dynamics, integrators
   QuadrotorDynamics dynamics_;
@@ -79,6 +86,7 @@ class Quadrotor : ObjectBase {
   QuadState state_;
   Vector<3> size_;
   bool collision_;
+  bool dirty_{true};
 
   // auxiliar variablers
   Vector<4> motor_omega_;
@@ -10,11 +10,18 @@ class StaticObject {
   virtual ~StaticObject(){};
 
   // public set functions
-  virtual void setPosition(const Vector<3>& position) { position_ = position; };
+  virtual void setPosition(const Vector<3>& position) {
+    position_ = position;
+    dirty_ = true;
+  };
   virtual void setQuaternion(const Quaternion& quaternion) {
     quat_ = quaternion;
+    dirty_ = true;
+  };
+  virtual void setSize(const Vector<3>& size) {
+    size_ = size;
+    dirty_ = true;
   };
-  virtual void setSize(const Vector<3>& size) { size_ = size; };
 
   // public get functions
   virtual Vector<3> getPosition(void) { return position_; };
@@ -23,6 +30,10 @@ class StaticObject {
   const std::string& getID(void) { return id_; };
   const std::string& getPrefabID(void) { return prefab_id_; };
 
+  // pose changed since the last render message
+  inline bool isDirty(void) const { return dirty_; };
+  inline void clearDirty(void) { dirty_ = false; };
+
  private:
   std::string id_;
   std::string prefab_id_;
@@ -31,6 +42,7 @@ class StaticObject {
   Vector<3> position_{0.0, 0.0, 0.0};
   Quaternion quat_{1.0, 0.0, 0.0, 0.0};
   Vector<3> size_{1.0, 1.0, 1.0};
+  bool dirty_{true};
 };
 
 }  // namespace flightlib
@@ -1,15 +1,14 @@
 #pragma once
 
 #include <yaml-cpp/yaml.h>
-#include <deque>
 #include <functional>
 #include <memory>
-#include <mutex>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
 #include "flightlib/common/logger.hpp"
+#include "flightlib/common/ring_buffer.hpp"
 #include "flightlib/common/types.hpp"
 #include "flightlib/sensors/sensor_base.hpp"
 
@@ -46,7 +45,14 @@ class RGBCamera : SensorBase {
   bool getSegmentation(cv::Mat& segmentation);
   bool getOpticalFlow(cv::Mat& opticalflow);
 
+  // latest received frame of a layer, no copy and not consumed.
+  // the pointer is valid until the next get/peek call on the same layer.
+  const cv::Mat* peekImage(const int image_layer);
+
   // auxiliary functions
+  // a disabled camera is not rendered at all, regardless of its layers
+  void enable(const bool on);
+  bool isEnabled(void) const;
   void enableDepth(const bool on);
   void enableOpticalFlow(const bool on);
   void enableSegmentation(const bool on);
@@ -65,17 +71,18 @@ class RGBCamera : SensorBase {
   Vector<3> B_r_BC_;
   Matrix<4, 4> T_BC_;
 
-  // image data buffer
-  std::mutex queue_mutex_;
-  const int queue_size_ = 1;
+  // image data buffer (written by the bridge, read by the consumer)
+  static constexpr int queue_size_ = 2;
+  RingBuffer<cv::Mat>* getQueue(const int image_layer);
 
-  std::deque<cv::Mat> rgb_queue_;
-  std::deque<cv::Mat> depth_queue_;
-  std::deque<cv::Mat> opticalflow_queue_;
-  std::deque<cv::Mat> segmentation_queue_;
+  RingBuffer<cv::Mat> rgb_queue_{queue_size_};
+  RingBuffer<cv::Mat> depth_queue_{queue_size_};
+  RingBuffer<cv::Mat> opticalflow_queue_{queue_size_};
+  RingBuffer<cv::Mat> segmentation_queue_{queue_size_};
 
   // [depth, segmentation, optical flow]
   std::vector<bool> enabled_layers_;
+  bool enabled_{true};
 };
 
 }  // namespace flightlib
@@ -12,6 +12,10 @@ UnityBridge::UnityBridge()
     last_download_debug_utime_(0),
     u_packet_latency_(0),
     unity_ready_(false) {
+  // render timing statistics
+  for (const std::string& name : getRenderTimingNames()) {
+    render_timing_.push_back(RollingHistogram(name));
+  }
   // initialize connections upon creating unity bridge
   initializeConnections();
 }
@@ -105,29 +109,123 @@ bool UnityBridge::handleSettings(void) {
 };
 
 bool UnityBridge::getRender(const FrameID frame_id) {
-  pub_msg_.frame_id = frame_id;
-  QuadState quad_state;
-  for (size_t idx = 0; idx < pub_msg_.vehicles.size(); idx++) {
-    unity_quadrotors_[idx]->getState(&quad_state);
-    pub_msg_.vehicles[idx].position = positionRos2Unity(quad_state.p);
-    pub_msg_.vehicles[idx].rotation = quaternionRos2Unity(quad_state.q());
-  }
-
-  for (size_t idx = 0; idx < pub_msg_.objects.size(); idx++) {
-    std::shared_ptr<StaticObject> gate = static_objects_[idx];
-    pub_msg_.objects[idx].position = positionRos2Unity(gate->getPosition());
-    pub_msg_.objects[idx].rotation = quaternionRos2Unity(gate->getQuaternion());
-  }
+  const int64_t t_start = getUtime();
+  // camera settings are only part of keyframes
+  if (updateCameraSettings()) frames_since_keyframe_ = keyframe_interval_;
+  const bool keyframe =
+    !delta_updates_ || frames_since_keyframe_ >= keyframe_interval_;
 
   // create new message object
   zmqpp::message msg;
   // add topic header
   msg << "Pose";
-  // create JSON object for pose update and append
-  json json_msg = pub_msg_;
-  msg << json_msg.dump();
+  if (keyframe) {
+    pub_msg_.frame_id = frame_id;
+    QuadState quad_state;
+    for (size_t idx = 0; idx < pub_msg_.vehicles.size(); idx++) {
+      unity_quadrotors_[idx]->getState(&quad_state);
+      pub_msg_.vehicles[idx].position = positionRos2Unity(quad_state.p);
+      pub_msg_.vehicles[idx].rotation = quaternionRos2Unity(quad_state.q());
+      unity_quadrotors_[idx]->clearDirty();
+    }
+
+    for (size_t idx = 0; idx < pub_msg_.objects.size(); idx++) {
+      std::shared_ptr<StaticObject> gate = static_objects_[idx];
+      pub_msg_.objects[idx].position = positionRos2Unity(gate->getPosition());
+      pub_msg_.objects[idx].rotation =
+        quaternionRos2Unity(gate->getQuaternion());
+      gate->clearDirty();
+    }
+    frames_since_keyframe_ = 1;
+
+    // create JSON object for pose update and append
+    json json_msg = pub_msg_;
+    msg << json_msg.dump();
+  } else {
+    delta_msg_.frame_id = frame_id;
+    updateDeltaMessage();
+    frames_since_keyframe_++;
+
+    json json_msg = delta_msg_;
+    msg << json_msg.dump();
+  }
+  const int64_t t_serialized = getUtime();
   // send message without blocking
   pub_.send(msg, true);
+  last_sent_utime_ = getUtime();
+
+  render_timing_[RenderStage::Serialize].add(1e-6 * (t_serialized - t_start));
+  render_timing_[RenderStage::Send].add(1e-6 *
+                                        (last_sent_utime_ - t_serialized));
+  return true;
+}
+
+bool UnityBridge::updateDeltaMessage(void) {
+  delta_msg_.vehicles.clear();
+  delta_msg_.objects.clear();
+
+  QuadState quad_state;
+  for (size_t idx = 0; idx < unity_quadrotors_.size(); idx++) {
+    std::shared_ptr<Quadrotor> quad = unity_quadrotors_[idx];
+    if (!quad->isDirty()) continue;
+    quad->getState(&quad_state);
+    PoseUpdate_t pose;
+    pose.ID = pub_msg_.vehicles[idx].ID;
+    pose.position = positionRos2Unity(quad_state.p);
+    pose.rotation = quaternionRos2Unity(quad_state.q());
+    pose.size = scalarRos2Unity(quad->getSize());
+    delta_msg_.vehicles.push_back(pose);
+    quad->clearDirty();
+  }
+
+  for (size_t idx = 0; idx < static_objects_.size(); idx++) {
+    std::shared_ptr<StaticObject> object = static_objects_[idx];
+    if (!object->isDirty()) continue;
+    PoseUpdate_t pose;
+    pose.ID = object->getID();
+    pose.position = positionRos2Unity(object->getPosition());
+    pose.rotation = quaternionRos2Unity(object->getQuaternion());
+    pose.size = scalarRos2Unity(object->getSize());
+    delta_msg_.objects.push_back(pose);
+    object->clearDirty();
+  }
+  return true;
+}
+
+bool UnityBridge::updateCameraSettings(void) {
+  if (!camera_updates_) return false;
+  bool changed = false;
+  for (size_t idx = 0; idx < settings_.vehicles.size(); idx++) {
+    std::vector<std::shared_ptr<RGBCamera>> rgb_cameras =
+      unity_quadrotors_[idx]->getCameras();
+    for (size_t cam_idx = 0; cam_idx < rgb_cameras.size(); cam_idx++) {
+      Camera_t& camera_t = settings_.vehicles[idx].cameras[cam_idx];
+      const bool enabled = rgb_cameras[cam_idx]->isEnabled();
+      const std::vector<bool> enabled_layers =
+        rgb_cameras[cam_idx]->getEnabledLayers();
+      if (camera_t.enabled == enabled &&
+          camera_t.enabled_layers == enabled_layers)
+        continue;
+      // the reply to this render request is decoded with the new settings
+      camera_t.enabled = enabled;
+      camera_t.enabled_layers = enabled_layers;
+      pub_msg_.vehicles[idx].cameras[cam_idx] = camera_t;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+bool UnityBridge::setDeltaUpdates(const bool on, const int keyframe_interval) {
+  if (keyframe_interval < 1) {
+    logger_.warn("Keyframe interval has to be >= 1, discard the setting.");
+    return false;
+  }
+  delta_updates_ = on;
+  pub_msg_.delta_updates = on;
+  keyframe_interval_ = keyframe_interval;
+  // always start with a keyframe
+  frames_since_keyframe_ = keyframe_interval_;
   return true;
 }
 
@@ -167,6 +265,8 @@ bool UnityBridge::addQuadrotor(std::shared_ptr<Quadrotor> quad) {
     camera_t.height = rgb_cameras[cam_idx]->getHeight();
     camera_t.fov = rgb_cameras[cam_idx]->getFOV();
     camera_t.depth_scale = rgb_cameras[cam_idx]->getDepthScale();
+    // without camera updates Unity renders every camera it knows of
+    camera_t.enabled = !camera_updates_ || rgb_cameras[cam_idx]->isEnabled();
     camera_t.enabled_layers = rgb_cameras[cam_idx]->getEnabledLayers();
     camera_t.is_depth = false;
     camera_t.output_index = cam_idx;
@@ -176,6 +276,8 @@ bool UnityBridge::addQuadrotor(std::shared_ptr<Quadrotor> quad) {
     rgb_cameras_.push_back(rgb_cameras[cam_idx]);
   }
   unity_quadrotors_.push_back(quad);
+  // new entities are only known to Unity after the next keyframe
+  frames_since_keyframe_ = keyframe_interval_;
 
   //
   settings_.vehicles.push_back(vehicle_t);
@@ -192,6 +294,7 @@ bool UnityBridge::addStaticObject(std::shared_ptr<StaticObject> static_object) {
   object_t.size = scalarRos2Unity(static_object->getSize());
 
   static_objects_.push_back(static_object);
+  frames_since_keyframe_ = keyframe_interval_;
   settings_.objects.push_back(object_t);
   pub_msg_.objects.push_back(object_t);
   //
@@ -202,78 +305,192 @@ bool UnityBridge::handleOutput() {
   // create new message object
   zmqpp::message msg;
   sub_.receive(msg);
+  const int64_t t_received = getUtime();
   // unpack message metadata
   std::string json_sub_msg = msg.get(0);
   // parse metadata
   SubMessage_t sub_msg = json::parse(json_sub_msg);
+  return decodeOutput(msg, sub_msg, t_received);
+}
 
-  size_t image_i = 1;
-  // ensureBufferIsAllocated(sub_msg);
-  for (size_t idx = 0; idx < settings_.vehicles.size(); idx++) {
-    // update vehicle collision flag
-    unity_quadrotors_[idx]->setCollision(sub_msg.sub_vehicles[idx].collision);
+bool UnityBridge::handleOutput(const FrameID frame_id) {
+  while (true) {
+    zmqpp::message msg;
+    sub_.receive(msg);
+    const int64_t t_received = getUtime();
+    SubMessage_t sub_msg = json::parse(msg.get(0));
+    // late reply to an earlier request, read it off the socket so the next
+    // reply is the one to this request, its images are stale
+    if (sub_msg.frame_id < frame_id) {
+      logger_.warn("Dropped frame %lu, waiting for frame %lu.",
+                   (unsigned long)sub_msg.frame_id, (unsigned long)frame_id);
+      continue;
+    }
+    if (sub_msg.frame_id > frame_id) {
+      logger_.warn("Received frame %lu, expected %lu.",
+                   (unsigned long)sub_msg.frame_id, (unsigned long)frame_id);
+      return false;
+    }
+    return decodeOutput(msg, sub_msg, t_received);
+  }
+}
 
-    // feed image data to RGB camera
+bool UnityBridge::decodeOutput(zmqpp::message& msg,
+                               const SubMessage_t& sub_msg,
+                               const int64_t t_received) {
+  const int64_t t_decoded = getUtime();
+  if (sub_msg.sub_vehicles.size() < settings_.vehicles.size()) {
+    logger_.error("Frame %lu has %lu vehicles, expected %lu.",
+                  (unsigned long)sub_msg.frame_id,
+                  sub_msg.sub_vehicles.size(), settings_.vehicles.size());
+    return false;
+  }
+
+  // images in the order Unity sends them, one message part each
+  struct ImagePart {
+    size_t vehicle_idx;
+    const Camera_t* cam;
+    size_t layer_idx;
+  };
+  std::vector<ImagePart> parts;
+  for (size_t idx = 0; idx < settings_.vehicles.size(); idx++) {
     for (const auto& cam : settings_.vehicles[idx].cameras) {
+      // disabled cameras are not rendered, no images in the message
+      if (!cam.enabled) continue;
       for (size_t layer_idx = 0; layer_idx <= cam.enabled_layers.size();
            layer_idx++) {
         if (!layer_idx == 0 && !cam.enabled_layers[layer_idx - 1]) continue;
+        parts.push_back(ImagePart{idx, &cam, layer_idx});
+      }
+    }
+  }
+
+  // the images are wrapped without a copy, check the layout against the
+  // settings before reading any of them. Trailing parts are only tolerated
+  // while the camera settings are fixed, with camera updates they mean that
+  // Unity still renders a camera that was disabled.
+  if (msg.parts() < parts.size() + 1 ||
+      (camera_updates_ && msg.parts() > parts.size() + 1)) {
+    logger_.error("Frame %lu has %lu images, expected %lu.",
+                  (unsigned long)sub_msg.frame_id, msg.parts() - 1,
+                  parts.size());
+    return false;
+  }
+  for (size_t i = 0; i < parts.size(); i++) {
+    const Camera_t& cam = *parts[i].cam;
+    // depth is one float per pixel
+    const size_t bytes_per_pixel =
+      parts[i].layer_idx == 1 ? sizeof(float) : (size_t)cam.channels;
+    const size_t num_bytes =
+      (size_t)cam.width * (size_t)cam.height * bytes_per_pixel;
+    if (msg.size(i + 1) != num_bytes) {
+      logger_.error("Image %lu of frame %lu has %lu bytes, expected %lu.", i,
+                    (unsigned long)sub_msg.frame_id, msg.size(i + 1),
+                    num_bytes);
+      return false;
+    }
+  }
 
-        if (layer_idx == 1) {
-          // depth
-          uint32_t image_len = cam.width * cam.height * 4;
-          // Get raw image bytes from ZMQ message.
-          // WARNING: This is a zero-copy operation that also casts the input to
-          // an array of unit8_t. when the message is deleted, this pointer is
-          // also dereferenced.
-          const uint8_t* image_data;
-          msg.get(image_data, image_i);
-          image_i = image_i + 1;
-          // Pack image into cv::Mat
-          cv::Mat new_image = cv::Mat(cam.height, cam.width, CV_32FC1);
-          memcpy(new_image.data, image_data, image_len);
-          // Flip image since OpenCV origin is upper left, but Unity's is lower
-          // left.
-          new_image = new_image * (100.f);
-          cv::flip(new_image, new_image, 0);
-
-
-          unity_quadrotors_[idx]
-            ->getCameras()[cam.output_index]
-            ->feedImageQueue(layer_idx, new_image);
-
-
-        } else {
-          uint32_t image_len = cam.width * cam.height * cam.channels;
-          // Get raw image bytes from ZMQ message.
-          // WARNING: This is a zero-copy operation that also casts the input to
-          // an array of unit8_t. when the message is deleted, this pointer is
-          // also dereferenced.
-          const uint8_t* image_data;
-          msg.get(image_data, image_i);
-          image_i = image_i + 1;
-          // Pack image into cv::Mat
-          cv::Mat new_image =
-            cv::Mat(cam.height, cam.width, CV_MAKETYPE(CV_8U, cam.channels));
-          memcpy(new_image.data, image_data, image_len);
-          // Flip image since OpenCV origin is upper left, but Unity's is lower
-          // left.
-          cv::flip(new_image, new_image, 0);
-
-          // Tell OpenCv that the input is RGB.
-          if (cam.channels == 3) {
-            cv::cvtColor(new_image, new_image, CV_RGB2BGR);
-          }
-          unity_quadrotors_[idx]
-            ->getCameras()[cam.output_index]
-            ->feedImageQueue(layer_idx, new_image);
-        }
+  for (size_t idx = 0; idx < settings_.vehicles.size(); idx++) {
+    // update vehicle collision flag
+    unity_quadrotors_[idx]->setCollision(sub_msg.sub_vehicles[idx].collision);
+  }
+
+  // feed image data to RGB camera
+  for (size_t i = 0; i < parts.size(); i++) {
+    const Camera_t& cam = *parts[i].cam;
+    const size_t layer_idx = parts[i].layer_idx;
+    // Get raw image bytes from ZMQ message.
+    // WARNING: This is a zero-copy operation that also casts the input to
+    // an array of unit8_t. when the message is deleted, this pointer is
+    // also dereferenced.
+    const uint8_t* image_data;
+    msg.get(image_data, i + 1);
+
+    cv::Mat new_image;
+    if (layer_idx == 1) {
+      // depth
+      // Flip image since OpenCV origin is upper left, but Unity's is lower
+      // left. The flip copies straight out of the message buffer.
+      const cv::Mat raw_image(cam.height, cam.width, CV_32FC1,
+                              const_cast<uint8_t*>(image_data));
+      cv::flip(raw_image, new_image, 0);
+      new_image *= 100.f;
+    } else {
+      // Flip image since OpenCV origin is upper left, but Unity's is lower
+      // left. The flip copies straight out of the message buffer.
+      const cv::Mat raw_image(cam.height, cam.width,
+                              CV_MAKETYPE(CV_8U, cam.channels),
+                              const_cast<uint8_t*>(image_data));
+      cv::flip(raw_image, new_image, 0);
+
+      // Tell OpenCv that the input is RGB.
+      if (cam.channels == 3) {
+        cv::cvtColor(new_image, new_image, CV_RGB2BGR);
       }
     }
+    unity_quadrotors_[parts[i].vehicle_idx]
+      ->getCameras()[cam.output_index]
+      ->feedImageQueue(layer_idx, new_image);
+  }
+
+  // timing
+  num_frames_++;
+  last_downloaded_utime_ = getUtime();
+  u_packet_latency_ = t_received - last_sent_utime_;
+  render_timing_[RenderStage::RoundTrip].add(1e-6 * u_packet_latency_);
+  render_timing_[RenderStage::Decode].add(1e-6 * (t_decoded - t_received));
+  render_timing_[RenderStage::ImageCopy].add(
+    1e-6 * (last_downloaded_utime_ - t_decoded));
+  render_timing_[RenderStage::Total].add(
+    render_timing_[RenderStage::Serialize].last() +
+    render_timing_[RenderStage::Send].last() +
+    1e-6 * (last_downloaded_utime_ - last_sent_utime_));
+  if (timing_log_interval_ > 0.0 &&
+      last_downloaded_utime_ - last_download_debug_utime_ >
+        1e6 * timing_log_interval_) {
+    logRenderTiming();
+    last_download_debug_utime_ = last_downloaded_utime_;
   }
   return true;
 }
 
+int64_t UnityBridge::getUtime(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+const RollingHistogram& UnityBridge::getRenderTiming(
+  const RenderStage stage) const {
+  return render_timing_[stage];
+}
+
+std::vector<std::string> UnityBridge::getRenderTimingNames(void) const {
+  return std::vector<std::string>{"serialize", "send",       "round_trip",
+                                  "decode",    "image_copy", "total"};
+}
+
+Matrix<> UnityBridge::getRenderTimingStats(void) const {
+  Matrix<> stats(render_timing_.size(), 5);
+  for (size_t i = 0; i < render_timing_.size(); i++) {
+    const RollingHistogram& hist = render_timing_[i];
+    stats.row(i) << hist.mean(), hist.percentile(50), hist.percentile(90),
+      hist.percentile(99), hist.max();
+  }
+  return stats;
+}
+
+void UnityBridge::logRenderTiming(void) {
+  const Scalar fps =
+    1.0 / std::max(render_timing_[RenderStage::Total].mean(), (Scalar)1e-6);
+  logger_.info("Rendered %ld frames, %.1f fps, packet latency %.2f ms.",
+               num_frames_, fps, 1e-3 * u_packet_latency_);
+  for (const RollingHistogram& hist : render_timing_) {
+    logger_ << hist << std::endl;
+  }
+}
+
 bool UnityBridge::getPointCloud(PointCloudMessage_t& pointcloud_msg,
                                 Scalar time_out) {
   // create new message object
@@ -304,4 +521,101 @@ bool UnityBridge::getPointCloud(PointCloudMessage_t& pointcloud_msg,
   return true;
 }
 
+bool UnityBridge::getPointCloud(PointCloudMessage_t& pointcloud_msg,
+                                PointCloud& point_cloud, Scalar time_out) {
+  // create new message object
+  zmqpp::message msg;
+  // add topic header
+  msg << "PointCloud";
+  // request the point cloud to be streamed back in chunks
+  pointcloud_msg.stream = true;
+  // a Unity build without the streaming endpoint ignores the stream flag and
+  // writes the PLY file instead
+  const std::string ply_file =
+    pointcloud_msg.path + pointcloud_msg.file_name + ".ply";
+  const bool ply_existed = std::experimental::filesystem::exists(ply_file);
+  json json_msg = pointcloud_msg;
+  msg << json_msg.dump();
+  // send message without blocking
+  pub_.send(msg, true);
+
+  logger_.info("Streaming PointCloud: Timeout=%d seconds.", (int)time_out);
+
+  zmqpp::poller poller;
+  poller.add(sub_);
+
+  const auto t_start = std::chrono::steady_clock::now();
+  int num_chunks = -1, num_received = 0;
+  while (num_chunks < 0 || num_received < num_chunks) {
+    const Scalar run_time =
+      std::chrono::duration<Scalar>(std::chrono::steady_clock::now() - t_start)
+        .count();
+    if (run_time >= time_out) {
+      if (num_chunks < 0) {
+        logger_.error(
+          "Timeout... no PointCloud chunk received. The Unity build may not "
+          "support point cloud streaming, use the PLY file instead.");
+      } else {
+        logger_.warn("Timeout... PointCloud was not received within expected "
+                     "time, %d/%d chunks.", num_received, num_chunks);
+      }
+      return false;
+    }
+    if (num_chunks < 0 && !ply_existed &&
+        std::experimental::filesystem::exists(ply_file)) {
+      logger_.error(
+        "The Unity build does not support point cloud streaming, it wrote %s "
+        "instead. Read the PLY file or update the Unity build.",
+        ply_file.c_str());
+      return false;
+    }
+    // block on the socket, waking up once a second for the checks above
+    const Scalar wait_time = std::min(time_out - run_time, (Scalar)1.0);
+    if (!poller.poll((long)(1e3 * wait_time)) || !poller.has_input(sub_))
+      continue;
+
+    zmqpp::message chunk_msg;
+    sub_.receive(chunk_msg);
+    // this json version has no non-throwing parse, a malformed or partial
+    // frame must not take down the caller
+    json metadata;
+    try {
+      metadata = json::parse(chunk_msg.get(0));
+    } catch (const std::exception& e) {
+      logger_.error("PointCloud received a malformed message: %s", e.what());
+      return false;
+    }
+    if (!metadata.is_object() || metadata.count("chunk_index") == 0 ||
+        chunk_msg.parts() < 2) {
+      // not a point cloud chunk (e.g. a late render output), skip it
+      continue;
+    }
+    PointCloudChunk_t chunk;
+    try {
+      chunk = metadata.get<PointCloudChunk_t>();
+    } catch (const std::exception& e) {
+      logger_.error("PointCloud received a malformed chunk header: %s",
+                    e.what());
+      return false;
+    }
+    if (num_chunks < 0) {
+      num_chunks = chunk.num_chunks;
+      point_cloud.reset(chunk.num_points);
+    }
+    if (chunk.chunk_index != num_received) {
+      logger_.error("PointCloud chunk %d received out of order, expected %d.",
+                    chunk.chunk_index, num_received);
+      return false;
+    }
+
+    // WARNING: zero-copy view into the ZMQ message, decoded right away.
+    const uint8_t* chunk_data;
+    chunk_msg.get(chunk_data, 1);
+    point_cloud.appendChunk(chunk_data, chunk_msg.size(1));
+    num_received++;
+  }
+  logger_.info("Received PointCloud with %d points.", (int)point_cloud.size());
+  return true;
+}
+
 }  // namespace flightlib
@@ -0,0 +1,60 @@
+#include "flightlib/common/point_cloud.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace flightlib {
+
+PointCloud::PointCloud() {}
+
+PointCloud::~PointCloud() {}
+
+void PointCloud::reset(const size_t expected_points) {
+  buffer_.clear();
+  partial_.clear();
+  buffer_.reserve(3 * expected_points);
+}
+
+bool PointCloud::appendChunk(const uint8_t* data, const size_t num_bytes) {
+  if (data == nullptr && num_bytes > 0) return false;
+
+  const size_t point_bytes = 3 * sizeof(float);
+  size_t offset = 0;
+
+  // complete a point that was split by the previous chunk
+  if (!partial_.empty()) {
+    const size_t missing =
+      std::min(point_bytes - partial_.size(), num_bytes);
+    partial_.insert(partial_.end(), data, data + missing);
+    offset = missing;
+    if (partial_.size() < point_bytes) return true;
+
+    const size_t old_size = buffer_.size();
+    buffer_.resize(old_size + 3);
+    std::memcpy(buffer_.data() + old_size, partial_.data(), point_bytes);
+    partial_.clear();
+  }
+
+  // decode all complete points directly into the buffer
+  const size_t num_points = (num_bytes - offset) / point_bytes;
+  const size_t old_size = buffer_.size();
+  buffer_.resize(old_size + 3 * num_points);
+  std::memcpy(buffer_.data() + old_size, data + offset,
+              num_points * point_bytes);
+  offset += num_points * point_bytes;
+
+  // keep the remainder for the next chunk
+  partial_.assign(data + offset, data + num_bytes);
+  return true;
+}
+
+bool PointCloud::getBounds(Ref<Vector<3>> min_bounds,
+                           Ref<Vector<3>> max_bounds) const {
+  if (empty()) return false;
+  const PointsMap pts = points();
+  min_bounds = pts.rowwise().minCoeff();
+  max_bounds = pts.rowwise().maxCoeff();
+  return true;
+}
+
+}  // namespace flightlib
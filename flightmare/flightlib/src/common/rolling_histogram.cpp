@@ -0,0 +1,84 @@
+#include "flightlib/common/rolling_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace flightlib {
+
+RollingHistogram::RollingHistogram(const std::string name, const size_t window)
+  : name_(name), window_(std::max(window, (size_t)1)) {
+  samples_.reserve(window_);
+}
+
+void RollingHistogram::add(const Scalar sample) {
+  last_ = sample;
+  if (samples_.size() < window_) {
+    samples_.push_back(sample);
+  } else {
+    samples_[next_] = sample;
+  }
+  next_ = (next_ + 1) % window_;
+}
+
+void RollingHistogram::reset() {
+  samples_.clear();
+  next_ = 0;
+  last_ = 0.0;
+}
+
+Scalar RollingHistogram::mean() const {
+  if (samples_.empty()) return 0.0;
+  return std::accumulate(samples_.begin(), samples_.end(), (Scalar)0.0) /
+         samples_.size();
+}
+
+Scalar RollingHistogram::min() const {
+  if (samples_.empty()) return 0.0;
+  return *std::min_element(samples_.begin(), samples_.end());
+}
+
+Scalar RollingHistogram::max() const {
+  if (samples_.empty()) return 0.0;
+  return *std::max_element(samples_.begin(), samples_.end());
+}
+
+Scalar RollingHistogram::last() const { return last_; }
+
+Scalar RollingHistogram::percentile(const Scalar p) const {
+  if (samples_.empty()) return 0.0;
+  std::vector<Scalar> sorted = samples_;
+  // NaN falls through to the 0th percentile
+  const Scalar clamped = p > 0.0 ? std::min(p, (Scalar)100.0) : (Scalar)0.0;
+  const size_t k =
+    std::min((size_t)std::round(clamped / 100.0 * (sorted.size() - 1)),
+             sorted.size() - 1);
+  std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+  return sorted[k];
+}
+
+size_t RollingHistogram::count() const { return samples_.size(); }
+
+std::vector<int> RollingHistogram::histogram(const int num_bins,
+                                             const Scalar max_value) const {
+  std::vector<int> bins(std::max(num_bins, 1), 0);
+  if (max_value <= 0.0) return bins;
+  for (const Scalar sample : samples_) {
+    const int idx = (int)(sample / max_value * bins.size());
+    bins[std::min(std::max(idx, 0), (int)bins.size() - 1)]++;
+  }
+  return bins;
+}
+
+std::ostream& operator<<(std::ostream& os, const RollingHistogram& hist) {
+  const std::streamsize prec = os.precision();
+  os.precision(3);
+  os << hist.name_ << " [ms] mean|p50|p90|max:  " << 1000 * hist.mean()
+     << " | " << 1000 * hist.percentile(50) << " | "
+     << 1000 * hist.percentile(90) << " | " << 1000 * hist.max() << " ("
+     << hist.count() << " samples)";
+  os.precision(prec);
+  return os;
+}
+
+}  // namespace flightlib
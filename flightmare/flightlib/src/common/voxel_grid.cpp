@@ -0,0 +1,277 @@
+#include "flightlib/common/voxel_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace flightlib {
+
+// stands in for infinity, large but finite to keep the parabola
+// intersections well defined
+static constexpr Scalar kFar = 1e20;
+
+VoxelGrid::VoxelGrid() {}
+
+VoxelGrid::~VoxelGrid() {}
+
+bool VoxelGrid::build(const Ref<const Matrix<3, Dynamic>> points,
+                      const Scalar resolution, const Scalar margin,
+                      const size_t max_voxels) {
+  if (points.cols() == 0 || !(resolution > 0.0) || margin < 0.0 ||
+      !points.allFinite()) {
+    return false;
+  }
+  const Vector<3> origin = points.rowwise().minCoeff().array() - margin;
+  const Vector<3> extent =
+    points.rowwise().maxCoeff().array() + margin - origin.array();
+  // count in double, the product of the dimensions can overflow any integer
+  double num_voxels = 1.0;
+  Eigen::Vector3i dims;
+  for (int i = 0; i < 3; i++) {
+    // same rounding as index()
+    const double dim = std::floor(extent(i) / resolution) + 1.0;
+    if (dim > std::numeric_limits<int>::max()) return false;
+    dims(i) = (int)dim;
+    num_voxels *= dim;
+  }
+  if (num_voxels > (double)max_voxels) return false;
+
+  resolution_ = resolution;
+  origin_ = origin;
+  dims_ = dims;
+  strides_ << 1, dims_.x(), (int64_t)dims_.x() * dims_.y();
+
+  occupancy_.assign((size_t)num_voxels, 0);
+  for (int i = 0; i < points.cols(); i++) {
+    const int64_t idx = index(points.col(i));
+    if (idx >= 0) occupancy_[idx] = 1;
+  }
+  collision_ = occupancy_;
+  radius_.setZero();
+  esdf_.clear();
+  return true;
+}
+
+bool VoxelGrid::inflate(const Ref<const Vector<3>> half_extents) {
+  if (occupancy_.empty() || (half_extents.array() < 0.0).any()) return false;
+  collision_ = occupancy_;
+  for (int axis = 0; axis < 3; axis++) {
+    radius_(axis) = (int)std::ceil(half_extents(axis) / resolution_);
+    if (radius_(axis) > 0) dilateAxis(collision_, axis, radius_(axis));
+  }
+  return true;
+}
+
+bool VoxelGrid::computeESDF(void) {
+  if (occupancy_.empty()) return false;
+  const size_t num_voxels = occupancy_.size();
+
+  // squared voxel distance to the closest occupied and free voxel
+  std::vector<Scalar> to_occupied(num_voxels), to_free(num_voxels);
+  for (size_t i = 0; i < num_voxels; i++) {
+    to_occupied[i] = occupancy_[i] ? 0.0 : kFar;
+    to_free[i] = occupancy_[i] ? kFar : 0.0;
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    transformAxis(to_occupied, axis);
+    transformAxis(to_free, axis);
+  }
+
+  esdf_.resize(num_voxels);
+#pragma omp parallel for
+  for (int64_t i = 0; i < (int64_t)num_voxels; i++) {
+    esdf_[i] = occupancy_[i] ? -resolution_ * std::sqrt(to_free[i])
+                             : resolution_ * std::sqrt(to_occupied[i]);
+  }
+  return true;
+}
+
+bool VoxelGrid::isOccupied(const Ref<const Vector<3>> point) const {
+  const int64_t i = index(point);
+  return i >= 0 && occupancy_[i];
+}
+
+bool VoxelGrid::isInCollision(const Ref<const Vector<3>> point) const {
+  const int64_t i = index(point);
+  return i >= 0 && collision_[i];
+}
+
+Scalar VoxelGrid::getDistance(const Ref<const Vector<3>> point) const {
+  if (esdf_.empty()) return 0.0;
+  // outside of the grid, use the closest voxel on its boundary
+  Eigen::Vector3i voxel;
+  for (int i = 0; i < 3; i++) {
+    voxel(i) = std::min(
+      std::max((int)std::floor((point(i) - origin_(i)) / resolution_), 0),
+      dims_(i) - 1);
+  }
+  return esdf_[voxel.cast<int64_t>().dot(strides_)];
+}
+
+bool VoxelGrid::isInCollision(const Ref<const Vector<3>> start,
+                              const Ref<const Vector<3>> end,
+                              Scalar* t_collision) const {
+  if (collision_.empty()) return false;
+  const Vector<3> delta = end - start;
+  const Scalar length = delta.norm();
+  if (length <= 0.0) {
+    if (t_collision != nullptr) *t_collision = 0.0;
+    return isInCollision(start);
+  }
+  const Vector<3> dir = delta / length;
+
+  // clip the segment to the grid, outside of it is free space
+  Scalar t_enter = 0.0, t_exit = length;
+  for (int i = 0; i < 3; i++) {
+    const Scalar lower = origin_(i), upper = origin_(i) + dims_(i) * resolution_;
+    if (dir(i) == 0.0) {
+      if (start(i) < lower || start(i) >= upper) return false;
+      continue;
+    }
+    Scalar t0 = (lower - start(i)) / dir(i), t1 = (upper - start(i)) / dir(i);
+    if (t0 > t1) std::swap(t0, t1);
+    t_enter = std::max(t_enter, t0);
+    t_exit = std::min(t_exit, t1);
+  }
+  if (t_enter > t_exit) return false;
+
+  // the inflation box reaches at most sqrt(3) * radius voxels, so from a
+  // voxel with ESDF d the segment can move d minus that reach and one voxel
+  // diagonal for the voxel centers, plus one for rounding, without collision
+  const Scalar skip_offset =
+    std::sqrt(3.0) * (radius_.maxCoeff() + 2) * resolution_;
+
+  Scalar t = t_enter;
+  while (t <= t_exit) {
+    // voxel traversal (Amanatides and Woo) starting at t
+    const Vector<3> p = start + t * dir;
+    Eigen::Vector3i voxel, step;
+    Vector<3> t_max, t_delta;
+    for (int i = 0; i < 3; i++) {
+      voxel(i) = std::min(
+        std::max((int)std::floor((p(i) - origin_(i)) / resolution_), 0),
+        dims_(i) - 1);
+      step(i) = dir(i) > 0.0 ? 1 : -1;
+      if (dir(i) == 0.0) {
+        t_max(i) = t_delta(i) = std::numeric_limits<Scalar>::infinity();
+        continue;
+      }
+      const Scalar boundary =
+        origin_(i) + (voxel(i) + (dir(i) > 0.0)) * resolution_;
+      t_max(i) = t + (boundary - p(i)) / dir(i);
+      t_delta(i) = resolution_ / std::abs(dir(i));
+    }
+
+    Scalar t_voxel = t;
+    bool skipped = false;
+    while (t_voxel <= t_exit) {
+      const int64_t i = voxel.cast<int64_t>().dot(strides_);
+      if (collision_[i]) {
+        if (t_collision != nullptr) *t_collision = t_voxel / length;
+        return true;
+      }
+      if (!esdf_.empty() && esdf_[i] > skip_offset) {
+        t = t_voxel + esdf_[i] - skip_offset;
+        skipped = true;
+        break;
+      }
+      int axis;
+      t_max.minCoeff(&axis);
+      t_voxel = t_max(axis);
+      voxel(axis) += step(axis);
+      if (voxel(axis) < 0 || voxel(axis) >= dims_(axis)) return false;
+      t_max(axis) += t_delta(axis);
+    }
+    if (!skipped) break;
+  }
+  return false;
+}
+
+bool VoxelGrid::contains(const Ref<const Vector<3>> point) const {
+  return index(point) >= 0;
+}
+
+int64_t VoxelGrid::index(const Ref<const Vector<3>> point) const {
+  int64_t i = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    const Scalar v = std::floor((point(axis) - origin_(axis)) / resolution_);
+    if (!(v >= 0.0) || v >= dims_(axis)) return -1;
+    i += (int64_t)v * strides_(axis);
+  }
+  return i;
+}
+
+void VoxelGrid::distanceTransform(const std::vector<Scalar>& f, const int n,
+                                  std::vector<Scalar>& d, std::vector<int>& v,
+                                  std::vector<Scalar>& z) {
+  // lower envelope of the parabolas rooted at (q, f(q))
+  int k = 0;
+  v[0] = 0;
+  z[0] = -kFar;
+  z[1] = kFar;
+  for (int q = 1; q < n; q++) {
+    Scalar s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+    while (s <= z[k]) {
+      k--;
+      s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = kFar;
+  }
+  k = 0;
+  for (int q = 0; q < n; q++) {
+    while (z[k + 1] < q) k++;
+    const Scalar dq = q - v[k];
+    d[q] = dq * dq + f[v[k]];
+  }
+}
+
+void VoxelGrid::transformAxis(std::vector<Scalar>& grid, const int axis) const {
+  const int n = dims_(axis);
+  const int a1 = (axis + 1) % 3, a2 = (axis + 2) % 3;
+  const int64_t num_lines = (int64_t)dims_(a1) * dims_(a2);
+#pragma omp parallel
+  {
+    std::vector<Scalar> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+#pragma omp for
+    for (int64_t line = 0; line < num_lines; line++) {
+      const int64_t base = (int64_t)(line % dims_(a1)) * strides_(a1) +
+                           (int64_t)(line / dims_(a1)) * strides_(a2);
+      for (int q = 0; q < n; q++) f[q] = grid[base + (int64_t)q * strides_(axis)];
+      distanceTransform(f, n, d, v, z);
+      for (int q = 0; q < n; q++)
+        grid[base + (int64_t)q * strides_(axis)] = std::min(d[q], kFar);
+    }
+  }
+}
+
+void VoxelGrid::dilateAxis(std::vector<uint8_t>& layer, const int axis,
+                           const int radius) const {
+  const int n = dims_(axis);
+  const int a1 = (axis + 1) % 3, a2 = (axis + 2) % 3;
+  const int64_t num_lines = (int64_t)dims_(a1) * dims_(a2);
+#pragma omp parallel
+  {
+    std::vector<uint8_t> line_in(n);
+#pragma omp for
+    for (int64_t line = 0; line < num_lines; line++) {
+      const int64_t base = (int64_t)(line % dims_(a1)) * strides_(a1) +
+                           (int64_t)(line / dims_(a1)) * strides_(a2);
+      for (int q = 0; q < n; q++)
+        line_in[q] = layer[base + (int64_t)q * strides_(axis)];
+      // sliding window count of occupied voxels in [q - radius, q + radius]
+      int count = 0;
+      for (int q = 0; q < std::min(radius, n); q++) count += line_in[q];
+      for (int q = 0; q < n; q++) {
+        if (q + radius < n) count += line_in[q + radius];
+        if (q - radius - 1 >= 0) count -= line_in[q - radius - 1];
+        layer[base + (int64_t)q * strides_(axis)] = count > 0;
+      }
+    }
+  }
+}
+
+}  // namespace flightlib
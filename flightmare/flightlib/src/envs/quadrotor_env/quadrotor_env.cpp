@@ -41,6 +41,7 @@ QuadrotorEnv::QuadrotorEnv(const std::string &cfg_path)
 
   // load parameters
   loadParam(cfg_);
+  loadCameraParam(cfg_);
 }
 
 QuadrotorEnv::~QuadrotorEnv() {}
@@ -169,6 +170,34 @@ bool QuadrotorEnv::loadParam(const YAML::Node &cfg) {
   return true;
 }
 
+bool QuadrotorEnv::loadCameraParam(const YAML::Node &cfg) {
+  if (!cfg["quadrotor_env"] || !cfg["quadrotor_env"]["camera"] ||
+      !cfg["quadrotor_env"]["camera"].as<bool>())
+    return false;
+
+  rgb_camera_ = std::make_shared<RGBCamera>();
+  if (cfg["rgb_camera"]) {
+    const YAML::Node &cam_cfg = cfg["rgb_camera"];
+    rgb_camera_->setWidth(cam_cfg["width"].as<int>());
+    rgb_camera_->setHeight(cam_cfg["height"].as<int>());
+    rgb_camera_->setFOV(cam_cfg["fov"].as<Scalar>());
+    // depth, segmentation, optical flow
+    rgb_camera_->setPostProcesscing(std::vector<bool>{
+      cam_cfg["depth"].as<bool>(), cam_cfg["segmentation"].as<bool>(),
+      cam_cfg["optical_flow"].as<bool>()});
+  }
+  Vector<3> B_r_BC(0.0, 0.0, 0.3);
+  Matrix<3, 3> R_BC = Quaternion(1.0, 0.0, 0.0, 0.0).toRotationMatrix();
+  rgb_camera_->setRelPose(B_r_BC, R_BC);
+  quadrotor_ptr_->addRGBCamera(rgb_camera_);
+  return true;
+}
+
+const cv::Mat *QuadrotorEnv::peekImage(const int image_layer) const {
+  if (rgb_camera_ == nullptr) return nullptr;
+  return rgb_camera_->peekImage(image_layer);
+}
+
 bool QuadrotorEnv::getAct(Ref<Vector<>> act) const {
   if (cmd_.t >= 0.0 && quad_act_.allFinite()) {
     act = quad_act_;
@@ -35,13 +35,31 @@ void VecEnv<EnvBase>::init(void) {
   num_envs_ = cfg_["env"]["num_envs"].as<int>();
   scene_id_ = cfg_["env"]["scene_id"].as<SceneID>();
 
+  // image tensor export (optional)
+  if (cfg_["env"]["image_downsample"]) {
+    image_downsample_ = cfg_["env"]["image_downsample"].as<int>();
+  }
+  if (cfg_["env"]["image_grayscale"]) {
+    image_grayscale_ = cfg_["env"]["image_grayscale"].as<bool>();
+  }
+
   // set threads
   omp_set_num_threads(cfg_["env"]["num_threads"].as<int>());
 
   // create & setup environments
   const bool render = false;
-  for (int i = 0; i < num_envs_; i++) {
-    envs_.push_back(std::make_unique<EnvBase>());
+  if (cfg_["env"]["env_cfg"]) {
+    // configuration of the single environments, e.g. one with the camera on
+    const std::string env_cfg_path =
+      getenv("FLIGHTMARE_PATH") + std::string("/flightlib/configs/") +
+      cfg_["env"]["env_cfg"].as<std::string>();
+    for (int i = 0; i < num_envs_; i++) {
+      envs_.push_back(std::make_unique<EnvBase>(env_cfg_path));
+    }
+  } else {
+    for (int i = 0; i < num_envs_; i++) {
+      envs_.push_back(std::make_unique<EnvBase>());
+    }
   }
 
   // set Unity
@@ -131,6 +149,82 @@ void VecEnv<EnvBase>::getObs(Ref<MatrixRowMajor<>> obs) {
 }
 
 
+template<typename EnvBase>
+bool VecEnv<EnvBase>::setImageOutput(const int downsample,
+                                     const bool grayscale) {
+  if (downsample < 1) {
+    logger_.warn("Image downsampling factor has to be >= 1.");
+    return false;
+  }
+  image_downsample_ = downsample;
+  image_grayscale_ = grayscale;
+  return true;
+}
+
+template<typename EnvBase>
+std::vector<int> VecEnv<EnvBase>::getImageShape(const int image_layer) {
+  std::shared_ptr<RGBCamera> camera = envs_[0]->getCamera();
+  if (camera == nullptr) return std::vector<int>{0, 0, 0};
+
+  int channels = camera->getChannels();
+  if (image_layer == CameraLayer::DepthMap || image_grayscale_) channels = 1;
+  return std::vector<int>{camera->getHeight() / image_downsample_,
+                          camera->getWidth() / image_downsample_, channels};
+}
+
+template<typename EnvBase>
+bool VecEnv<EnvBase>::getImages(const int image_layer,
+                                Ref<MatrixRowMajor<>> images) {
+  const std::vector<int> shape = getImageShape(image_layer);
+  if (images.rows() != num_envs_ ||
+      images.cols() != shape[0] * shape[1] * shape[2] || shape[2] == 0) {
+    logger_.error(
+      "Input matrix dimensions do not match with that of the environment.");
+    return false;
+  }
+
+  bool all_valid = true;
+#pragma omp parallel for schedule(dynamic) reduction(&& : all_valid)
+  for (int i = 0; i < num_envs_; i++) {
+    // the row of a row-major matrix is contiguous, so the final conversion
+    // writes straight into the output tensor.
+    cv::Mat out(shape[0], shape[1], CV_MAKETYPE(CV_32F, shape[2]),
+                images.row(i).data());
+    const cv::Mat* frame = envs_[i]->peekImage(image_layer);
+    if (frame == nullptr || frame->empty()) {
+      out.setTo(0.0);
+      all_valid = false;
+      continue;
+    }
+
+    cv::Mat src = *frame;
+    if (src.channels() == 3 && shape[2] == 1) {
+      cv::Mat gray;
+      cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+      src = gray;
+    }
+    if (src.rows != shape[0] || src.cols != shape[1]) {
+      cv::Mat resized;
+      cv::resize(src, resized, cv::Size(shape[1], shape[0]), 0, 0,
+                 cv::INTER_AREA);
+      src = resized;
+    }
+    // convertTo keeps the channels of the source and reallocates the output
+    // instead of failing, which would leave the tensor row unwritten
+    if (src.channels() != shape[2]) {
+      out.setTo(0.0);
+      all_valid = false;
+      continue;
+    }
+    src.convertTo(out, CV_MAKETYPE(CV_32F, shape[2]));
+    if (out.data != (uchar*)images.row(i).data()) {
+      images.row(i).setZero();
+      all_valid = false;
+    }
+  }
+  return all_valid;
+}
+
 template<typename EnvBase>
 size_t VecEnv<EnvBase>::getEpisodeLength(void) {
   if (envs_.size() <= 0) {
@@ -197,6 +291,37 @@ void VecEnv<EnvBase>::disconnectUnity(void) {
   }
 }
 
+template<typename EnvBase>
+bool VecEnv<EnvBase>::getRenderTimingStats(Ref<MatrixRowMajor<>> stats) {
+  if (unity_bridge_ptr_ == nullptr) {
+    logger_.warn("Flightmare Unity Bridge is not initialized.");
+    return false;
+  }
+  const Matrix<> timing = unity_bridge_ptr_->getRenderTimingStats();
+  if (stats.rows() != timing.rows() || stats.cols() != timing.cols()) {
+    logger_.error(
+      "Input matrix dimensions do not match with that of the render timing.");
+    return false;
+  }
+  stats = timing;
+  return true;
+}
+
+template<typename EnvBase>
+std::vector<std::string> VecEnv<EnvBase>::getRenderTimingNames(void) {
+  if (unity_bridge_ptr_ == nullptr) return std::vector<std::string>();
+  return unity_bridge_ptr_->getRenderTimingNames();
+}
+
+template<typename EnvBase>
+void VecEnv<EnvBase>::setRenderTimingLog(const Scalar interval) {
+  if (unity_bridge_ptr_ == nullptr) {
+    logger_.warn("Flightmare Unity Bridge is not initialized.");
+    return;
+  }
+  unity_bridge_ptr_->setTimingLogInterval(interval);
+}
+
 template<typename EnvBase>
 void VecEnv<EnvBase>::curriculumUpdate(void) {
   for (int i = 0; i < num_envs_; i++) envs_[i]->curriculumUpdate();
@@ -73,6 +73,7 @@ bool Quadrotor::run(const Scalar ctl_dt) {
   state_.t += ctl_dt;
   //
   constrainInWorldBox(old_state);
+  dirty_ = true;
   return true;
 }
 
@@ -86,6 +87,7 @@ bool Quadrotor::reset(void) {
   state_.setZero();
   motor_omega_.setZero();
   motor_thrusts_.setZero();
+  dirty_ = true;
   return true;
 }
 
@@ -94,6 +96,7 @@ bool Quadrotor::reset(const QuadState &state) {
   state_ = state;
   motor_omega_.setZero();
   motor_thrusts_.setZero();
+  dirty_ = true;
   return true;
 }
 
@@ -148,6 +151,7 @@ bool Quadrotor::setCommand(const Command &cmd) {
 bool Quadrotor::setState(const QuadState &state) {
   if (!state.valid()) return false;
   state_ = state;
+  dirty_ = true;
   return true;
 }
 
@@ -14,29 +14,30 @@ RGBCamera::~RGBCamera() {}
 
 bool RGBCamera::feedImageQueue(const int image_layer,
                                const cv::Mat& image_mat) {
-  queue_mutex_.lock();
+  RingBuffer<cv::Mat>* queue = getQueue(image_layer);
+  if (queue == nullptr) return false;
+  queue->push(image_mat);
+  return true;
+}
+
+RingBuffer<cv::Mat>* RGBCamera::getQueue(const int image_layer) {
   switch (image_layer) {
     case 0:  // rgb image
-      if (rgb_queue_.size() > queue_size_) rgb_queue_.resize(queue_size_);
-      rgb_queue_.push_back(image_mat);
-      break;
+      return &rgb_queue_;
     case CameraLayer::DepthMap:
-      if (depth_queue_.size() > queue_size_) depth_queue_.resize(queue_size_);
-      depth_queue_.push_back(image_mat);
-      break;
+      return &depth_queue_;
     case CameraLayer::Segmentation:
-      if (segmentation_queue_.size() > queue_size_)
-        segmentation_queue_.resize(queue_size_);
-      segmentation_queue_.push_back(image_mat);
-      break;
+      return &segmentation_queue_;
     case CameraLayer::OpticalFlow:
-      if (opticalflow_queue_.size() > queue_size_)
-        opticalflow_queue_.resize(queue_size_);
-      opticalflow_queue_.push_back(image_mat);
-      break;
+      return &opticalflow_queue_;
   }
-  queue_mutex_.unlock();
-  return true;
+  return nullptr;
+}
+
+const cv::Mat* RGBCamera::peekImage(const int image_layer) {
+  RingBuffer<cv::Mat>* queue = getQueue(image_layer);
+  if (queue == nullptr) return nullptr;
+  return queue->peekLatest();
 }
 
 bool RGBCamera::setRelPose(const Ref<Vector<3>> B_r_BC,
@@ -124,61 +125,45 @@ Scalar RGBCamera::getFOV(void) const { return fov_; }
 
 Scalar RGBCamera::getDepthScale(void) const { return depth_scale_; }
 
+void RGBCamera::enable(const bool on) { enabled_ = on; }
+
+bool RGBCamera::isEnabled(void) const { return enabled_; }
+
 void RGBCamera::enableDepth(const bool on) {
-  if (enabled_layers_[CameraLayer::DepthMap] == on) {
+  if (enabled_layers_[CameraLayer::DepthMap - 1] == on) {
     logger_.warn("Depth layer was already %s.", on ? "on" : "off");
   }
-  enabled_layers_[CameraLayer::DepthMap] = on;
+  enabled_layers_[CameraLayer::DepthMap - 1] = on;
 }
 
 void RGBCamera::enableSegmentation(const bool on) {
-  if (enabled_layers_[CameraLayer::Segmentation] == on) {
+  if (enabled_layers_[CameraLayer::Segmentation - 1] == on) {
     logger_.warn("Segmentation layer was already %s.", on ? "on" : "off");
   }
-  enabled_layers_[CameraLayer::Segmentation] = on;
+  enabled_layers_[CameraLayer::Segmentation - 1] = on;
 }
 
 void RGBCamera::enableOpticalFlow(const bool on) {
-  if (enabled_layers_[CameraLayer::OpticalFlow] == on) {
+  if (enabled_layers_[CameraLayer::OpticalFlow - 1] == on) {
     logger_.warn("Optical Flow layer was already %s.", on ? "on" : "off");
   }
-  enabled_layers_[CameraLayer::OpticalFlow] = on;
+  enabled_layers_[CameraLayer::OpticalFlow - 1] = on;
 }
 
 bool RGBCamera::getRGBImage(cv::Mat& rgb_img) {
-  if (!rgb_queue_.empty()) {
-    rgb_img = rgb_queue_.front();
-    rgb_queue_.pop_front();
-    return true;
-  }
-  return false;
+  return rgb_queue_.popLatest(rgb_img);
 }
 
 bool RGBCamera::getDepthMap(cv::Mat& depth_map) {
-  if (!depth_queue_.empty()) {
-    depth_map = depth_queue_.front();
-    depth_queue_.pop_front();
-    return true;
-  }
-  return false;
+  return depth_queue_.popLatest(depth_map);
 }
 
 bool RGBCamera::getSegmentation(cv::Mat& segmentation) {
-  if (!segmentation_queue_.empty()) {
-    segmentation = segmentation_queue_.front();
-    segmentation_queue_.pop_front();
-    return true;
-  }
-  return false;
+  return segmentation_queue_.popLatest(segmentation);
 }
 
 bool RGBCamera::getOpticalFlow(cv::Mat& opticalflow) {
-  if (!opticalflow_queue_.empty()) {
-    opticalflow = opticalflow_queue_.front();
-    opticalflow_queue_.pop_front();
-    return true;
-  }
-  return false;
+  return opticalflow_queue_.popLatest(opticalflow);
 }
 
 }  // namespace flightlib
\ No newline at end of file
@@ -22,11 +22,17 @@ PYBIND11_MODULE(flightgym, m) {
     .def("step", &VecEnv<QuadrotorEnv>::step)
     .def("testStep", &VecEnv<QuadrotorEnv>::testStep)
     .def("setSeed", &VecEnv<QuadrotorEnv>::setSeed)
+    .def("setImageOutput", &VecEnv<QuadrotorEnv>::setImageOutput)
+    .def("getImages", &VecEnv<QuadrotorEnv>::getImages)
+    .def("getImageShape", &VecEnv<QuadrotorEnv>::getImageShape)
     .def("close", &VecEnv<QuadrotorEnv>::close)
     .def("isTerminalState", &VecEnv<QuadrotorEnv>::isTerminalState)
     .def("curriculumUpdate", &VecEnv<QuadrotorEnv>::curriculumUpdate)
     .def("connectUnity", &VecEnv<QuadrotorEnv>::connectUnity)
     .def("disconnectUnity", &VecEnv<QuadrotorEnv>::disconnectUnity)
+    .def("getRenderTimingStats", &VecEnv<QuadrotorEnv>::getRenderTimingStats)
+    .def("getRenderTimingNames", &VecEnv<QuadrotorEnv>::getRenderTimingNames)
+    .def("setRenderTimingLog", &VecEnv<QuadrotorEnv>::setRenderTimingLog)
     .def("getNumOfEnvs", &VecEnv<QuadrotorEnv>::getNumOfEnvs)
     .def("getObsDim", &VecEnv<QuadrotorEnv>::getObsDim)
     .def("getActDim", &VecEnv<QuadrotorEnv>::getActDim)
@@ -0,0 +1,62 @@
+#include "flightlib/common/ring_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "flightlib/common/logger.hpp"
+#include "flightlib/common/timer.hpp"
+
+using namespace flightlib;
+
+static constexpr int NUM_FRAMES = 200000;
+
+TEST(RingBuffer, ContentionBenchmark) {
+  Logger logger("RingBuffer");
+
+  // baseline: the mutex protected deque used by the RGBCamera before
+  std::mutex queue_mutex;
+  std::deque<std::shared_ptr<int>> queue;
+  Timer timer_mutex("mutex deque", "RingBuffer");
+  timer_mutex.tic();
+  std::thread mutex_producer([&]() {
+    for (int i = 0; i < NUM_FRAMES; i++) {
+      std::shared_ptr<int> frame = std::make_shared<int>(i);
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      if (queue.size() >= 2) queue.pop_front();
+      queue.push_back(frame);
+    }
+  });
+  int last = -1;
+  while (last < NUM_FRAMES - 1) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    if (!queue.empty()) {
+      last = *queue.back();
+      queue.clear();
+    }
+  }
+  mutex_producer.join();
+  timer_mutex.toc();
+
+  RingBuffer<std::shared_ptr<int>> buffer(2);
+  Timer timer_ring("ring buffer", "RingBuffer");
+  timer_ring.tic();
+  std::thread ring_producer([&]() {
+    for (int i = 0; i < NUM_FRAMES; i++) buffer.push(std::make_shared<int>(i));
+  });
+  last = -1;
+  std::shared_ptr<int> item;
+  while (last < NUM_FRAMES - 1) {
+    if (buffer.popLatest(item)) last = *item;
+  }
+  ring_producer.join();
+  timer_ring.toc();
+
+  logger << timer_mutex << timer_ring;
+  logger.info("%d frames, %lu dropped by the ring buffer.", NUM_FRAMES,
+              buffer.numDropped());
+  EXPECT_EQ(last, NUM_FRAMES - 1);
+}
@@ -216,3 +216,67 @@ TEST(UnityBridge, Spawn100StaticGate) {
   // timeout flightmare
   usleep(5 * 1e6);
 }
+
+TEST(UnityBridge, DeltaUpdates) {
+  UnityBridge unity_bridge;
+  QuadrotorDynamics dyn = QuadrotorDynamics(1.0, 0.2);
+  std::shared_ptr<Quadrotor> quad = std::make_shared<Quadrotor>(dyn);
+  QuadState state;
+  state.setZero();
+  quad->setState(state);
+  unity_bridge.addQuadrotor(quad);
+  std::shared_ptr<StaticGate> gate = std::make_shared<StaticGate>("unity_gate");
+  unity_bridge.addStaticObject(gate);
+
+  // full messages do not carry the keyframe flag unless delta updates are on
+  json pub_json = PubMessage_t();
+  EXPECT_EQ(pub_json.count("keyframe"), 0);
+
+  EXPECT_FALSE(unity_bridge.setDeltaUpdates(true, 0));
+  EXPECT_TRUE(unity_bridge.setDeltaUpdates(true, 3));
+
+  // the first frame is a keyframe and sends everything
+  EXPECT_TRUE(unity_bridge.getRender(1));
+  EXPECT_FALSE(quad->isDirty());
+  EXPECT_FALSE(gate->isDirty());
+
+  // only the moved gate is sent, matched by its ID
+  gate->setPosition(Vector<3>(1.0, 2.0, 3.0));
+  EXPECT_TRUE(unity_bridge.getRender(2));
+  const DeltaPubMessage_t& delta_msg = unity_bridge.getDeltaMessage();
+  EXPECT_EQ(delta_msg.frame_id, 2);
+  EXPECT_TRUE(delta_msg.vehicles.empty());
+  ASSERT_EQ(delta_msg.objects.size(), 1);
+  EXPECT_EQ(delta_msg.objects[0].ID, "unity_gate");
+  // unity coordinates, y up
+  EXPECT_EQ(delta_msg.objects[0].position,
+            std::vector<Scalar>({1.0, 3.0, 2.0}));
+  EXPECT_FALSE(gate->isDirty());
+
+  json delta_json = delta_msg;
+  EXPECT_FALSE(delta_json.at("keyframe").get<bool>());
+  EXPECT_EQ(delta_json.at("objects").size(), 1);
+
+  // nothing changed
+  EXPECT_TRUE(unity_bridge.getRender(3));
+  EXPECT_EQ(delta_msg.frame_id, 3);
+  EXPECT_TRUE(delta_msg.vehicles.empty());
+  EXPECT_TRUE(delta_msg.objects.empty());
+
+  // the next keyframe is due, the delta message is left untouched
+  state.x[QS::POSX] = 1.0;
+  quad->setState(state);
+  EXPECT_TRUE(unity_bridge.getRender(4));
+  EXPECT_EQ(delta_msg.frame_id, 3);
+  EXPECT_FALSE(quad->isDirty());
+
+  // only the moved quadrotor is sent
+  state.x[QS::POSX] = 2.0;
+  quad->setState(state);
+  EXPECT_TRUE(unity_bridge.getRender(5));
+  EXPECT_EQ(delta_msg.frame_id, 5);
+  ASSERT_EQ(delta_msg.vehicles.size(), 1);
+  EXPECT_EQ(delta_msg.vehicles[0].ID, "quadrotor0");
+  EXPECT_EQ(delta_msg.vehicles[0].position[0], 2.0);
+  EXPECT_TRUE(delta_msg.objects.empty());
+}
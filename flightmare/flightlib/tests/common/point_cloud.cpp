@@ -0,0 +1,43 @@
+#include "flightlib/common/point_cloud.hpp"
+
+#include <gtest/gtest.h>
+
+#include "flightlib/common/types.hpp"
+
+using namespace flightlib;
+
+TEST(PointCloud, Constructor) {
+  PointCloud point_cloud;
+  EXPECT_TRUE(point_cloud.empty());
+  EXPECT_EQ(point_cloud.size(), 0);
+
+  Vector<3> min_bounds, max_bounds;
+  EXPECT_FALSE(point_cloud.getBounds(min_bounds, max_bounds));
+}
+
+TEST(PointCloud, AppendChunks) {
+  const int num_points = 1000;
+  Matrix<3, Dynamic> expected = Matrix<3, Dynamic>::Random(3, num_points);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(expected.data());
+  const size_t num_bytes = sizeof(float) * 3 * num_points;
+
+  // feed the data in chunks that split points across chunk borders
+  PointCloud point_cloud;
+  point_cloud.reset(num_points);
+  const size_t chunk_size = 1001;
+  for (size_t offset = 0; offset < num_bytes; offset += chunk_size) {
+    const size_t len = std::min(chunk_size, num_bytes - offset);
+    EXPECT_TRUE(point_cloud.appendChunk(bytes + offset, len));
+  }
+
+  EXPECT_EQ(point_cloud.size(), num_points);
+  EXPECT_TRUE(point_cloud.points().isApprox(expected));
+
+  Vector<3> min_bounds, max_bounds;
+  EXPECT_TRUE(point_cloud.getBounds(min_bounds, max_bounds));
+  EXPECT_TRUE(min_bounds.isApprox(expected.rowwise().minCoeff()));
+  EXPECT_TRUE(max_bounds.isApprox(expected.rowwise().maxCoeff()));
+
+  point_cloud.reset();
+  EXPECT_TRUE(point_cloud.empty());
+}
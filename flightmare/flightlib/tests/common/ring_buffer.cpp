@@ -0,0 +1,106 @@
+#include "flightlib/common/ring_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+using namespace flightlib;
+
+static constexpr int NUM_FRAMES = 5000;
+
+TEST(RingBuffer, Constructor) {
+  RingBuffer<int> buffer0;
+  EXPECT_EQ(buffer0.capacity(), 2);
+  EXPECT_TRUE(buffer0.empty());
+
+  RingBuffer<int> buffer1(5);
+  EXPECT_EQ(buffer1.capacity(), 8);
+
+  int item;
+  EXPECT_FALSE(buffer1.pop(item));
+  EXPECT_FALSE(buffer1.popLatest(item));
+  EXPECT_EQ(buffer1.peekLatest(), nullptr);
+}
+
+TEST(RingBuffer, LatestFrameWins) {
+  RingBuffer<int> buffer(4);
+  for (int i = 0; i < 10; i++) buffer.push(i);
+
+  // the oldest elements have been dropped, not the newest
+  EXPECT_EQ(buffer.size(), 4);
+  EXPECT_EQ(buffer.numDropped(), 6);
+
+  int item;
+  EXPECT_TRUE(buffer.pop(item));
+  EXPECT_EQ(item, 6);
+  EXPECT_TRUE(buffer.popLatest(item));
+  EXPECT_EQ(item, 9);
+  EXPECT_FALSE(buffer.popLatest(item));
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(RingBuffer, PeekLatest) {
+  RingBuffer<std::shared_ptr<int>> buffer(2);
+  buffer.push(std::make_shared<int>(1));
+  buffer.push(std::make_shared<int>(2));
+
+  const std::shared_ptr<int>* latest = buffer.peekLatest();
+  ASSERT_NE(latest, nullptr);
+  EXPECT_EQ(**latest, 2);
+  // peeking does not copy the element
+  EXPECT_EQ(latest->use_count(), 1);
+
+  // peeking does not consume the frame
+  std::shared_ptr<int> item;
+  EXPECT_TRUE(buffer.popLatest(item));
+  EXPECT_EQ(*item, 2);
+  EXPECT_FALSE(buffer.popLatest(item));
+
+  // the last frame can still be peeked after it was consumed
+  latest = buffer.peekLatest();
+  ASSERT_NE(latest, nullptr);
+  EXPECT_EQ(**latest, 2);
+}
+
+TEST(RingBuffer, ConcurrentProducerConsumer) {
+  RingBuffer<std::shared_ptr<int>> buffer(2);
+
+  std::thread producer([&buffer]() {
+    for (int i = 0; i < NUM_FRAMES; i++) buffer.push(std::make_shared<int>(i));
+  });
+
+  // frames arrive strictly in order and the newest frame is never lost
+  int last = -1;
+  std::shared_ptr<int> item;
+  while (last < NUM_FRAMES - 1) {
+    if (buffer.popLatest(item)) {
+      EXPECT_GT(*item, last);
+      last = *item;
+    }
+  }
+  producer.join();
+  EXPECT_EQ(last, NUM_FRAMES - 1);
+}
+
+TEST(RingBuffer, ConcurrentDropOldest) {
+  RingBuffer<int> buffer(2);
+
+  std::thread producer([&buffer]() {
+    for (int i = 0; i < NUM_FRAMES; i++) buffer.push(i);
+  });
+
+  // every frame is either popped in order or dropped, never both
+  int last = -1;
+  int num_popped = 0;
+  int item;
+  while (last < NUM_FRAMES - 1) {
+    if (buffer.pop(item)) {
+      EXPECT_GT(item, last);
+      last = item;
+      num_popped++;
+    }
+  }
+  producer.join();
+  EXPECT_EQ(num_popped + (int)buffer.numDropped(), NUM_FRAMES);
+}
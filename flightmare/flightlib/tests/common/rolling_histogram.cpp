@@ -0,0 +1,50 @@
+#include "flightlib/common/rolling_histogram.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace flightlib;
+
+TEST(RollingHistogram, Constructor) {
+  RollingHistogram hist("test", 10);
+  EXPECT_EQ(hist.count(), 0);
+  EXPECT_EQ(hist.name(), "test");
+  EXPECT_EQ(hist.mean(), 0.0);
+  EXPECT_EQ(hist.percentile(50), 0.0);
+}
+
+TEST(RollingHistogram, RollingWindow) {
+  RollingHistogram hist("test", 10);
+  for (int i = 0; i < 20; i++) hist.add(i);
+
+  // only the last 10 samples are kept
+  EXPECT_EQ(hist.count(), 10);
+  EXPECT_EQ(hist.last(), 19);
+  EXPECT_EQ(hist.min(), 10);
+  EXPECT_EQ(hist.max(), 19);
+  EXPECT_NEAR(hist.mean(), 14.5, 1e-5);
+  EXPECT_EQ(hist.percentile(0), 10);
+  EXPECT_EQ(hist.percentile(100), 19);
+
+  const std::vector<int> bins = hist.histogram(4, 20.0);
+  EXPECT_EQ(bins.size(), 4);
+  EXPECT_EQ(bins[0] + bins[1], 0);
+  EXPECT_EQ(bins[2], 5);
+  EXPECT_EQ(bins[3], 5);
+
+  hist.reset();
+  EXPECT_EQ(hist.count(), 0);
+}
+
+TEST(RollingHistogram, PercentileBounds) {
+  RollingHistogram hist("test", 10);
+  hist.add(1.0);
+  EXPECT_EQ(hist.percentile(100), 1.0);
+
+  for (int i = 2; i <= 5; i++) hist.add(i);
+  EXPECT_EQ(hist.percentile(100), 5.0);
+  EXPECT_EQ(hist.percentile(150), 5.0);
+  EXPECT_EQ(hist.percentile(-10), 1.0);
+  EXPECT_EQ(hist.percentile(std::nan("")), 1.0);
+}
@@ -0,0 +1,153 @@
+#include "flightlib/common/voxel_grid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace flightlib;
+
+static constexpr Scalar RESOLUTION = 0.1;
+
+TEST(VoxelGrid, Occupancy) {
+  VoxelGrid grid;
+  Matrix<3, Dynamic> points(3, 2);
+  points.col(0) << 0.0, 0.0, 0.0;
+  points.col(1) << 1.0, 2.0, 3.0;
+  EXPECT_FALSE(grid.build(points, 0.0));
+  ASSERT_TRUE(grid.build(points, RESOLUTION, 0.5));
+
+  EXPECT_TRUE(grid.isOccupied(Vector<3>(0.0, 0.0, 0.0)));
+  EXPECT_TRUE(grid.isOccupied(Vector<3>(1.0, 2.0, 3.0)));
+  EXPECT_FALSE(grid.isOccupied(Vector<3>(0.5, 0.5, 0.5)));
+
+  // outside of the grid is free
+  EXPECT_FALSE(grid.contains(Vector<3>(-1.0, 0.0, 0.0)));
+  EXPECT_FALSE(grid.isOccupied(Vector<3>(-1.0, 0.0, 0.0)));
+  EXPECT_FALSE(grid.isInCollision(Vector<3>(-1.0, 0.0, 0.0)));
+}
+
+TEST(VoxelGrid, MaxVoxels) {
+  VoxelGrid grid;
+  Matrix<3, Dynamic> points(3, 2);
+  points.col(0) << 0.0, 0.0, 0.0;
+  points.col(1) << 1.0, 1.0, 1.0;
+  // 11 x 11 x 11 voxels
+  ASSERT_TRUE(grid.build(points, RESOLUTION, 0.0, 2000));
+  EXPECT_EQ(grid.size(), 1331);
+  EXPECT_FALSE(grid.build(points, RESOLUTION, 0.0, 1000));
+  // the previous grid is kept
+  EXPECT_EQ(grid.size(), 1331);
+  EXPECT_TRUE(grid.isOccupied(Vector<3>(1.0, 1.0, 1.0)));
+
+  // bounds whose voxel count overflows 32 and 64 bit integers
+  points.col(1) << 1e4, 1e4, 1e4;
+  EXPECT_FALSE(grid.build(points, RESOLUTION));
+  points.col(1) << 1e9, 1e9, 1e9;
+  EXPECT_FALSE(grid.build(points, 1e-3, 0.0,
+                          std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(grid.size(), 1331);
+}
+
+TEST(VoxelGrid, Inflate) {
+  VoxelGrid grid;
+  Matrix<3, Dynamic> points = Matrix<3, Dynamic>::Zero(3, 1);
+  ASSERT_TRUE(grid.build(points, RESOLUTION, 1.0));
+  ASSERT_TRUE(grid.inflate(Vector<3>(0.3, 0.0, 0.5)));
+
+  // a box around the origin collides
+  EXPECT_TRUE(grid.isInCollision(Vector<3>(0.25, 0.0, 0.0)));
+  EXPECT_TRUE(grid.isInCollision(Vector<3>(-0.25, 0.0, 0.45)));
+  EXPECT_FALSE(grid.isInCollision(Vector<3>(0.0, 0.15, 0.0)));
+  EXPECT_FALSE(grid.isInCollision(Vector<3>(0.0, 0.0, 0.75)));
+  // the raw occupancy is kept
+  EXPECT_FALSE(grid.isOccupied(Vector<3>(0.25, 0.0, 0.0)));
+}
+
+TEST(VoxelGrid, ESDF) {
+  VoxelGrid grid;
+  // wall in the x = 0 plane and a single point
+  Matrix<3, Dynamic> points(3, 21 * 21 + 1);
+  int n = 0;
+  for (int y = -10; y <= 10; y++) {
+    for (int z = -10; z <= 10; z++) {
+      points.col(n++) << 0.0, y * RESOLUTION, z * RESOLUTION;
+    }
+  }
+  points.col(n++) << 2.0, 0.0, 0.0;
+  ASSERT_TRUE(grid.build(points, RESOLUTION, 0.0));
+  ASSERT_TRUE(grid.computeESDF());
+  ASSERT_TRUE(grid.hasESDF());
+
+  const Scalar eps = 1e-3;
+  EXPECT_NEAR(grid.getDistance(Vector<3>(0.55, 0.05, 0.05)), 0.5, eps);
+  EXPECT_NEAR(grid.getDistance(Vector<3>(0.85, 0.05, 0.05)), 0.8, eps);
+  EXPECT_NEAR(grid.getDistance(Vector<3>(1.65, 0.35, 0.45)),
+              RESOLUTION * std::sqrt(4 * 4 + 3 * 3 + 4 * 4), eps);
+  // inside obstacles the distance is negative
+  EXPECT_LT(grid.getDistance(Vector<3>(0.05, 0.05, 0.05)), 0.0);
+
+  // brute force comparison
+  for (int i = 0; i < 200; i++) {
+    const Vector<3> query = Vector<3>::Random().cwiseAbs() * 2.0;
+    if (!grid.contains(query) || grid.isOccupied(query)) continue;
+    const Scalar distance = grid.getDistance(query);
+    Scalar brute = 1e9;
+    for (int j = 0; j < n; j++) {
+      // distance between voxel centers
+      Vector<3> a, b;
+      for (int k = 0; k < 3; k++) {
+        a(k) = std::floor((query(k) - grid.getOrigin()(k)) / RESOLUTION);
+        b(k) = std::floor((points(k, j) - grid.getOrigin()(k)) / RESOLUTION);
+      }
+      brute = std::min(brute, RESOLUTION * (a - b).norm());
+    }
+    EXPECT_NEAR(distance, brute, eps);
+  }
+}
+
+TEST(VoxelGrid, Segment) {
+  VoxelGrid grid;
+  // thin wall in the x = 1 plane
+  Matrix<3, Dynamic> points(3, 41 * 41);
+  int n = 0;
+  for (int y = -20; y <= 20; y++) {
+    for (int z = -20; z <= 20; z++) {
+      points.col(n++) << 1.0, y * RESOLUTION, z * RESOLUTION;
+    }
+  }
+  ASSERT_TRUE(grid.build(points, RESOLUTION, 2.0));
+  ASSERT_TRUE(grid.inflate(Vector<3>::Constant(0.2)));
+
+  // both end points are free, the wall in between is not
+  const Vector<3> start(-0.5, 0.0, 0.0), end(2.5, 0.3, 0.0);
+  EXPECT_FALSE(grid.isInCollision(start));
+  EXPECT_FALSE(grid.isInCollision(end));
+  Scalar t_collision = -1.0;
+  EXPECT_TRUE(grid.isInCollision(start, end, &t_collision));
+  EXPECT_NEAR(t_collision, (0.8 - start.x()) / (end.x() - start.x()), 0.01);
+  EXPECT_FALSE(grid.isInCollision(start, Vector<3>(0.5, 1.0, 0.0)));
+  // above the wall and outside of the grid
+  EXPECT_FALSE(grid.isInCollision(Vector<3>(-0.5, 0.0, 2.5),
+                                  Vector<3>(2.5, 0.0, 2.5)));
+  EXPECT_FALSE(grid.isInCollision(Vector<3>(-10.0, 0.0, 0.0),
+                                  Vector<3>(-9.0, 0.0, 0.0)));
+  EXPECT_TRUE(grid.isInCollision(Vector<3>(-10.0, 0.0, 0.0),
+                                 Vector<3>(10.0, 0.0, 0.0)));
+
+  // skipping through free space with the ESDF gives the same answers, and
+  // never misses collisions of densely sampled points
+  VoxelGrid grid_esdf = grid;
+  ASSERT_TRUE(grid_esdf.computeESDF());
+  for (int i = 0; i < 500; i++) {
+    const Vector<3> a = Vector<3>::Random() * 3.0;
+    const Vector<3> b = Vector<3>::Random() * 3.0;
+    const bool collision = grid.isInCollision(a, b);
+    EXPECT_EQ(grid_esdf.isInCollision(a, b), collision);
+    bool sampled = false;
+    for (int k = 0; k <= 1000 && !sampled; k++) {
+      sampled = grid.isInCollision(Vector<3>(a + (b - a) * (k / 1000.0)));
+    }
+    if (sampled) EXPECT_TRUE(collision);
+  }
+}
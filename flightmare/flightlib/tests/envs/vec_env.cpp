@@ -150,4 +150,80 @@ TEST(VecEnv, StepEnv) {
   done.resize(num_envs);
   extra_info.resize(num_envs, extra_info_names.size() + 1);
   EXPECT_FALSE(vec_env.step(act, obs, reward, done, extra_info));
-}
\ No newline at end of file
+}
+
+TEST(VecEnv, GetImages) {
+  std::string config_path =
+    getenv("FLIGHTMARE_PATH") + std::string("/flightlib/configs/vec_env.yaml");
+  YAML::Node cfg = YAML::LoadFile(config_path);
+  // the onboard camera is off in the default quadrotor_env.yaml
+  EXPECT_EQ(VecEnv<QuadrotorEnv>(cfg).getImageShape(0)[0], 0);
+
+  cfg["env"]["env_cfg"] = "quadrotor_env_camera.yaml";
+  VecEnv<QuadrotorEnv> vec_env(cfg);
+  const int num_envs = vec_env.getNumOfEnvs();
+
+  std::vector<int> shape = vec_env.getImageShape(0);
+  ASSERT_EQ(shape.size(), 3);
+  const int height = shape[0], width = shape[1];
+  ASSERT_GT(height, 0);
+  ASSERT_GT(width, 0);
+  EXPECT_EQ(shape[2], 3);
+
+  // test dimension failure case
+  MatrixRowMajor<> images(num_envs, 1);
+  EXPECT_FALSE(vec_env.getImages(0, images));
+
+  // no frame has been rendered yet
+  images.resize(num_envs, height * width * 3);
+  images.setConstant(-1.0);
+  EXPECT_FALSE(vec_env.getImages(0, images));
+  EXPECT_EQ(images.maxCoeff(), 0.0);
+
+  // constant 2x2 blocks with a different value per env, identical in all
+  // channels except for the red one
+  for (int i = 0; i < num_envs; i++) {
+    cv::Mat frame(height, width, CV_8UC3);
+    for (int r = 0; r < height; r++) {
+      for (int c = 0; c < width; c++) {
+        const uchar value = (r / 2 + c / 2 + i) % 200;
+        frame.at<cv::Vec3b>(r, c) = cv::Vec3b(value, value, value + 50);
+      }
+    }
+    EXPECT_TRUE(vec_env.getEnv(i).getCamera()->feedImageQueue(0, frame));
+  }
+
+  EXPECT_TRUE(vec_env.getImages(0, images));
+  for (int i = 0; i < num_envs; i++) {
+    for (int r = 0; r < height; r++) {
+      for (int c = 0; c < width; c++) {
+        const Scalar value = (r / 2 + c / 2 + i) % 200;
+        const int idx = (r * width + c) * 3;
+        ASSERT_EQ(images(i, idx), value);
+        ASSERT_EQ(images(i, idx + 1), value);
+        ASSERT_EQ(images(i, idx + 2), value + 50);
+      }
+    }
+  }
+
+  // test downsampling failure case
+  EXPECT_FALSE(vec_env.setImageOutput(0, false));
+
+  // grayscale and downsampled by 2, every output pixel is one 2x2 block
+  EXPECT_TRUE(vec_env.setImageOutput(2, true));
+  shape = vec_env.getImageShape(0);
+  EXPECT_EQ(shape[0], height / 2);
+  EXPECT_EQ(shape[1], width / 2);
+  EXPECT_EQ(shape[2], 1);
+  images.resize(num_envs, shape[0] * shape[1]);
+  EXPECT_TRUE(vec_env.getImages(0, images));
+  for (int i = 0; i < num_envs; i++) {
+    for (int r = 0; r < shape[0]; r++) {
+      for (int c = 0; c < shape[1]; c++) {
+        // BGR to gray: 0.114 * B + 0.587 * G + 0.299 * R
+        const Scalar value = (r + c + i) % 200 + 0.299 * 50;
+        ASSERT_NEAR(images(i, r * shape[1] + c), value, 1.0);
+      }
+    }
+  }
+}
@@ -222,3 +222,21 @@ TEST(Quadrotor, RunSimulatorBodyRate) {
   EXPECT_NEAR(final_state.t, quad_state.t, 1e-9);
   EXPECT_TRUE(quad_state.x.isApprox(final_state.x));
 }
+
+TEST(Quadrotor, DirtyFlag) {
+  Quadrotor quad;
+  // a new quadrotor has never been sent to Unity
+  EXPECT_TRUE(quad.isDirty());
+  quad.clearDirty();
+  EXPECT_FALSE(quad.isDirty());
+
+  QuadState quad_state;
+  quad_state.setZero();
+  EXPECT_TRUE(quad.setState(quad_state));
+  EXPECT_TRUE(quad.isDirty());
+
+  quad.clearDirty();
+  Command cmd(0.0, 9.81, Vector<3>::Zero());
+  EXPECT_TRUE(quad.run(cmd, 0.01));
+  EXPECT_TRUE(quad.isDirty());
+}
@@ -0,0 +1,31 @@
+#include "flightlib/objects/static_object.hpp"
+#include "flightlib/objects/static_gate.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace flightlib;
+
+TEST(StaticObject, DirtyFlag) {
+  StaticGate gate("unity_gate");
+  // a new object has never been sent to Unity
+  EXPECT_TRUE(gate.isDirty());
+  gate.clearDirty();
+  EXPECT_FALSE(gate.isDirty());
+
+  // reading the pose does not change it
+  gate.getPosition();
+  gate.getQuaternion();
+  gate.getSize();
+  EXPECT_FALSE(gate.isDirty());
+
+  gate.setPosition(Vector<3>(1.0, 2.0, 3.0));
+  EXPECT_TRUE(gate.isDirty());
+
+  gate.clearDirty();
+  gate.setQuaternion(Quaternion(0.0, 1.0, 0.0, 0.0));
+  EXPECT_TRUE(gate.isDirty());
+
+  gate.clearDirty();
+  gate.setSize(Vector<3>(2.0, 2.0, 2.0));
+  EXPECT_TRUE(gate.isDirty());
+}
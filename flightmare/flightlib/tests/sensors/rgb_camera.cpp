@@ -0,0 +1,25 @@
+#include "flightlib/sensors/rgb_camera.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace flightlib;
+
+TEST(RGBCamera, EnableLayers) {
+  RGBCamera camera;
+  EXPECT_TRUE(camera.isEnabled());
+  EXPECT_EQ(camera.getEnabledLayers(), std::vector<bool>({false, false, false}));
+
+  // layers are [depth, segmentation, optical flow]
+  camera.enableDepth(true);
+  EXPECT_EQ(camera.getEnabledLayers(), std::vector<bool>({true, false, false}));
+  camera.enableOpticalFlow(true);
+  EXPECT_EQ(camera.getEnabledLayers(), std::vector<bool>({true, false, true}));
+  camera.enableSegmentation(true);
+  camera.enableDepth(false);
+  EXPECT_EQ(camera.getEnabledLayers(), std::vector<bool>({false, true, true}));
+
+  camera.enable(false);
+  EXPECT_FALSE(camera.isEnabled());
+  // the layer selection is kept while the camera is disabled
+  EXPECT_EQ(camera.getEnabledLayers(), std::vector<bool>({false, true, true}));
+}
@@ -25,6 +25,7 @@ class FlightEnvVec(VecEnv):
         self._extraInfo = np.zeros([self.num_envs,
                                     len(self._extraInfoNames)], dtype=np.float32)
         self.rewards = [[] for _ in range(self.num_envs)]
+        self._images = {}
 
         self.max_episode_steps = 300
 
@@ -98,6 +99,28 @@ class FlightEnvVec(VecEnv):
     def disconnectUnity(self):
         self.wrapper.disconnectUnity()
 
+    def get_images(self, layer=0):
+        # the C++ side writes every env's latest frame into this buffer in
+        # place; the returned array is a [N, H, W, C] view, not a copy
+        h, w, c = self.wrapper.getImageShape(layer)
+        if self._images.get(layer) is None or \
+                self._images[layer].shape[1] != h * w * c:
+            self._images[layer] = np.zeros([self.num_envs, h * w * c],
+                                           dtype=np.float32)
+        self.wrapper.getImages(layer, self._images[layer])
+        return self._images[layer].reshape(self.num_envs, h, w, c)
+
+    def set_image_output(self, downsample=1, grayscale=False):
+        self.wrapper.setImageOutput(downsample, grayscale)
+
+    def get_render_timing(self):
+        # {stage: [mean, p50, p90, p99, max]} in seconds
+        names = self.wrapper.getRenderTimingNames()
+        stats = np.zeros([len(names), 5], dtype=np.float32)
+        if len(names) == 0 or not self.wrapper.getRenderTimingStats(stats):
+            return {}
+        return {name: stats[i] for i, name in enumerate(names)}
+
     @property
     def num_envs(self):
         return self.wrapper.getNumOfEnvs()
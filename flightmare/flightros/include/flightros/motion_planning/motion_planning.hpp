@@ -1,12 +1,20 @@
 // standard libraries
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <Eigen/Dense>
 #include <cmath>
 #include <cstring>
 #include <experimental/filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <random>
 #include <sstream>
 #include <thread>
 #include <vector>
@@ -17,6 +25,7 @@
 #include <Open3D/IO/ClassIO/PointCloudIO.h>
 
 // OMPL
+#include <ompl/base/MotionValidator.h>
 #include <ompl/base/SpaceInformation.h>
 #include <ompl/base/spaces/SE3StateSpace.h>
 #include <ompl/config.h>
@@ -30,8 +39,11 @@
 // flightlib
 #include "flightlib/bridges/unity_bridge.hpp"
 #include "flightlib/bridges/unity_message_types.hpp"
+#include "flightlib/common/point_cloud.hpp"
 #include "flightlib/common/quad_state.hpp"
+#include "flightlib/common/timer.hpp"
 #include "flightlib/common/types.hpp"
+#include "flightlib/common/voxel_grid.hpp"
 #include "flightlib/objects/quadrotor.hpp"
 #include "flightlib/sensors/rgb_camera.hpp"
 
@@ -60,12 +72,18 @@ struct uint3 {
 struct uint4 {
   uint32_t x, y, z, w;
 };
-std::vector<float3> verts;
 float range = 1;
 bool solution_found = false;
 bool trajectory_found = false;
 
-std::vector<float3> readPointCloud();
+// fill points_ and start building the KD-tree
+bool readPointCloud();
+// zero-copy path for binary little endian PLY files, false if the file
+// layout is not supported
+bool mapPointCloud(const std::string &filepath);
+bool streamPointCloud();
+bool stream_point_cloud_{false};
+bool mmap_point_cloud_{false};
 float3 min_bounds;
 float3 max_bounds;
 
@@ -78,17 +96,83 @@ void getBounds();
 
 void plan();
 
+// planning service: many start/goal queries against the loaded map, solved in
+// parallel with one OMPL setup per worker thread
+struct PlanningQuery {
+  Eigen::Vector3d start;
+  Eigen::Vector3d goal;
+};
+struct PlanningResult {
+  bool solved{false};
+  // waypoints of the simplified path, start and goal included
+  std::vector<Eigen::Vector3d> path;
+  double planning_time{0.0};
+};
+// SE(3) setup over the map bounds with the active collision checker
+og::SimpleSetupPtr createSetup();
+bool solveQuery(og::SimpleSetup &ss, const PlanningQuery &query,
+                const double timeout, PlanningResult &result);
+std::vector<PlanningResult> planQueries(
+  const std::vector<PlanningQuery> &queries, const int num_threads,
+  const double timeout);
+// random collision free start and goal positions within the bounds, false
+// if a state takes more than max_attempts samples (e.g. no free space)
+bool sampleQueries(const int num_queries, std::vector<PlanningQuery> &queries,
+                   const int max_attempts = 10000);
+int num_queries_{0};
+int planning_threads_{0};
+double planning_timeout_{1.0};
+
 bool isStateValid(const ob::State *state);
 
 bool isInRange(float x, float y, float z);
 
 open3d::geometry::KDTreeFlann kd_tree_;
 Eigen::MatrixXd points_;
+// the KD-tree is built in the background while the bounds are computed
+std::future<void> kd_tree_build_;
+void buildKDTree();
+void waitForKDTree();
 bool searchRadius(const Eigen::Vector3d &query_point, const double radius);
 
+// occupancy grid inflated by the drone box and its ESDF, an alternative to
+// the KD-tree radius search for collision checking (opt-in)
+VoxelGrid voxel_grid_;
+bool use_voxel_grid_{false};
+double voxel_resolution_{0.1};
+int max_voxels_{(int)VoxelGrid::kDefaultMaxVoxels};
+bool buildVoxelGrid();
+// compare the KD-tree and the voxel grid on random states in the bounds
+void benchmarkCollision(const int num_samples);
+int collision_benchmark_{0};
+
+// validity from the collision layer, clearance from the ESDF
+class VoxelValidityChecker : public ob::StateValidityChecker {
+ public:
+  explicit VoxelValidityChecker(const ob::SpaceInformationPtr &si)
+    : ob::StateValidityChecker(si) {
+    specs_.clearanceComputationType =
+      ob::StateValidityCheckerSpecs::APPROXIMATE;
+  }
+  bool isValid(const ob::State *state) const override;
+  double clearance(const ob::State *state) const override;
+};
+
+// checks a whole edge in one pass, walking the voxels swept by the drone box
+// instead of interpolating states at a fixed resolution
+class VoxelMotionValidator : public ob::MotionValidator {
+ public:
+  explicit VoxelMotionValidator(const ob::SpaceInformationPtr &si)
+    : ob::MotionValidator(si) {}
+  bool checkMotion(const ob::State *s1, const ob::State *s2) const override;
+  bool checkMotion(const ob::State *s1, const ob::State *s2,
+                   std::pair<ob::State *, double> &last_valid) const override;
+};
+
 void executePath();
 
-// void setupQuad();
+// attach the camera, has to run before the quadrotor is added to Unity
+void setupQuad();
 bool setUnity(const bool render);
 bool connectUnity(void);
 
@@ -2,18 +2,21 @@
 #pragma once
 
 #include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 // ros
 #include <nav_msgs/Odometry.h>
 #include <ros/ros.h>
-#include <tf/transform_broadcaster.h>
-#include <tf/transform_listener.h>
 #include <geometry_msgs/PoseArray.h>
 
 // image
-#include <cv_bridge/cv_bridge.h>
 #include <image_transport/image_transport.h>
+#include <opencv2/imgproc/imgproc.hpp>
 #include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
 
 // rpg quadrotor
 #include <autopilot/autopilot_helper.h>
@@ -24,6 +27,7 @@
 // flightlib
 #include "flightlib/bridges/unity_bridge.hpp"
 #include "flightlib/common/quad_state.hpp"
+#include "flightlib/common/rolling_histogram.hpp"
 #include "flightlib/common/types.hpp"
 #include "flightlib/objects/quadrotor.hpp"
 #include "flightlib/sensors/rgb_camera.hpp"
@@ -39,21 +43,14 @@ public:
     ~FlightPilot();
 
     // callbacks
+    // snapshot poses -> render -> publish with the odometry stamp
     void mainLoopCallback(const ros::TimerEvent& event);
-    void mainRenderCallback(const ros::TimerEvent& event);
-    void poseCallback(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_1(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_2(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_3(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_4(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_5(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_6(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_7(const nav_msgs::Odometry::ConstPtr& msg);
-    void poseCallback_8(const nav_msgs::Odometry::ConstPtr& msg);
-
-
-    geometry_msgs::Point getPose_from_tf(const tf::StampedTransform& msg);
-    geometry_msgs::Point project_2d_from_3d(const geometry_msgs::Point& msg);
+    void poseCallback(const nav_msgs::Odometry::ConstPtr& msg,
+                      const size_t vehicle_idx);
+
+
+    // project every other vehicle into the camera of vehicle_idx
+    void projectVehicles(const size_t vehicle_idx);
     void init_camera_info();
 
 
@@ -62,129 +59,84 @@ public:
     bool loadParams(void);
 
 private:
+    // one rendered vehicle with its camera and topics
+    struct Vehicle {
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+      std::string name;
+
+      // unity quadrotor
+      std::shared_ptr<Quadrotor> quad_ptr;
+      std::shared_ptr<RGBCamera> rgb_camera;
+      QuadState quad_state;
+      ros::Time odom_stamp;
+
+      // pose and stamp the current frame was rendered with
+      Vector<3> render_position;
+      Quaternion render_attitude;
+      ros::Time render_stamp;
+
+      // subscriber
+      ros::Subscriber sub_state_est;
+
+      // publisher
+      ros::Publisher camera_info_pub;
+      image_transport::Publisher rgb_pub;
+      image_transport::Publisher depth_pub;
+      image_transport::Publisher rgb_bounding_box_pub;
+      ros::Publisher track_bounding_box_pub;
+
+      // reused image messages, reallocated only while still held elsewhere
+      sensor_msgs::ImagePtr rgb_msg;
+      sensor_msgs::ImagePtr depth_msg;
+      sensor_msgs::ImagePtr box_msg;
+
+      // pixel x, pixel y and depth of every vehicle in this camera,
+      // only valid where visible is set
+      Matrix<3, Dynamic> projections;
+      Eigen::Array<bool, 1, Dynamic> visible;
+
+      //bounding box array
+      geometry_msgs::PoseArray bbox_pose_array;
+    };
+
+    void addVehicle(const std::string& name, image_transport::ImageTransport& it);
+    // with camera updates, enable only the cameras and layers that have
+    // subscribers. Returns false if no camera has to be rendered
+    bool updateCameraDemand(void);
+    void snapshotVehicles(void);
+    bool renderFrame(void);
+    void processVehicle(const size_t vehicle_idx);
+    // copy img into msg, returns a cv::Mat that views the message data
+    cv::Mat fillImageMsg(const cv::Mat& img, const ros::Time& stamp,
+                         sensor_msgs::ImagePtr& msg);
+
     // ros nodes
     ros::NodeHandle nh_;
     ros::NodeHandle pnh_;
 
-    // publisher
-    ros::Publisher camera_info_pub;
-    ros::Publisher camera_info_pub_1;
-    ros::Publisher camera_info_pub_2;
-    ros::Publisher camera_info_pub_3;
-    ros::Publisher camera_info_pub_4;
-    ros::Publisher camera_info_pub_5;
-    ros::Publisher camera_info_pub_6;
-    ros::Publisher camera_info_pub_7;
-    ros::Publisher camera_info_pub_8;
-
-    // subscriber
-    ros::Subscriber sub_state_est_;
-    ros::Subscriber sub_state_est_1;
-    ros::Subscriber sub_state_est_2;
-    ros::Subscriber sub_state_est_3;
-    ros::Subscriber sub_state_est_4;
-    ros::Subscriber sub_state_est_5;
-    ros::Subscriber sub_state_est_6;
-    ros::Subscriber sub_state_est_7;
-    ros::Subscriber sub_state_est_8;
-
-    image_transport::Publisher rgb_pub_;
-    image_transport::Publisher depth_pub_;
-    image_transport::Publisher rgb_pub_1_;
-    image_transport::Publisher depth_pub_1_;
-    image_transport::Publisher rgb_pub_2_;
-    image_transport::Publisher depth_pub_2_;
-    image_transport::Publisher rgb_pub_3_;
-    image_transport::Publisher depth_pub_3_;
-    image_transport::Publisher rgb_pub_4_;
-    image_transport::Publisher depth_pub_4_;
-    image_transport::Publisher rgb_pub_5_;
-    image_transport::Publisher depth_pub_5_;
-    image_transport::Publisher rgb_pub_6_;
-    image_transport::Publisher depth_pub_6_;
-    image_transport::Publisher rgb_pub_7_;
-    image_transport::Publisher depth_pub_7_;
-    image_transport::Publisher rgb_pub_8_;
-    image_transport::Publisher depth_pub_8_;
-
-    ros::Publisher track_bounding_box_pub_zero;
-    ros::Publisher track_bounding_box_pub_one;
-    ros::Publisher track_bounding_box_pub_two;
-    image_transport::Publisher rgb_bounding_box_pub_;
-    image_transport::Publisher rgb_bounding_box_pub_one;
-    image_transport::Publisher rgb_bounding_box_pub_two;
-
     //camera info
     sensor_msgs::CameraInfo camera_info_msg;
-    ros::Time camera_timestamp;
-
-    //TF
-    tf::TransformListener   tf_listener;
-    tf::StampedTransform    tf_transform_relative_0_1;
-    tf::StampedTransform    tf_transform_relative_0_2;
 
-    tf::StampedTransform    tf_transform_relative_1_0;
-    tf::StampedTransform    tf_transform_relative_1_2;
+    // world positions of all vehicles, snapshot taken once per frame
+    Matrix<3, Dynamic> positions_;
 
-    tf::StampedTransform    tf_transform_relative_2_0;
-    tf::StampedTransform    tf_transform_relative_2_1;
-
-
-    //bounding box array
-    geometry_msgs::PoseArray bbox_pose_array_zero;
-    geometry_msgs::PoseArray bbox_pose_array_one;
-    geometry_msgs::PoseArray bbox_pose_array_two;
-
-    // main image pub timer
+    // main render and image pub timer
     ros::Timer timer_main_loop_;
-    // main render pub timer
-    ros::Timer timer_render_loop_;
-
-    // unity quadrotor1
-    std::shared_ptr<Quadrotor> quad_ptr_;
-    std::shared_ptr<RGBCamera> rgb_camera_;
-    QuadState quad_state_;
-
-    // unity quadrotor1
-    std::shared_ptr<Quadrotor> quad_ptr_1_;
-    std::shared_ptr<RGBCamera> rgb_camera_1_;
-    QuadState quad_state_1_;
-
-
-    // unity quadrotor2
-    std::shared_ptr<Quadrotor> quad_ptr_2_;
-    std::shared_ptr<RGBCamera> rgb_camera_2_;
-    QuadState quad_state_2_;
-
-    // unity quadrotor3
-    std::shared_ptr<Quadrotor> quad_ptr_3_;
-    std::shared_ptr<RGBCamera> rgb_camera_3_;
-    QuadState quad_state_3_;
-
-    // unity quadrotor4
-    std::shared_ptr<Quadrotor> quad_ptr_4_;
-    std::shared_ptr<RGBCamera> rgb_camera_4_;
-    QuadState quad_state_4_;
-
-    // unity quadrotor5
-    std::shared_ptr<Quadrotor> quad_ptr_5_;
-    std::shared_ptr<RGBCamera> rgb_camera_5_;
-    QuadState quad_state_5_;
-
-    // unity quadrotor6
-    std::shared_ptr<Quadrotor> quad_ptr_6_;
-    std::shared_ptr<RGBCamera> rgb_camera_6_;
-    QuadState quad_state_6_;
-
-    // unity quadrotor7
-    std::shared_ptr<Quadrotor> quad_ptr_7_;
-    std::shared_ptr<RGBCamera> rgb_camera_7_;
-    QuadState quad_state_7_;
-
-    // unity quadrotor8
-    std::shared_ptr<Quadrotor> quad_ptr_8_;
-    std::shared_ptr<RGBCamera> rgb_camera_8_;
-    QuadState quad_state_8_;
+
+    // unity quadrotors, loaded from the "vehicles" parameter
+    std::vector<std::string> vehicle_names_;
+    std::vector<std::unique_ptr<Vehicle>> vehicles_;
+
+    // camera parameters, shared by all vehicles
+    int camera_width_{360};
+    int camera_height_{240};
+    Scalar camera_fov_{90.0};
+    Scalar camera_offset_{0.5};
+    // render only the cameras and layers that have subscribers, needs a
+    // Unity build that applies camera changes per render request
+    bool camera_updates_{false};
+    // vehicles closer than this to the image plane are culled
+    Scalar near_plane_{0.1};
 
     // Flightmare(Unity3D)
     std::shared_ptr<UnityBridge> unity_bridge_ptr_;
@@ -192,10 +144,14 @@ private:
     bool unity_ready_{false};
     bool unity_render_{false};
     RenderMessage_t unity_output_;
-    uint16_t receive_id_{0};
+    FrameID frame_id_{0};
+
+    // odometry stamp to publish, in seconds
+    RollingHistogram latency_{"End-to-end latency"};
+    Scalar latency_log_interval_{10.0};
+    ros::Time last_latency_log_;
 
     // auxiliary variables
     Scalar main_loop_freq_{30.0};
-    Scalar main_render_freq_{30.0};
 };
 }  // namespace flightros
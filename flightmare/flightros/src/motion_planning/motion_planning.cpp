@@ -8,22 +8,27 @@ namespace ob = ompl::base;
 namespace og = ompl::geometric;
 using namespace tinyply;
 
-std::vector<motion_planning::float3> motion_planning::readPointCloud() {
+bool motion_planning::readPointCloud() {
   std::unique_ptr<std::istream> file_stream;
-  std::vector<uint8_t> byte_buffer;
   std::string filepath =
     std::experimental::filesystem::path(__FILE__).parent_path().string() +
     "/data/point_cloud.ply";
+  Timer timer("readPointCloud", "motion_planning");
+  timer.tic();
+  if (mmap_point_cloud_ && mapPointCloud(filepath)) {
+    timer.toc();
+    std::cout << "\tMapped " << points_.cols() << " total vertices" << std::endl;
+    std::cout << timer;
+    buildKDTree();
+    return true;
+  }
+
   try {
     file_stream.reset(new std::ifstream(filepath, std::ios::binary));
 
     if (!file_stream || file_stream->fail())
       throw std::runtime_error("file_stream failed to open " + filepath);
 
-    file_stream->seekg(0, std::ios::end);
-    const float size_mb = file_stream->tellg() * float(1e-6);
-    file_stream->seekg(0, std::ios::beg);
-
     PlyFile file;
     file.parse_header(*file_stream);
 
@@ -48,86 +53,215 @@ std::vector<motion_planning::float3> motion_planning::readPointCloud() {
       }
     }
 
-    // Because most people have their own mesh types, tinyply treats parsed data
-    // as structured/typed byte buffers. See examples below on how to marry your
-    // own application-specific data structures with this one.
-    std::shared_ptr<PlyData> vertices, normals, colors, texcoords, faces,
-      tripstrip;
-
-    // The header information can be used to programmatically extract properties
-    // on elements known to exist in the header prior to reading the data. For
-    // brevity of this sample, properties like vertex position are hard-coded:
-    try {
-      vertices =
-        file.request_properties_from_element("vertex", {"x", "y", "z"});
-    } catch (const std::exception &e) {
-      std::cerr << "tinyply exception: " << e.what() << std::endl;
-    }
+    // only the vertex positions are needed
+    std::shared_ptr<PlyData> vertices =
+      file.request_properties_from_element("vertex", {"x", "y", "z"});
 
     file.read(*file_stream);
-
-    if (vertices)
-      std::cout << "\tRead " << vertices->count << " total vertices "
-                << std::endl;
-
-
-    const size_t numVerticesBytes = vertices->buffer.size_bytes();
-    std::vector<float3> verts(vertices->count);
-    std::memcpy(verts.data(), vertices->buffer.get(), numVerticesBytes);
-
-    int idx = 0;
-    for (const auto &point_tinyply : verts) {
-      if (idx == 0) {
-        points_ = Eigen::Vector3d(static_cast<double>(point_tinyply.x),
-                                  static_cast<double>(point_tinyply.y),
-                                  static_cast<double>(point_tinyply.z));
-      } else {
-        points_.conservativeResize(points_.rows(), points_.cols() + 1);
-        points_.col(points_.cols() - 1) =
-          Eigen::Vector3d(static_cast<double>(point_tinyply.x),
-                          static_cast<double>(point_tinyply.y),
-                          static_cast<double>(point_tinyply.z));
-      }
-      idx += 1;
+    std::cout << "\tRead " << vertices->count << " total vertices "
+              << std::endl;
+
+    // single pass from the tinyply buffer into the preallocated matrix
+    const Eigen::Index num_points = vertices->count;
+    if (vertices->t == tinyply::Type::FLOAT32) {
+      points_ = Eigen::Map<const Eigen::Matrix3Xf>(
+                  reinterpret_cast<const float *>(vertices->buffer.get()), 3,
+                  num_points)
+                  .cast<double>();
+    } else if (vertices->t == tinyply::Type::FLOAT64) {
+      points_ = Eigen::Map<const Eigen::Matrix3Xd>(
+        reinterpret_cast<const double *>(vertices->buffer.get()), 3,
+        num_points);
+    } else {
+      throw std::runtime_error("vertex positions have to be float or double");
     }
-    kd_tree_.SetMatrixData(points_);
+    timer.toc();
+    std::cout << timer;
 
-    return verts;
+    buildKDTree();
+    return true;
   } catch (const std::exception &e) {
     std::cerr << "Caught tinyply exception: " << e.what() << std::endl;
   }
-  return verts;
+  return false;
 }
 
-void motion_planning::getBounds() {
-  min_bounds = verts[0];
-  max_bounds = verts[0];
+bool motion_planning::mapPointCloud(const std::string &filepath) {
+  // the header is parsed by tinyply, the payload is mapped directly
+  std::ifstream header_stream(filepath, std::ios::binary);
+  PlyFile file;
+  if (!header_stream || !file.parse_header(header_stream) ||
+      !file.is_binary_file())
+    return false;
+  const size_t data_offset = header_stream.tellg();
+
+  // supported layout: the vertex element comes first, has no list
+  // properties and stores x, y, z next to each other as float or double
+  const std::vector<PlyElement> elements = file.get_elements();
+  if (elements.empty() || elements[0].name != "vertex") return false;
+  size_t stride = 0, x_offset = 0;
+  Type type = Type::INVALID;
+  std::vector<std::string> names;
+  for (const auto &p : elements[0].properties) {
+    if (p.isList) return false;
+    if (p.name == "x") {
+      x_offset = stride;
+      type = p.propertyType;
+    }
+    names.push_back(p.name);
+    stride += PropertyTable[p.propertyType].stride;
+  }
+  const auto x = std::find(names.begin(), names.end(), "x");
+  if (type != Type::FLOAT32 && type != Type::FLOAT64) return false;
+  if (std::distance(x, names.end()) < 3 || *(x + 1) != "y" || *(x + 2) != "z")
+    return false;
+  const size_t scalar_size = PropertyTable[type].stride;
+  for (auto it = x; it != x + 3; it++) {
+    if (elements[0].properties[it - names.begin()].propertyType != type)
+      return false;
+  }
+  if (stride % scalar_size != 0 || x_offset % scalar_size != 0) return false;
+
+  const int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      (size_t)file_stat.st_size < data_offset + stride * elements[0].size) {
+    close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+  madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+
+  // big endian payloads would need swapping
+  const std::string header(static_cast<const char *>(data), data_offset);
+  const bool little_endian =
+    header.find("binary_little_endian") != std::string::npos;
+  if (little_endian) {
+    const uint8_t *vertex_data =
+      static_cast<const uint8_t *>(data) + data_offset + x_offset;
+    const Eigen::Index num_points = elements[0].size;
+    const Eigen::OuterStride<> outer_stride(stride / scalar_size);
+    if (type == Type::FLOAT32) {
+      points_ = Eigen::Map<const Eigen::Matrix3Xf, 0, Eigen::OuterStride<>>(
+                  reinterpret_cast<const float *>(vertex_data), 3, num_points,
+                  outer_stride)
+                  .cast<double>();
+    } else {
+      points_ = Eigen::Map<const Eigen::Matrix3Xd, 0, Eigen::OuterStride<>>(
+        reinterpret_cast<const double *>(vertex_data), 3, num_points,
+        outer_stride);
+    }
+  }
+  munmap(data, file_stat.st_size);
+  return little_endian;
+}
 
+bool motion_planning::streamPointCloud() {
+  // the point cloud is requested from Unity, so connect first
+  setUnity(true);
+  if (!connectUnity()) return false;
 
-  for (const auto &ver : verts) {
-    if (ver.x < min_bounds.x) {
-      min_bounds.x = ver.x;
-    }
+  PointCloudMessage_t pointcloud_msg;
+  flightlib::PointCloud point_cloud;
+  if (!unity_bridge_ptr_->getPointCloud(pointcloud_msg, point_cloud)) {
+    std::cerr << "Streaming the point cloud failed" << std::endl;
+    return false;
+  }
+  std::cout << "\tStreamed " << point_cloud.size() << " total vertices "
+            << std::endl;
 
-    if (ver.x > max_bounds.x) {
-      max_bounds.x = ver.x;
-    }
+  points_ = point_cloud.points().cast<double>();
+  buildKDTree();
+  return true;
+}
 
-    if (ver.y < min_bounds.y) {
-      min_bounds.y = ver.y;
-    }
+void motion_planning::buildKDTree() {
+  kd_tree_build_ = std::async(std::launch::async, []() {
+    Timer timer("buildKDTree", "motion_planning");
+    timer.tic();
+    kd_tree_.SetMatrixData(points_);
+    timer.toc();
+    std::cout << timer;
+  });
+}
 
-    if (ver.y > max_bounds.y) {
-      max_bounds.y = ver.y;
-    }
+void motion_planning::waitForKDTree() {
+  if (kd_tree_build_.valid()) kd_tree_build_.get();
+}
 
-    if (ver.z > max_bounds.z) {
-      max_bounds.z = ver.z;
-    }
+bool motion_planning::buildVoxelGrid() {
+  Timer timer("buildVoxelGrid", "motion_planning");
+  timer.tic();
+  // the margin keeps the inflated obstacles on the boundary inside the grid
+  if (!voxel_grid_.build(points_.cast<Scalar>(), voxel_resolution_, range,
+                         (size_t)std::max(max_voxels_, 0))) {
+    std::cerr << "Building the voxel grid failed, it needs more than "
+              << max_voxels_ << " voxels at " << voxel_resolution_
+              << " m. Use a coarser voxel_resolution or raise max_voxels."
+              << std::endl;
+    return false;
+  }
+  if (!voxel_grid_.inflate(Vector<3>::Constant(range)) ||
+      !voxel_grid_.computeESDF()) {
+    std::cerr << "Building the voxel grid failed" << std::endl;
+    return false;
   }
+  timer.toc();
+  const Eigen::Vector3i dims = voxel_grid_.getDims();
+  std::cout << "\tVoxel grid " << dims.x() << " x " << dims.y() << " x "
+            << dims.z() << " at " << voxel_resolution_ << " m" << std::endl;
+  std::cout << timer;
+  return true;
 }
 
-void motion_planning::plan() {
+void motion_planning::benchmarkCollision(const int num_samples) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> dist_x(min_bounds.x, max_bounds.x);
+  std::uniform_real_distribution<double> dist_y(min_bounds.y, max_bounds.y);
+  std::uniform_real_distribution<double> dist_z(min_bounds.z, max_bounds.z);
+  std::vector<Eigen::Vector3d> samples(num_samples);
+  for (auto &sample : samples)
+    sample = Eigen::Vector3d(dist_x(gen), dist_y(gen), dist_z(gen));
+
+  std::vector<bool> kd_tree_valid(num_samples), voxel_valid(num_samples);
+  Timer timer_kd_tree("KD-tree", "collision");
+  timer_kd_tree.tic();
+  for (int i = 0; i < num_samples; i++)
+    kd_tree_valid[i] = searchRadius(samples[i], range);
+  timer_kd_tree.toc();
+
+  Timer timer_voxel("voxel grid", "collision");
+  timer_voxel.tic();
+  for (int i = 0; i < num_samples; i++)
+    voxel_valid[i] = !voxel_grid_.isInCollision(samples[i].cast<Scalar>());
+  timer_voxel.toc();
+
+  // the voxel grid is conservative, free states close to obstacles can be
+  // rejected, but colliding states are never accepted
+  int num_missed = 0, num_rejected = 0;
+  for (int i = 0; i < num_samples; i++) {
+    if (voxel_valid[i] && !kd_tree_valid[i]) num_missed++;
+    if (!voxel_valid[i] && kd_tree_valid[i]) num_rejected++;
+  }
+  std::cout << timer_kd_tree << timer_voxel;
+  std::cout << "\t" << num_samples << " samples, " << num_missed
+            << " collisions missed, " << num_rejected
+            << " free states rejected by the voxel grid" << std::endl;
+}
+
+void motion_planning::getBounds() {
+  const Eigen::Vector3d min_points = points_.rowwise().minCoeff();
+  const Eigen::Vector3d max_points = points_.rowwise().maxCoeff();
+  min_bounds = {(float)min_points.x(), (float)min_points.y(),
+                (float)min_points.z()};
+  max_bounds = {(float)max_points.x(), (float)max_points.y(),
+                (float)max_points.z()};
+}
+
+og::SimpleSetupPtr motion_planning::createSetup() {
   // construct the state space we are planning in
   auto space(std::make_shared<ob::SE3StateSpace>());
 
@@ -144,11 +278,108 @@ void motion_planning::plan() {
   space->setBounds(bounds);
 
   // define a simple setup class
-  og::SimpleSetup ss(space);
+  auto ss(std::make_shared<og::SimpleSetup>(space));
+
+  // set state validity checking for this space, the map and the collision
+  // checker are shared read-only between all setups
+  if (use_voxel_grid_) {
+    ss->setStateValidityChecker(
+      std::make_shared<VoxelValidityChecker>(ss->getSpaceInformation()));
+    ss->getSpaceInformation()->setMotionValidator(
+      std::make_shared<VoxelMotionValidator>(ss->getSpaceInformation()));
+  } else {
+    ss->setStateValidityChecker(
+      [](const ob::State *state) { return isStateValid(state); });
+  }
+  ss->setPlanner(
+    std::make_shared<og::RRTConnect>(ss->getSpaceInformation()));
+  ss->setup();
+  return ss;
+}
+
+bool motion_planning::solveQuery(og::SimpleSetup &ss,
+                                 const PlanningQuery &query,
+                                 const double timeout, PlanningResult &result) {
+  // drop the previous query, the setup and its sampler are kept
+  ss.clear();
+
+  ob::ScopedState<ob::SE3StateSpace> start(ss.getStateSpace());
+  start->setXYZ(query.start.x(), query.start.y(), query.start.z());
+  start->rotation().setIdentity();
+  ob::ScopedState<ob::SE3StateSpace> goal(ss.getStateSpace());
+  goal->setXYZ(query.goal.x(), query.goal.y(), query.goal.z());
+  goal->rotation().setIdentity();
+  ss.setStartAndGoalStates(start, goal);
+
+  const ob::PlannerStatus solved = ss.solve(timeout);
+  result.planning_time = ss.getLastPlanComputationTime();
+  result.path.clear();
+  result.solved = solved == ob::PlannerStatus::EXACT_SOLUTION;
+  if (!result.solved) return false;
+
+  ss.simplifySolution();
+  for (auto const &state : ss.getSolutionPath().getStates()) {
+    result.path.push_back(stateToEigen(state));
+  }
+  return true;
+}
+
+std::vector<motion_planning::PlanningResult> motion_planning::planQueries(
+  const std::vector<PlanningQuery> &queries, const int num_threads,
+  const double timeout) {
+  std::vector<PlanningResult> results(queries.size());
+  const int num_workers = std::max(
+    1, std::min<int>(num_threads > 0 ? num_threads
+                                     : std::thread::hardware_concurrency(),
+                     queries.size()));
+
+  // workers pull the next query from a shared counter
+  std::atomic<size_t> next_query{0};
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_workers; i++) {
+    workers.emplace_back([&]() {
+      og::SimpleSetupPtr ss = createSetup();
+      for (size_t q = next_query++; q < queries.size(); q = next_query++) {
+        solveQuery(*ss, queries[q], timeout, results[q]);
+      }
+    });
+  }
+  for (auto &worker : workers) worker.join();
+  return results;
+}
 
-  // set state validity checking for this space
-  ss.setStateValidityChecker(
-    [](const ob::State *state) { return isStateValid(state); });
+bool motion_planning::sampleQueries(const int num_queries,
+                                    std::vector<PlanningQuery> &queries,
+                                    const int max_attempts) {
+  og::SimpleSetupPtr ss = createSetup();
+  ob::ScopedState<ob::SE3StateSpace> state(ss->getStateSpace());
+  auto sample = [&](Eigen::Vector3d &position) {
+    for (int i = 0; i < max_attempts; i++) {
+      state.random();
+      if (ss->getStateValidityChecker()->isValid(state.get())) {
+        position = stateToEigen(state.get());
+        return true;
+      }
+    }
+    return false;
+  };
+
+  queries.resize(std::max(num_queries, 0));
+  for (auto &query : queries) {
+    if (!sample(query.start) || !sample(query.goal)) {
+      std::cerr << "No collision free state found in " << max_attempts
+                << " samples" << std::endl;
+      queries.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void motion_planning::plan() {
+  og::SimpleSetupPtr setup = createSetup();
+  og::SimpleSetup &ss = *setup;
+  auto space = ss.getStateSpace();
 
   // create a random start state
   ob::ScopedState<> start(space);
@@ -162,7 +393,6 @@ void motion_planning::plan() {
   ss.setStartAndGoalStates(start, goal);
 
   // this call is optional, but we put it in to get more output information
-  ss.setup();
   ss.print();
 
   // attempt to solve the problem within one second of planning time
@@ -272,6 +502,58 @@ bool motion_planning::isStateValid(const ob::State *state) {
   return searchRadius(query_pos, range);
 }
 
+bool motion_planning::VoxelValidityChecker::isValid(
+  const ob::State *state) const {
+  return !voxel_grid_.isInCollision(stateToEigen(state).cast<Scalar>());
+}
+
+double motion_planning::VoxelValidityChecker::clearance(
+  const ob::State *state) const {
+  // distance of the drone box to the closest obstacle, bounded by the
+  // sphere around the box
+  return voxel_grid_.getDistance(stateToEigen(state).cast<Scalar>()) -
+         std::sqrt(3.0) * range;
+}
+
+bool motion_planning::VoxelMotionValidator::checkMotion(
+  const ob::State *s1, const ob::State *s2) const {
+  // the swept voxels include both end states
+  const bool valid =
+    si_->satisfiesBounds(s2) &&
+    !voxel_grid_.isInCollision(stateToEigen(s1).cast<Scalar>(),
+                               stateToEigen(s2).cast<Scalar>());
+  if (valid)
+    valid_++;
+  else
+    invalid_++;
+  return valid;
+}
+
+bool motion_planning::VoxelMotionValidator::checkMotion(
+  const ob::State *s1, const ob::State *s2,
+  std::pair<ob::State *, double> &last_valid) const {
+  const Eigen::Vector3d p1 = stateToEigen(s1), p2 = stateToEigen(s2);
+  Scalar t_collision = 1.0;
+  if (si_->satisfiesBounds(s2) &&
+      !voxel_grid_.isInCollision(p1.cast<Scalar>(), p2.cast<Scalar>(),
+                                 &t_collision)) {
+    valid_++;
+    return true;
+  }
+  // back off by one voxel from where the first colliding voxel is entered
+  if (last_valid.first != nullptr) {
+    const double length = (p2 - p1).norm();
+    last_valid.second =
+      length > 0.0
+        ? std::max(0.0, t_collision - voxel_grid_.getResolution() / length)
+        : 0.0;
+    si_->getStateSpace()->interpolate(s1, s2, last_valid.second,
+                                      last_valid.first);
+  }
+  invalid_++;
+  return false;
+}
+
 bool motion_planning::searchRadius(const Eigen::Vector3d &query_point,
                                    const double radius) {
   std::vector<int> indices;
@@ -318,15 +600,6 @@ void motion_planning::executePath() {
   }
 
   // Flightmare
-  Vector<3> B_r_BC(0.0, 0.0, 0.3);
-  Matrix<3, 3> R_BC = Quaternion(1.0, 0.0, 0.0, 0.0).toRotationMatrix();
-  std::cout << R_BC << std::endl;
-  rgb_camera_->setFOV(90);
-  rgb_camera_->setWidth(720);
-  rgb_camera_->setHeight(480);
-  rgb_camera_->setRelPose(B_r_BC, R_BC);
-  quad_ptr_->addRGBCamera(rgb_camera_);
-
   quad_state_.setZero();
   quad_state_.x[QS::POSX] = (Scalar)vecs_.at(0).x();
   quad_state_.x[QS::POSY] = (Scalar)vecs_.at(0).y();
@@ -334,9 +607,11 @@ void motion_planning::executePath() {
 
   quad_ptr_->reset(quad_state_);
 
-  // connect unity
-  setUnity(unity_render_);
-  connectUnity();
+  // connect unity, streaming the point cloud already did
+  if (!unity_ready_) {
+    setUnity(unity_render_);
+    connectUnity();
+  }
   assert(unity_ready_);
   assert(unity_render_);
 
@@ -361,6 +636,17 @@ void motion_planning::executePath() {
   }
 }
 
+void motion_planning::setupQuad() {
+  Vector<3> B_r_BC(0.0, 0.0, 0.3);
+  Matrix<3, 3> R_BC = Quaternion(1.0, 0.0, 0.0, 0.0).toRotationMatrix();
+  std::cout << R_BC << std::endl;
+  rgb_camera_->setFOV(90);
+  rgb_camera_->setWidth(720);
+  rgb_camera_->setHeight(480);
+  rgb_camera_->setRelPose(B_r_BC, R_BC);
+  quad_ptr_->addRGBCamera(rgb_camera_);
+}
+
 bool motion_planning::setUnity(const bool render) {
   unity_render_ = render;
   if (unity_render_ && unity_bridge_ptr_ == nullptr) {
@@ -388,12 +674,66 @@ int main(int argc, char *argv[]) {
   motion_planning::quad_ptr_ = std::make_unique<Quadrotor>();
   // add camera
   motion_planning::rgb_camera_ = std::make_unique<RGBCamera>();
-
-  std::cout << "Read PointCloud" << std::endl;
-  motion_planning::verts = motion_planning::readPointCloud();
+  motion_planning::setupQuad();
+
+  pnh.param("stream_point_cloud", motion_planning::stream_point_cloud_, false);
+  pnh.param("mmap_point_cloud", motion_planning::mmap_point_cloud_, false);
+  pnh.param("use_voxel_grid", motion_planning::use_voxel_grid_, false);
+  pnh.param("voxel_resolution", motion_planning::voxel_resolution_, 0.1);
+  pnh.param("max_voxels", motion_planning::max_voxels_,
+            (int)VoxelGrid::kDefaultMaxVoxels);
+  pnh.param("collision_benchmark", motion_planning::collision_benchmark_, 0);
+  pnh.param("num_queries", motion_planning::num_queries_, 0);
+  pnh.param("planning_threads", motion_planning::planning_threads_, 0);
+  pnh.param("planning_timeout", motion_planning::planning_timeout_, 1.0);
+  bool loaded = false;
+  if (motion_planning::stream_point_cloud_) {
+    std::cout << "Stream PointCloud" << std::endl;
+    loaded = motion_planning::streamPointCloud();
+  } else {
+    std::cout << "Read PointCloud" << std::endl;
+    loaded = motion_planning::readPointCloud();
+  }
+  if (!loaded || motion_planning::points_.cols() == 0) {
+    std::cerr << "No point cloud loaded" << std::endl;
+    return 1;
+  }
 
   std::cout << "Get Bounds" << std::endl;
   motion_planning::getBounds();
+  if (motion_planning::use_voxel_grid_ &&
+      !motion_planning::buildVoxelGrid()) {
+    motion_planning::use_voxel_grid_ = false;
+  }
+  motion_planning::waitForKDTree();
+  if (motion_planning::use_voxel_grid_ &&
+      motion_planning::collision_benchmark_ > 0) {
+    motion_planning::benchmarkCollision(motion_planning::collision_benchmark_);
+  }
+
+  if (motion_planning::num_queries_ > 0) {
+    std::cout << "Plan " << motion_planning::num_queries_ << " queries"
+              << std::endl;
+    std::vector<motion_planning::PlanningQuery> queries;
+    if (!motion_planning::sampleQueries(motion_planning::num_queries_,
+                                        queries)) {
+      return 1;
+    }
+    Timer timer("planQueries", "motion_planning");
+    timer.tic();
+    const std::vector<motion_planning::PlanningResult> results =
+      motion_planning::planQueries(queries, motion_planning::planning_threads_,
+                                   motion_planning::planning_timeout_);
+    timer.toc();
+    const int num_solved =
+      std::count_if(results.begin(), results.end(),
+                    [](const motion_planning::PlanningResult &result) {
+                      return result.solved;
+                    });
+    std::cout << "\tSolved " << num_solved << " of " << results.size()
+              << " queries" << std::endl;
+    std::cout << timer;
+  }
 
   std::cout << "Plan & stuff" << std::endl;
   while (!motion_planning::solution_found) {
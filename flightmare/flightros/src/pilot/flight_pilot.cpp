@@ -1,10 +1,5 @@
 #include "flightros/pilot/flight_pilot.hpp"
 
-#define use_multi true
-#define CAMERA_RES_WIDTH 360 //180 //720
-#define CAMERA_RES_HEIGHT 240 //120 //480
-#define CAMERA_FOV 90
-#define DRONE2CAM_OFFSET 0.5
 namespace flightros {
 
 FlightPilot::FlightPilot(const ros::NodeHandle &nh, const ros::NodeHandle &pnh)
@@ -13,9 +8,7 @@ FlightPilot::FlightPilot(const ros::NodeHandle &nh, const ros::NodeHandle &pnh)
     scene_id_(UnityScene::WAREHOUSE),
     unity_ready_(false),
     unity_render_(false),
-    receive_id_(0),
-    main_loop_freq_(30.0),
-    main_render_freq_(30.0) {
+    main_loop_freq_(30.0) {
   // load parameters
   if (!loadParams()) {
     ROS_WARN("[%s] Could not load all parameters.",
@@ -24,469 +17,325 @@ FlightPilot::FlightPilot(const ros::NodeHandle &nh, const ros::NodeHandle &pnh)
     ROS_INFO("[%s] Loaded all parameters.", pnh_.getNamespace().c_str());
   }
 
-  // quad shared info
-  Vector<3> B_r_BC(0, DRONE2CAM_OFFSET, 0);
-  Matrix<3, 3> R_BC = Quaternion(1.0, 0.0, 0.0, 0.0).toRotationMatrix();
-  std::cout << R_BC << std::endl;
-
+  // initialize publisher
+  image_transport::ImageTransport it(pnh);
 
-  // ============================== drone 1 ==============================
-  // quad initialization
-  quad_ptr_1_ = std::make_shared<Quadrotor>();
+  // quadrotors, cameras and topics for every vehicle
+  for (const std::string &name : vehicle_names_) addVehicle(name, it);
 
-  // add mono camera
-  rgb_camera_1_ = std::make_shared<RGBCamera>();
-  rgb_camera_1_->setFOV(CAMERA_FOV);
-  rgb_camera_1_->setWidth(CAMERA_RES_WIDTH);
-  rgb_camera_1_->setHeight(CAMERA_RES_HEIGHT);
-  rgb_camera_1_->setRelPose(B_r_BC, R_BC);
-  rgb_camera_1_->setPostProcesscing(
-    std::vector<bool>{true, false, false});  // depth, segmentation, optical flow
-  quad_ptr_1_->addRGBCamera(rgb_camera_1_);
+  init_camera_info();
 
-  // initialization
-  quad_state_1_.setZero();
-  quad_ptr_1_->reset(quad_state_1_);
+  timer_main_loop_ = nh_.createTimer(ros::Rate(main_loop_freq_), &FlightPilot::mainLoopCallback, this);
 
 
-  // ============================== drone 2 ==============================
-  // quad initialization
-  quad_ptr_2_ = std::make_shared<Quadrotor>();
-
-  // add mono camera
-  rgb_camera_2_ = std::make_shared<RGBCamera>();
-  rgb_camera_2_->setFOV(CAMERA_FOV);
-  rgb_camera_2_->setWidth(CAMERA_RES_WIDTH);
-  rgb_camera_2_->setHeight(CAMERA_RES_HEIGHT);
-  rgb_camera_2_->setRelPose(B_r_BC, R_BC);
-  rgb_camera_2_->setPostProcesscing(
-    std::vector<bool>{true, false, false});  // depth, segmentation, optical flow
-  quad_ptr_2_->addRGBCamera(rgb_camera_2_);
+  // wait until the gazebo and unity are loaded
+  ros::Duration(5.0).sleep();
 
-  // initialization
-  quad_state_2_.setZero();
-  quad_ptr_2_->reset(quad_state_2_);
+  // connect unity
+  setUnity(unity_render_);
+  connectUnity();
+}
 
+FlightPilot::~FlightPilot() {}
 
+void FlightPilot::addVehicle(const std::string &name,
+                             image_transport::ImageTransport &it) {
+  const size_t idx = vehicles_.size();
+  std::unique_ptr<Vehicle> vehicle(new Vehicle());
+  vehicle->name = name;
 
-  // ============================== drone 0 ==============================
   // quad initialization
-  quad_ptr_ = std::make_shared<Quadrotor>();
+  vehicle->quad_ptr = std::make_shared<Quadrotor>();
 
   // add mono camera
-  rgb_camera_ = std::make_shared<RGBCamera>();
-  rgb_camera_->setFOV(CAMERA_FOV);
-  rgb_camera_->setWidth(CAMERA_RES_WIDTH);
-  rgb_camera_->setHeight(CAMERA_RES_HEIGHT);
-  rgb_camera_->setRelPose(B_r_BC, R_BC);
-  rgb_camera_->setPostProcesscing(
-    std::vector<bool>{true, false, false});  // depth, segmentation, optical flow
-  quad_ptr_->addRGBCamera(rgb_camera_);
+  Vector<3> B_r_BC(0, camera_offset_, 0);
+  Matrix<3, 3> R_BC = Quaternion(1.0, 0.0, 0.0, 0.0).toRotationMatrix();
+  vehicle->rgb_camera = std::make_shared<RGBCamera>();
+  vehicle->rgb_camera->setFOV(camera_fov_);
+  vehicle->rgb_camera->setWidth(camera_width_);
+  vehicle->rgb_camera->setHeight(camera_height_);
+  vehicle->rgb_camera->setRelPose(B_r_BC, R_BC);
+  // with camera updates layers are enabled on demand, see
+  // updateCameraDemand()
+  vehicle->rgb_camera->setPostProcesscing(std::vector<bool>{
+    !camera_updates_, false, false});  // depth, segmentation, optical flow
+  vehicle->quad_ptr->addRGBCamera(vehicle->rgb_camera);
 
   // initialization
-  quad_state_.setZero();
-  quad_ptr_->reset(quad_state_);
-
-
-
-  // ============================== subscribe and publish ==============================
-
-  // initialize publisher
-  image_transport::ImageTransport it(pnh);
+  vehicle->quad_state.setZero();
+  vehicle->quad_ptr->reset(vehicle->quad_state);
 
   //publisher
-  rgb_pub_ = it.advertise("/hummingbird0/camera/rgb",1);
-//  depth_pub_ = it.advertise("/hummingbird0/camera/depth",1);
-  camera_info_pub = nh_.advertise<sensor_msgs::CameraInfo>("/hummingbird0/camera/camera_info",1);
-
-  rgb_pub_1_ = it.advertise("/hummingbird1/camera/rgb",1);
-  camera_info_pub_1 = nh_.advertise<sensor_msgs::CameraInfo>("/hummingbird1/camera/camera_info",1);
-
-  rgb_pub_2_ = it.advertise("/hummingbird2/camera/rgb",1);
-  camera_info_pub_2 = nh_.advertise<sensor_msgs::CameraInfo>("/hummingbird2/camera/camera_info",1);
+  const std::string prefix = "/" + name;
+  vehicle->rgb_pub = it.advertise(prefix + "/camera/rgb", 1);
+  vehicle->depth_pub = it.advertise(prefix + "/camera/depth", 1);
+  vehicle->camera_info_pub = nh_.advertise<sensor_msgs::CameraInfo>(prefix + "/camera/camera_info", 1);
 
   //bounding box overlay RGB img
-  rgb_bounding_box_pub_ = it.advertise("/hummingbird0/camera/bounding_box",1);
-  rgb_bounding_box_pub_one = it.advertise("/hummingbird1/camera/bounding_box",1);
-  rgb_bounding_box_pub_two = it.advertise("/hummingbird2/camera/bounding_box",1);
+  vehicle->rgb_bounding_box_pub = it.advertise(prefix + "/camera/bounding_box", 1);
 
   //bounding box with 2D position
-  track_bounding_box_pub_zero = nh_.advertise<geometry_msgs::PoseArray>("/hummingbird0/track/bounding_box",1);
-  track_bounding_box_pub_one = nh_.advertise<geometry_msgs::PoseArray>("/hummingbird1/track/bounding_box",1);
-  track_bounding_box_pub_two = nh_.advertise<geometry_msgs::PoseArray>("/hummingbird2/track/bounding_box",1);
-
-
-
-  init_camera_info();
+  vehicle->track_bounding_box_pub = nh_.advertise<geometry_msgs::PoseArray>(prefix + "/track/bounding_box", 1);
 
   // initialize subscriber call backs
-  sub_state_est_ = nh_.subscribe("flight_pilot/state_estimate0", 1, &FlightPilot::poseCallback, this);
-
-#ifdef use_multi
-  sub_state_est_1 = nh_.subscribe("flight_pilot/state_estimate1", 1,&FlightPilot::poseCallback_1, this);
-  sub_state_est_2 = nh_.subscribe("flight_pilot/state_estimate2", 1,&FlightPilot::poseCallback_2, this);
-
-
-#endif
-
-  timer_main_loop_ = nh_.createTimer(ros::Rate(main_loop_freq_), &FlightPilot::mainLoopCallback, this);
-  timer_render_loop_ = nh_.createTimer(ros::Rate(main_render_freq_), &FlightPilot::mainRenderCallback, this);
-
-
-  // wait until the gazebo and unity are loaded
-  ros::Duration(5.0).sleep();
+  vehicle->sub_state_est = nh_.subscribe<nav_msgs::Odometry>(
+    "flight_pilot/state_estimate" + std::to_string(idx), 1,
+    boost::bind(&FlightPilot::poseCallback, this, _1, idx));
 
-  // connect unity
-  setUnity(unity_render_);
-  connectUnity();
+  vehicles_.push_back(std::move(vehicle));
+  positions_.resize(3, vehicles_.size());
 }
 
-FlightPilot::~FlightPilot() {}
-
 void FlightPilot::init_camera_info() {
 //     [fx  0 cx]
 // K = [ 0 fy cy]
 //     [ 0  0  1]
-  float f = ( float(CAMERA_RES_HEIGHT/2) / float(tan((M_PI*CAMERA_FOV/180)/2)) );
+  float f = ( float(camera_height_/2) / float(tan((M_PI*camera_fov_/180)/2)) );
   float fx = f;
   float fy = f;
-  float cx = CAMERA_RES_WIDTH/2;
-  float cy = CAMERA_RES_HEIGHT/2;
+  float cx = camera_width_/2;
+  float cy = camera_height_/2;
 
 
   camera_info_msg.header.frame_id = "camera";
   camera_info_msg.distortion_model = "plumb_bob";
-  camera_info_msg.width = CAMERA_RES_WIDTH;
-  camera_info_msg.height = CAMERA_RES_HEIGHT;
+  camera_info_msg.width = camera_width_;
+  camera_info_msg.height = camera_height_;
   camera_info_msg.K = {fx, 0, cx, 0, fy, cy, 0, 0, 1};
 
 }
 
-void FlightPilot::poseCallback(const nav_msgs::Odometry::ConstPtr &msg) {
-  quad_state_.x[QS::POSX] = (Scalar)msg->pose.pose.position.y * -1;
-  quad_state_.x[QS::POSY] = (Scalar)msg->pose.pose.position.x;
-  quad_state_.x[QS::POSZ] = (Scalar)msg->pose.pose.position.z;
-  quad_state_.x[QS::ATTW] = (Scalar)msg->pose.pose.orientation.w;
-  quad_state_.x[QS::ATTX] = (Scalar)msg->pose.pose.orientation.y * -1;
-  quad_state_.x[QS::ATTY] = (Scalar)msg->pose.pose.orientation.x;
-  quad_state_.x[QS::ATTZ] = (Scalar)msg->pose.pose.orientation.z;
+void FlightPilot::poseCallback(const nav_msgs::Odometry::ConstPtr &msg,
+                               const size_t vehicle_idx) {
+  QuadState &quad_state = vehicles_[vehicle_idx]->quad_state;
+  quad_state.x[QS::POSX] = (Scalar)msg->pose.pose.position.y * -1;
+  quad_state.x[QS::POSY] = (Scalar)msg->pose.pose.position.x;
+  quad_state.x[QS::POSZ] = (Scalar)msg->pose.pose.position.z;
+  quad_state.x[QS::ATTW] = (Scalar)msg->pose.pose.orientation.w;
+  quad_state.x[QS::ATTX] = (Scalar)msg->pose.pose.orientation.y * -1;
+  quad_state.x[QS::ATTY] = (Scalar)msg->pose.pose.orientation.x;
+  quad_state.x[QS::ATTZ] = (Scalar)msg->pose.pose.orientation.z;
+  vehicles_[vehicle_idx]->odom_stamp = msg->header.stamp;
 
   //rotate FlightPilot Render +90deg ZAxis to match Gazebo
 
 }
 
-void FlightPilot::poseCallback_1(const nav_msgs::Odometry::ConstPtr &msg) {
-#ifdef use_multi
-  quad_state_1_.x[QS::POSX] = (Scalar)msg->pose.pose.position.y * -1;
-  quad_state_1_.x[QS::POSY] = (Scalar)msg->pose.pose.position.x;
-  quad_state_1_.x[QS::POSZ] = (Scalar)msg->pose.pose.position.z;
-  quad_state_1_.x[QS::ATTW] = (Scalar)msg->pose.pose.orientation.w;
-  quad_state_1_.x[QS::ATTX] = (Scalar)msg->pose.pose.orientation.y * -1;
-  quad_state_1_.x[QS::ATTY] = (Scalar)msg->pose.pose.orientation.x;
-  quad_state_1_.x[QS::ATTZ] = (Scalar)msg->pose.pose.orientation.z;
-
-  //rotate FlightPilot Render +90deg ZAxis to match Gazebo
-
-#endif
-
-}
-
-void FlightPilot::poseCallback_2(const nav_msgs::Odometry::ConstPtr &msg) {
-#ifdef use_multi
-  quad_state_2_.x[QS::POSX] = (Scalar)msg->pose.pose.position.y * -1;
-  quad_state_2_.x[QS::POSY] = (Scalar)msg->pose.pose.position.x;
-  quad_state_2_.x[QS::POSZ] = (Scalar)msg->pose.pose.position.z;
-  quad_state_2_.x[QS::ATTW] = (Scalar)msg->pose.pose.orientation.w;
-  quad_state_2_.x[QS::ATTX] = (Scalar)msg->pose.pose.orientation.y * -1;
-  quad_state_2_.x[QS::ATTY] = (Scalar)msg->pose.pose.orientation.x;
-  quad_state_2_.x[QS::ATTZ] = (Scalar)msg->pose.pose.orientation.z;
-
-  //rotate FlightPilot Render +90deg ZAxis to match Gazebo
-
-#endif
-
-}
-
-void FlightPilot::poseCallback_3(const nav_msgs::Odometry::ConstPtr &msg) {
-#ifdef use_multi
-  quad_state_3_.x[QS::POSX] = (Scalar)msg->pose.pose.position.y * -1;
-  quad_state_3_.x[QS::POSY] = (Scalar)msg->pose.pose.position.x;
-  quad_state_3_.x[QS::POSZ] = (Scalar)msg->pose.pose.position.z;
-  quad_state_3_.x[QS::ATTW] = (Scalar)msg->pose.pose.orientation.w;
-  quad_state_3_.x[QS::ATTX] = (Scalar)msg->pose.pose.orientation.y * -1;
-  quad_state_3_.x[QS::ATTY] = (Scalar)msg->pose.pose.orientation.x;
-  quad_state_3_.x[QS::ATTZ] = (Scalar)msg->pose.pose.orientation.z;
-
-  //rotate FlightPilot Render +90deg ZAxis to match Gazebo
-
-#endif
-
-}
-
-void FlightPilot::poseCallback_4(const nav_msgs::Odometry::ConstPtr &msg) {
-#ifdef use_multi
-  quad_state_4_.x[QS::POSX] = (Scalar)msg->pose.pose.position.y * -1;
-  quad_state_4_.x[QS::POSY] = (Scalar)msg->pose.pose.position.x;
-  quad_state_4_.x[QS::POSZ] = (Scalar)msg->pose.pose.position.z;
-  quad_state_4_.x[QS::ATTW] = (Scalar)msg->pose.pose.orientation.w;
-  quad_state_4_.x[QS::ATTX] = (Scalar)msg->pose.pose.orientation.y * -1;
-  quad_state_4_.x[QS::ATTY] = (Scalar)msg->pose.pose.orientation.x;
-  quad_state_4_.x[QS::ATTZ] = (Scalar)msg->pose.pose.orientation.z;
-
-  //rotate FlightPilot Render +90deg ZAxis to match Gazebo
-
-#endif
 
+bool FlightPilot::updateCameraDemand(void) {
+  bool any_enabled = false;
+  for (auto &vehicle : vehicles_) {
+    const bool need_depth = vehicle->depth_pub.getNumSubscribers() > 0;
+    const bool need_camera = need_depth ||
+                             vehicle->rgb_pub.getNumSubscribers() > 0 ||
+                             vehicle->rgb_bounding_box_pub.getNumSubscribers() > 0;
+    any_enabled = any_enabled || need_camera;
+    // without camera updates Unity renders every camera and layer anyway
+    if (!camera_updates_) continue;
+    // the bridge sends changed settings with the next render request
+    vehicle->rgb_camera->enable(need_camera);
+    vehicle->rgb_camera->setPostProcesscing(
+      std::vector<bool>{need_depth, false, false});
+  }
+  return any_enabled;
 }
 
-
-void FlightPilot::mainRenderCallback(const ros::TimerEvent &event) {
-
-#ifdef use_multi
-  quad_ptr_1_->setState(quad_state_1_);
-  quad_ptr_2_->setState(quad_state_2_);
-
-#endif
-
-  //Get next render with updated quad State
-  quad_ptr_->setState(quad_state_);
-
-  if (unity_render_ && unity_ready_) {
-    unity_bridge_ptr_->getRender(0);
-    unity_bridge_ptr_->handleOutput();
-
+void FlightPilot::snapshotVehicles(void) {
+  // all outputs of this frame refer to this snapshot
+  for (size_t i = 0; i < vehicles_.size(); i++) {
+    Vehicle &vehicle = *vehicles_[i];
+    vehicle.render_position = vehicle.quad_state.p;
+    vehicle.render_attitude = vehicle.quad_state.q();
+    vehicle.render_stamp = vehicle.odom_stamp;
+    positions_.col(i) = vehicle.render_position;
+
+    //Get next render with updated quad State
+    vehicle.quad_ptr->setState(vehicle.quad_state);
   }
 }
 
-//return point from TF
-geometry_msgs::Point FlightPilot::getPose_from_tf(const tf::StampedTransform &tf_msg) {
-
-  geometry_msgs::Point temp_point;
-  temp_point.x = tf_msg.getOrigin().x();
-  temp_point.y = tf_msg.getOrigin().y();
-  temp_point.z = tf_msg.getOrigin().z();
-  //ROS_INFO("TF12 X: %f, Y: %f, Z: %f\n", temp_point.x , temp_point.y , temp_point.z );
-
-  return temp_point;
+bool FlightPilot::renderFrame(void) {
+  if (!unity_render_ || !unity_ready_) return false;
+
+  // tag the request, late replies to earlier requests are drained so the
+  // images always belong to this snapshot
+  frame_id_++;
+  unity_bridge_ptr_->getRender(frame_id_);
+  if (!unity_bridge_ptr_->handleOutput(frame_id_)) {
+    ROS_WARN("[%s] Did not receive frame %lu.", pnh_.getNamespace().c_str(),
+             (unsigned long)frame_id_);
+    return false;
+  }
+  return true;
 }
 
-//return 2D point from 3D projection
-geometry_msgs::Point FlightPilot::project_2d_from_3d(const geometry_msgs::Point &point_msg) {
+void FlightPilot::projectVehicles(const size_t vehicle_idx) {
+  Vehicle &vehicle = *vehicles_[vehicle_idx];
+  const int num_vehicles = positions_.cols();
 
-  geometry_msgs::Point projected_point;
+  // odometry is stored rotated by +90deg around z (see poseCallback), the
+  // camera looks along the x axis of the original body frame.
+  Matrix<3, 3> R_GU;
+  R_GU << 0, 1, 0, -1, 0, 0, 0, 0, 1;
+  const Matrix<3, 3> R_WB = vehicle.render_attitude.toRotationMatrix();
+  const Matrix<3, 3> R_CW = R_GU * R_WB.transpose();
+  const Vector<3> p_WC =
+    vehicle.render_position + R_WB * R_GU.transpose() * Vector<3>(camera_offset_, 0, 0);
 
-  //default init
-  projected_point.x = CAMERA_RES_WIDTH/2;
-  projected_point.y = CAMERA_RES_HEIGHT/2;
+  // all vehicles in the camera frame at once
+  const Matrix<3, Dynamic> p_C = R_CW * (positions_.colwise() - p_WC);
 
   //project 3D to 2D
   //px = (-1) *fy*y/x + cx (row)
   //py = (-1) *fx*z/x + cy (col)
-  projected_point.x = -1*camera_info_msg.K[4]*point_msg.y/point_msg.x + camera_info_msg.K[2];
-  projected_point.y = -1*camera_info_msg.K[0]*point_msg.z/point_msg.x + camera_info_msg.K[5];
-
-  //ROS_INFO("px12 pX: %d, pY: %d\n", (int)projected_point.x, (int)projected_point.y);
-
-  return projected_point;
+  const Scalar fx = camera_info_msg.K[0];
+  const Scalar fy = camera_info_msg.K[4];
+  const Scalar cx = camera_info_msg.K[2];
+  const Scalar cy = camera_info_msg.K[5];
+  const auto depth = p_C.row(0).array();
+  vehicle.projections.resize(3, num_vehicles);
+  vehicle.projections.row(0) = (-fy * p_C.row(1).array() / depth + cx).matrix();
+  vehicle.projections.row(1) = (-fx * p_C.row(2).array() / depth + cy).matrix();
+  vehicle.projections.row(2) = p_C.row(0);
+
+  // behind-camera culling and frustum check
+  const auto px = vehicle.projections.row(0).array();
+  const auto py = vehicle.projections.row(1).array();
+  vehicle.visible = (depth > near_plane_) && (px >= 0) && (px < camera_width_) &&
+                    (py >= 0) && (py < camera_height_);
+  vehicle.visible(vehicle_idx) = false;
 }
 
-
 void FlightPilot::mainLoopCallback(const ros::TimerEvent &event) {
 
-  //add Image Data Retrieve
-  cv::Mat img;
-  cv::Mat img_depth;
-  cv::Mat img_one;
-  cv::Mat img_two;
-  cv::Mat img_depth_two;
-  cv::Mat img_three;
-  cv::Mat img_four;
-  cv::Mat img_depth_three;
-  cv::Mat img_depth_four;
-  cv::Mat img_bounding_box;
-  cv::Mat img_bounding_box_one;
-  cv::Mat img_bounding_box_two;
-
-  camera_timestamp = ros::Time::now();
-
-  //0th camera
-  rgb_camera_->getRGBImage(img);
-  sensor_msgs::ImagePtr rgb_msg = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img).toImageMsg();
-  rgb_msg->header.stamp = camera_timestamp;
-  rgb_pub_.publish(rgb_msg);
-
-//  rgb_camera_->getDepthMap(img_depth);
-//  sensor_msgs::ImagePtr depth_msg = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_depth).toImageMsg();
-//  depth_msg->header.stamp = camera_timestamp;
-//  depth_pub_.publish(depth_msg);
+  // render the current poses and publish as soon as the frame is back
+  snapshotVehicles();
+  // nobody listens to any image, skip rendering altogether
+  bool rendered = false;
+  if (updateCameraDemand()) {
+    rendered = renderFrame();
+    if (!rendered && unity_ready_) return;  // out of sync, drop the frame
+  }
 
-//#ifdef use_multi
-  // 1st camera
-  rgb_camera_1_->getRGBImage(img_one);
-  sensor_msgs::ImagePtr rgb_msg_one = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_one).toImageMsg();
-  rgb_msg_one->header.stamp = camera_timestamp;
-  rgb_pub_1_.publish(rgb_msg_one);
+  // every vehicle only touches its own camera and publishers
+  const int num_vehicles = vehicles_.size();
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < num_vehicles; i++) {
+    processVehicle(i);
+  }
 
+  // latency from odometry to publishing, only for frames that were rendered
+  if (!rendered) return;
+  const ros::Time now = ros::Time::now();
+  for (auto &vehicle : vehicles_) {
+    if (vehicle->render_stamp.isZero()) continue;
+    latency_.add((now - vehicle->render_stamp).toSec());
+  }
+  if (latency_log_interval_ > 0.0 && latency_.count() > 0 &&
+      (now - last_latency_log_).toSec() > latency_log_interval_) {
+    std::ostringstream ss;
+    ss << latency_;
+    ROS_INFO("[%s] %s", pnh_.getNamespace().c_str(), ss.str().c_str());
+    last_latency_log_ = now;
+  }
+}
 
-//  rgb_camera_1_->getDepthMap(img_two);
-//  sensor_msgs::ImagePtr depth_msg_two = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_two).toImageMsg();
-//  depth_msg_two->header.stamp = camera_timestamp;
-//  depth_pub_1_.publish(depth_msg_two);
+void FlightPilot::processVehicle(const size_t vehicle_idx) {
+  Vehicle &vehicle = *vehicles_[vehicle_idx];
+  const ros::Time stamp = vehicle.render_stamp;
 
-  // 2nd camera
-    rgb_camera_2_->getRGBImage(img_two);
-    sensor_msgs::ImagePtr rgb_msg_two = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_two).toImageMsg();
-    rgb_msg_two->header.stamp = camera_timestamp;
-    rgb_pub_2_.publish(rgb_msg_two);
+  //add Image Data Retrieve
+  cv::Mat img;
+  const bool has_image = vehicle.rgb_camera->getRGBImage(img);
+  if (has_image) {
+    fillImageMsg(img, stamp, vehicle.rgb_msg);
+    vehicle.rgb_pub.publish(vehicle.rgb_msg);
+  }
 
-//#endif
+  cv::Mat depth;
+  if (vehicle.rgb_camera->getDepthMap(depth)) {
+    fillImageMsg(depth, stamp, vehicle.depth_msg);
+    vehicle.depth_pub.publish(vehicle.depth_msg);
+  }
 
   //publish camera_Info
-  camera_info_msg.header.stamp = camera_timestamp;
-  camera_info_pub.publish(camera_info_msg);
-  camera_info_pub_1.publish(camera_info_msg);
-  camera_info_pub_2.publish(camera_info_msg);
-
+  sensor_msgs::CameraInfo camera_info = camera_info_msg;
+  camera_info.header.stamp = stamp;
+  vehicle.camera_info_pub.publish(camera_info);
 
   //================ project 3D into 2D ================
 
-  //lookup TF1,2
-
-  try {
-    tf_listener.lookupTransform("/hummingbird0/base_link_cam","/hummingbird1/base_link",ros::Time(0), tf_transform_relative_0_1);
-    tf_listener.lookupTransform("/hummingbird0/base_link_cam","/hummingbird2/base_link",ros::Time(0), tf_transform_relative_0_2);
-
-    tf_listener.lookupTransform("/hummingbird1/base_link_cam","/hummingbird0/base_link",ros::Time(0), tf_transform_relative_1_0);
-    tf_listener.lookupTransform("/hummingbird1/base_link_cam","/hummingbird2/base_link",ros::Time(0), tf_transform_relative_1_2);
-
-    tf_listener.lookupTransform("/hummingbird2/base_link_cam","/hummingbird0/base_link",ros::Time(0), tf_transform_relative_2_0);
-    tf_listener.lookupTransform("/hummingbird2/base_link_cam","/hummingbird1/base_link",ros::Time(0), tf_transform_relative_2_1);
-
-
-  } catch (tf::TransformException ex){
-    //ROS_WARN("%s",ex.what());
-}
-
-  //get T {x,y,z}
-  geometry_msgs::Point transpose_0_1, transpose_0_2, transpose_1_0, transpose_1_2, transpose_2_0, transpose_2_1;
-  transpose_0_1 = getPose_from_tf(tf_transform_relative_0_1);
-  transpose_0_2 = getPose_from_tf(tf_transform_relative_0_2);
-
-  transpose_1_0 = getPose_from_tf(tf_transform_relative_1_0);
-  transpose_1_2 = getPose_from_tf(tf_transform_relative_1_2);
-
-  transpose_2_0 = getPose_from_tf(tf_transform_relative_2_0);
-  transpose_2_1 = getPose_from_tf(tf_transform_relative_2_1);
-
-
-  //project 3D pose into 2D img coordinate
-  geometry_msgs::Point projected_0_1, projected_0_2, projected_1_0, projected_1_2, projected_2_0, projected_2_1 ;
-  projected_0_1 = project_2d_from_3d(transpose_0_1);
-  projected_0_2 = project_2d_from_3d(transpose_0_2);
-
-  projected_1_0 = project_2d_from_3d(transpose_1_0);
-  projected_1_2 = project_2d_from_3d(transpose_1_2);
-
-  projected_2_0 = project_2d_from_3d(transpose_2_0);
-  projected_2_1 = project_2d_from_3d(transpose_2_1);
-
-
-
   int line_thickness = 2;
   int circle_radius = 4;//8
 
-
-  //draw bounding box
-  img_bounding_box = img.clone();
-  img_bounding_box_one = img_one.clone();
-  img_bounding_box_two = img_two.clone();
-
-
-  //draw green circle
-  cv::circle(img_bounding_box, cv::Point(projected_0_1.x,projected_0_1.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
-  cv::circle(img_bounding_box, cv::Point(projected_0_2.x,projected_0_2.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
-
-  cv::circle(img_bounding_box_one, cv::Point(projected_1_0.x,projected_1_0.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
-  cv::circle(img_bounding_box_one, cv::Point(projected_1_2.x,projected_1_2.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
-
-
-  cv::circle(img_bounding_box_two, cv::Point(projected_2_0.x,projected_2_0.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
-  cv::circle(img_bounding_box_two, cv::Point(projected_2_1.x,projected_2_1.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
-
-
-  //publish bounding box
-  sensor_msgs::ImagePtr box_msg = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_bounding_box).toImageMsg();
-  box_msg->header.stamp = camera_timestamp;
-  rgb_bounding_box_pub_.publish(box_msg);
-
-  sensor_msgs::ImagePtr box_msg_one = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_bounding_box_one).toImageMsg();
-  box_msg_one->header.stamp = camera_timestamp;
-  rgb_bounding_box_pub_one.publish(box_msg_one);
-
-  sensor_msgs::ImagePtr box_msg_two = cv_bridge::CvImage(std_msgs::Header(), "bgr8", img_bounding_box_two).toImageMsg();
-  box_msg_two->header.stamp = camera_timestamp;
-  rgb_bounding_box_pub_two.publish(box_msg_two);
-
-
-//=====================================
-
-  //empty previous frame data
-  while (!bbox_pose_array_zero.poses.empty())
-     {
-     bbox_pose_array_zero.poses.pop_back();
-     }
-
-  //add px,py into vector
-  geometry_msgs::Pose temp_pose;
-  temp_pose.position.x = projected_0_1.x;
-  temp_pose.position.y = projected_0_1.y;
-  bbox_pose_array_zero.poses.push_back(temp_pose);
-  temp_pose.position.x = projected_0_2.x;
-  temp_pose.position.y = projected_0_2.y;
-  bbox_pose_array_zero.poses.push_back(temp_pose);
-
-  //empty previous frame data
-  while (!bbox_pose_array_one.poses.empty())
-     {
-     bbox_pose_array_one.poses.pop_back();
-     }
-
-  //add px,py into vector
-  temp_pose.position.x = projected_1_0.x;
-  temp_pose.position.y = projected_1_0.y;
-  bbox_pose_array_one.poses.push_back(temp_pose);
-  temp_pose.position.x = projected_1_2.x;
-  temp_pose.position.y = projected_1_2.y;
-  bbox_pose_array_one.poses.push_back(temp_pose);
+  //draw bounding box in place on the overlay message, only if needed
+  cv::Mat img_bounding_box;
+  if (has_image && vehicle.rgb_bounding_box_pub.getNumSubscribers() > 0) {
+    img_bounding_box = fillImageMsg(img, stamp, vehicle.box_msg);
+  }
 
   //empty previous frame data
-  while (!bbox_pose_array_two.poses.empty())
-     {
-     bbox_pose_array_two.poses.pop_back();
-     }
-
-  //add px,py into vector
-  temp_pose.position.x = projected_2_0.x;
-  temp_pose.position.y = projected_2_0.y;
-  bbox_pose_array_two.poses.push_back(temp_pose);
-  temp_pose.position.x = projected_2_1.x;
-  temp_pose.position.y = projected_2_1.y;
-  bbox_pose_array_two.poses.push_back(temp_pose);
-
-  //=====================================
-
-  bbox_pose_array_zero.header.stamp = ros::Time::now();
-  bbox_pose_array_one.header.stamp = ros::Time::now();
-  bbox_pose_array_two.header.stamp = ros::Time::now();
-
+  vehicle.bbox_pose_array.poses.clear();
+
+  // entries stay in vehicle order, vehicles that are not visible are
+  // reported at pixel (-1, -1) with zero depth
+  projectVehicles(vehicle_idx);
+  for (size_t j = 0; j < vehicles_.size(); j++) {
+    if (j == vehicle_idx) continue;
+
+    geometry_msgs::Pose temp_pose;
+    temp_pose.position.x = -1;
+    temp_pose.position.y = -1;
+    if (vehicle.visible(j)) {
+      temp_pose.position.x = vehicle.projections(0, j);
+      temp_pose.position.y = vehicle.projections(1, j);
+      temp_pose.position.z = vehicle.projections(2, j);
+
+      //draw green circle
+      if (!img_bounding_box.empty())
+        cv::circle(img_bounding_box, cv::Point(temp_pose.position.x,temp_pose.position.y), circle_radius, cv::Scalar(0,255,0),line_thickness,8,0);
+    }
+
+    //add px,py into vector
+    vehicle.bbox_pose_array.poses.push_back(temp_pose);
+  }
 
+  //publish bounding box
+  if (!img_bounding_box.empty()) {
+    vehicle.rgb_bounding_box_pub.publish(vehicle.box_msg);
+  }
 
   //publish 2D track vector
-  track_bounding_box_pub_zero.publish(bbox_pose_array_zero);
-  track_bounding_box_pub_one.publish(bbox_pose_array_one);
-  track_bounding_box_pub_two.publish(bbox_pose_array_two);
-
+  vehicle.bbox_pose_array.header.stamp = stamp;
+  vehicle.track_bounding_box_pub.publish(vehicle.bbox_pose_array);
+}
 
+cv::Mat FlightPilot::fillImageMsg(const cv::Mat &img, const ros::Time &stamp,
+                                  sensor_msgs::ImagePtr &msg) {
+  // a subscriber in this process may still hold the last message
+  if (!msg || !msg.unique()) msg = boost::make_shared<sensor_msgs::Image>();
+
+  msg->header.stamp = stamp;
+  msg->height = img.rows;
+  msg->width = img.cols;
+  switch (img.type()) {
+    case CV_32FC1:
+      msg->encoding = sensor_msgs::image_encodings::TYPE_32FC1;
+      break;
+    case CV_8UC1:
+      msg->encoding = sensor_msgs::image_encodings::MONO8;
+      break;
+    default:
+      msg->encoding = sensor_msgs::image_encodings::BGR8;
+  }
+  msg->is_bigendian = false;
+  msg->step = img.cols * img.elemSize();
+  msg->data.resize(msg->step * img.rows);
+
+  // single copy into the message buffer, no allocation once it is sized
+  cv::Mat msg_image(img.rows, img.cols, img.type(), msg->data.data(), msg->step);
+  img.copyTo(msg_image);
+  return msg_image;
 }
 
 bool FlightPilot::setUnity(const bool render) {
@@ -494,14 +343,13 @@ bool FlightPilot::setUnity(const bool render) {
   if (unity_render_ && unity_bridge_ptr_ == nullptr) {
     // create unity bridge
     unity_bridge_ptr_ = UnityBridge::getInstance();
+    unity_bridge_ptr_->setCameraUpdates(camera_updates_);
 
-#ifdef use_multi
-    unity_bridge_ptr_->addQuadrotor(quad_ptr_1_);
-    unity_bridge_ptr_->addQuadrotor(quad_ptr_2_);
-
-#endif
-
-    unity_bridge_ptr_->addQuadrotor(quad_ptr_);
+    // the first vehicle is added last, as in the original scene setup
+    for (size_t i = 1; i < vehicles_.size(); i++) {
+      unity_bridge_ptr_->addQuadrotor(vehicles_[i]->quad_ptr);
+    }
+    if (!vehicles_.empty()) unity_bridge_ptr_->addQuadrotor(vehicles_[0]->quad_ptr);
 
     ROS_WARN("[%s] Unity Bridge is created.", pnh_.getNamespace().c_str());
   }
@@ -518,6 +366,22 @@ bool FlightPilot::loadParams(void) {
   // load parameters
   quadrotor_common::getParam("main_loop_freq", main_loop_freq_, pnh_);
   quadrotor_common::getParam("unity_render", unity_render_, pnh_);
+  quadrotor_common::getParam("latency_log_interval", latency_log_interval_,
+                             latency_log_interval_, pnh_);
+
+  // vehicles, their topics are prefixed with the vehicle name
+  if (!pnh_.getParam("vehicles", vehicle_names_) || vehicle_names_.empty()) {
+    vehicle_names_ = {"hummingbird0", "hummingbird1", "hummingbird2"};
+    ROS_WARN("[%s] No vehicles given, using %s.", pnh_.getNamespace().c_str(),
+             "hummingbird0, hummingbird1, hummingbird2");
+  }
+
+  // camera shared by all vehicles
+  quadrotor_common::getParam("camera_width", camera_width_, camera_width_, pnh_);
+  quadrotor_common::getParam("camera_height", camera_height_, camera_height_, pnh_);
+  quadrotor_common::getParam("camera_fov", camera_fov_, camera_fov_, pnh_);
+  quadrotor_common::getParam("camera_offset", camera_offset_, camera_offset_, pnh_);
+  quadrotor_common::getParam("camera_updates", camera_updates_, camera_updates_, pnh_);
 
   return true;
 }
@@ -0,0 +1,362 @@
+// Offline rendering of recorded flights.
+//
+// Reads a pose file and renders one frame per line, as fast as Unity returns
+// the images, independent of ROS time. Images are encoded by a pool of worker
+// threads and written into a chunked dataset:
+//
+//   output_dir/chunk_000000/000000_0_rgb.png
+//                           000000_0_depth.tiff
+//                           ...
+//                           index.csv   (written once the chunk is complete)
+//
+// Every image is written to a temporary file and renamed once it is done, so
+// an interrupted run can be resumed: complete chunks are skipped and frames of
+// the first incomplete chunk are only rendered again if an image is missing.
+//
+// Pose file: one frame per line, a timestamp followed by
+// "x y z qw qx qy qz" for every vehicle, in the flightmare world frame.
+// Empty lines and lines starting with '#' are ignored.
+
+#include <ros/ros.h>
+
+#include <condition_variable>
+#include <deque>
+#include <experimental/filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include <opencv2/imgcodecs.hpp>
+
+// rpg quadrotor
+#include <quadrotor_common/parameter_helper.h>
+
+// flightlib
+#include "flightlib/bridges/unity_bridge.hpp"
+#include "flightlib/common/quad_state.hpp"
+#include "flightlib/common/types.hpp"
+#include "flightlib/objects/quadrotor.hpp"
+#include "flightlib/sensors/rgb_camera.hpp"
+
+using namespace flightlib;
+namespace fs = std::experimental::filesystem;
+
+namespace {
+
+struct PoseFrame {
+  double t;
+  // [x y z qw qx qy qz] per vehicle
+  std::vector<Vector<7>, Eigen::aligned_allocator<Vector<7>>> poses;
+};
+
+// images of one rendered frame, waiting to be encoded
+struct EncodeJob {
+  int frame;
+  std::vector<std::string> files;
+  std::vector<cv::Mat> images;
+};
+
+bool loadPoseFile(const std::string& file, std::vector<PoseFrame>& frames) {
+  std::ifstream in(file);
+  if (!in.is_open()) {
+    ROS_ERROR("Cannot open pose file %s.", file.c_str());
+    return false;
+  }
+  std::string line;
+  int num_vehicles = -1;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream ss(line);
+    std::vector<double> values;
+    double value;
+    while (ss >> value) values.push_back(value);
+    if (values.size() < 8 || (values.size() - 1) % 7 != 0 ||
+        (num_vehicles >= 0 && (int)(values.size() - 1) / 7 != num_vehicles)) {
+      ROS_ERROR("Invalid pose line %lu in %s.", frames.size(), file.c_str());
+      return false;
+    }
+    num_vehicles = (values.size() - 1) / 7;
+
+    PoseFrame frame;
+    frame.t = values[0];
+    for (int i = 0; i < num_vehicles; i++) {
+      Vector<7> pose;
+      for (int j = 0; j < 7; j++) pose(j) = values[1 + 7 * i + j];
+      frame.poses.push_back(pose);
+    }
+    frames.push_back(frame);
+  }
+  return !frames.empty();
+}
+
+std::string chunkDir(const std::string& output_dir, const int chunk) {
+  char name[32];
+  snprintf(name, sizeof(name), "chunk_%06d", chunk);
+  return (fs::path(output_dir) / name).string();
+}
+
+std::string imageFile(const std::string& dir, const int frame,
+                      const int vehicle, const std::string& layer,
+                      const std::string& extension) {
+  char name[64];
+  snprintf(name, sizeof(name), "%06d_%d_%s.%s", frame, vehicle, layer.c_str(),
+           extension.c_str());
+  return (fs::path(dir) / name).string();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ros::init(argc, argv, "replay_render");
+  ros::NodeHandle pnh("~");
+
+  // load parameters
+  std::string pose_file, output_dir, image_format{"png"};
+  int scene_id{UnityScene::WAREHOUSE};
+  int chunk_size{1000}, num_workers{4};
+  int camera_width{640}, camera_height{480};
+  Scalar camera_fov{90.0};
+  bool depth{false}, segmentation{false};
+  if (!quadrotor_common::getParam("pose_file", pose_file, pnh) ||
+      !quadrotor_common::getParam("output_dir", output_dir, pnh)) {
+    return 1;
+  }
+  quadrotor_common::getParam("scene_id", scene_id, scene_id, pnh);
+  quadrotor_common::getParam("chunk_size", chunk_size, chunk_size, pnh);
+  quadrotor_common::getParam("num_workers", num_workers, num_workers, pnh);
+  quadrotor_common::getParam("image_format", image_format, image_format, pnh);
+  quadrotor_common::getParam("camera_width", camera_width, camera_width, pnh);
+  quadrotor_common::getParam("camera_height", camera_height, camera_height,
+                             pnh);
+  quadrotor_common::getParam("camera_fov", camera_fov, camera_fov, pnh);
+  quadrotor_common::getParam("depth", depth, depth, pnh);
+  quadrotor_common::getParam("segmentation", segmentation, segmentation, pnh);
+  chunk_size = std::max(chunk_size, 1);
+  num_workers = std::max(num_workers, 1);
+
+  std::vector<PoseFrame> frames;
+  if (!loadPoseFile(pose_file, frames)) return 1;
+  const int num_frames = frames.size();
+  const int num_vehicles = frames[0].poses.size();
+  const int num_chunks = (num_frames + chunk_size - 1) / chunk_size;
+  ROS_INFO("Loaded %d frames of %d vehicles from %s.", num_frames,
+           num_vehicles, pose_file.c_str());
+
+  // layers to write, the first one is always rgb
+  std::vector<std::pair<int, std::string>> layers{{0, "rgb"}};
+  if (depth) layers.push_back({CameraLayer::DepthMap, "depth"});
+  if (segmentation) layers.push_back({CameraLayer::Segmentation, "segmentation"});
+  auto extension = [&image_format](const int layer) {
+    // depth is float, keep it lossless
+    return layer == CameraLayer::DepthMap ? std::string("tiff") : image_format;
+  };
+  auto frameComplete = [&](const int frame) {
+    const std::string dir = chunkDir(output_dir, frame / chunk_size);
+    for (int v = 0; v < num_vehicles; v++) {
+      for (const auto& layer : layers) {
+        if (!fs::exists(imageFile(dir, frame, v, layer.second,
+                                  extension(layer.first))))
+          return false;
+      }
+    }
+    return true;
+  };
+
+  // resume: skip complete chunks, then frames that are already on disk
+  int start_frame = 0;
+  while (start_frame < num_frames &&
+         fs::exists(fs::path(chunkDir(output_dir, start_frame / chunk_size)) /
+                    "index.csv")) {
+    start_frame += chunk_size;
+  }
+  start_frame = std::min(start_frame, num_frames);
+  std::vector<int> todo;
+  for (int f = start_frame; f < num_frames; f++) {
+    if (!frameComplete(f)) todo.push_back(f);
+  }
+  // frames still to be written per chunk, the index is written at zero
+  std::vector<int> chunk_pending(num_chunks, 0);
+  for (const int f : todo) chunk_pending[f / chunk_size]++;
+  auto writeIndex = [&](const int chunk) {
+    std::ofstream index(
+      (fs::path(chunkDir(output_dir, chunk)) / "index.csv").string());
+    index << "frame,t\n";
+    const int end = std::min((chunk + 1) * chunk_size, num_frames);
+    for (int f = chunk * chunk_size; f < end; f++) {
+      index << f << "," << std::setprecision(17) << frames[f].t << "\n";
+    }
+  };
+
+  // chunks that were fully written before the index could be written
+  for (int c = start_frame / chunk_size; c < num_chunks; c++) {
+    if (chunk_pending[c] == 0) writeIndex(c);
+  }
+  ROS_INFO("Resuming at frame %d, %lu frames to render.", start_frame,
+           todo.size());
+
+  // unity quadrotors
+  std::vector<std::shared_ptr<Quadrotor>> quads;
+  std::vector<std::shared_ptr<RGBCamera>> cameras;
+  std::shared_ptr<UnityBridge> unity_bridge_ptr = UnityBridge::getInstance();
+  for (int v = 0; v < num_vehicles; v++) {
+    std::shared_ptr<Quadrotor> quad_ptr = std::make_shared<Quadrotor>();
+    std::shared_ptr<RGBCamera> rgb_camera = std::make_shared<RGBCamera>();
+    Vector<3> B_r_BC(0.0, 0.0, 0.3);
+    Matrix<3, 3> R_BC = Quaternion(1.0, 0.0, 0.0, 0.0).toRotationMatrix();
+    rgb_camera->setFOV(camera_fov);
+    rgb_camera->setWidth(camera_width);
+    rgb_camera->setHeight(camera_height);
+    rgb_camera->setRelPose(B_r_BC, R_BC);
+    rgb_camera->setPostProcesscing(std::vector<bool>{
+      depth, segmentation, false});  // depth, segmentation, optical flow
+    quad_ptr->addRGBCamera(rgb_camera);
+    QuadState quad_state;
+    quad_state.setZero();
+    quad_ptr->reset(quad_state);
+    unity_bridge_ptr->addQuadrotor(quad_ptr);
+    quads.push_back(quad_ptr);
+    cameras.push_back(rgb_camera);
+  }
+
+  // encoding workers, the queue is bounded so rendering cannot run away
+  std::mutex queue_mutex;
+  std::condition_variable queue_cond;
+  std::deque<EncodeJob> queue;
+  const size_t max_queue_size = 4 * num_workers;
+  bool rendering_done = false;
+  std::mutex chunk_mutex;
+
+  auto worker = [&]() {
+    while (true) {
+      EncodeJob job;
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_cond.wait(lock, [&] { return !queue.empty() || rendering_done; });
+        if (queue.empty()) return;
+        job = std::move(queue.front());
+        queue.pop_front();
+      }
+      queue_cond.notify_all();
+
+      bool written = true;
+      for (size_t i = 0; i < job.images.size(); i++) {
+        // write to a temporary file first, a file with the final name is
+        // always complete
+        const fs::path tmp_file = job.files[i] + ".tmp";
+        const std::string tmp_ext = fs::path(job.files[i]).extension().string();
+        std::vector<uchar> buffer;
+        if (job.images[i].empty() ||
+            !cv::imencode(tmp_ext, job.images[i], buffer)) {
+          ROS_WARN("Cannot encode %s.", job.files[i].c_str());
+          written = false;
+          continue;
+        }
+        std::ofstream out(tmp_file.string(), std::ios::binary);
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        out.close();
+        // a full disk or missing permissions must not end the worker, the
+        // image is simply missing and rendered again on resume
+        std::error_code error;
+        if (!out.good()) {
+          ROS_WARN("Cannot write %s.", tmp_file.c_str());
+          fs::remove(tmp_file, error);
+          written = false;
+          continue;
+        }
+        fs::rename(tmp_file, job.files[i], error);
+        if (error) {
+          ROS_WARN("Cannot rename %s: %s.", tmp_file.c_str(),
+                   error.message().c_str());
+          fs::remove(tmp_file, error);
+          written = false;
+        }
+      }
+
+      // a chunk with a missing image gets no index and is redone on resume
+      if (!written) continue;
+      const int chunk = job.frame / chunk_size;
+      std::lock_guard<std::mutex> lock(chunk_mutex);
+      if (--chunk_pending[chunk] == 0) writeIndex(chunk);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int i = 0; i < num_workers; i++) workers.emplace_back(worker);
+
+  // connect unity
+  const bool unity_ready = unity_bridge_ptr->connectUnity(scene_id);
+
+  ros::WallTime t_start = ros::WallTime::now();
+  int num_rendered = 0;
+  bool output_error = false;
+  for (size_t i = 0; i < todo.size() && unity_ready && ros::ok(); i++) {
+    const int f = todo[i];
+    const std::string dir = chunkDir(output_dir, f / chunk_size);
+    // an unwritable output path ends the replay, every frame would fail
+    std::error_code error;
+    fs::create_directories(dir, error);
+    if (error) {
+      ROS_ERROR("Cannot create %s: %s.", dir.c_str(), error.message().c_str());
+      output_error = true;
+      break;
+    }
+
+    QuadState quad_state;
+    quad_state.setZero();
+    for (int v = 0; v < num_vehicles; v++) {
+      quad_state.p = frames[f].poses[v].head<3>();
+      quad_state.x.segment<4>(QS::ATT) = frames[f].poses[v].tail<4>();
+      quads[v]->setState(quad_state);
+    }
+
+    // the images are only written if the reply belongs to this frame,
+    // otherwise the frame stays missing and is rendered again on resume
+    unity_bridge_ptr->getRender(f);
+    if (!unity_bridge_ptr->handleOutput((FrameID)f)) {
+      ROS_WARN("Did not receive frame %d, skipping it.", f);
+      continue;
+    }
+
+    EncodeJob job;
+    job.frame = f;
+    for (int v = 0; v < num_vehicles; v++) {
+      for (const auto& layer : layers) {
+        cv::Mat img;
+        if (layer.first == 0) cameras[v]->getRGBImage(img);
+        if (layer.first == CameraLayer::DepthMap) cameras[v]->getDepthMap(img);
+        if (layer.first == CameraLayer::Segmentation)
+          cameras[v]->getSegmentation(img);
+        job.files.push_back(
+          imageFile(dir, f, v, layer.second, extension(layer.first)));
+        job.images.push_back(img);
+      }
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      queue_cond.wait(lock, [&] { return queue.size() < max_queue_size; });
+      queue.push_back(std::move(job));
+    }
+    queue_cond.notify_all();
+
+    num_rendered++;
+    if (num_rendered % 100 == 0) {
+      ROS_INFO("Rendered %d / %lu frames, %.1f fps.", num_rendered,
+               todo.size(),
+               num_rendered / (ros::WallTime::now() - t_start).toSec());
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    rendering_done = true;
+  }
+  queue_cond.notify_all();
+  for (auto& w : workers) w.join();
+
+  ROS_INFO("Rendered %d frames in %.1f s.", num_rendered,
+           (ros::WallTime::now() - t_start).toSec());
+  return unity_ready && !output_error ? 0 : 1;
+}
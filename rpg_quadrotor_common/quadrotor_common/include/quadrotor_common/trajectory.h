@@ -1,7 +1,8 @@
 #pragma once
 
-#include <list>
+#include <vector>
 
+#include <Eigen/StdVector>
 #include <quadrotor_msgs/Trajectory.h>
 #include <nav_msgs/Path.h>
 #include <ros/time.h>
@@ -16,12 +17,35 @@ struct Trajectory
   Trajectory();
   Trajectory(const quadrotor_msgs::Trajectory& trajectory_msg);
   Trajectory(const quadrotor_common::TrajectoryPoint& point);
+  Trajectory(const Trajectory& trajectory) = default;
+  Trajectory(Trajectory&& trajectory) = default;
   virtual ~Trajectory();
 
+  Trajectory& operator=(const Trajectory& trajectory) = default;
+  Trajectory& operator=(Trajectory&& trajectory) = default;
+
+  // Streaming updates of a trajectory. The message points are shifted by the
+  // difference of the message stamp and timestamp and replace the points from
+  // the time of its first point on, so the cost only depends on the number of
+  // new points. Messages of another trajectory type are rejected.
+  bool appendPoints(const quadrotor_msgs::Trajectory& trajectory_msg);
+  // Erases the points that are not needed anymore for the states at
+  // time_from_start and later, but only once they make up at least half of
+  // the points. Most calls therefore keep all points, calling this in every
+  // update costs amortized constant time per erased point.
+  void compactPointsBefore(const ros::Duration& time_from_start);
+
   quadrotor_msgs::Trajectory toRosMessage() const;
   nav_msgs::Path toRosPath() const;
+  // Interpolates between the points around time_from_start, which are found
+  // by binary search
   quadrotor_common::TrajectoryPoint getStateAtTime(
     const ros::Duration& time_from_start) const;
+  // Same for increasing query times, cursor keeps the index of the point
+  // before the last query time and the search continues from there. It can
+  // start at 0 and stays valid if the trajectory changes.
+  quadrotor_common::TrajectoryPoint getStateAtTime(
+    const ros::Duration& time_from_start, size_t* cursor) const;
 
   ros::Time timestamp;
 
@@ -30,7 +54,9 @@ struct Trajectory
     UNDEFINED, GENERAL, ACCELERATION, JERK, SNAP
   } trajectory_type;
 
-  std::list<quadrotor_common::TrajectoryPoint> points;
+  // Ordered by time_from_start
+  std::vector<quadrotor_common::TrajectoryPoint,
+    Eigen::aligned_allocator<quadrotor_common::TrajectoryPoint>> points;
 };
 
 } // namespace quadrotor_common
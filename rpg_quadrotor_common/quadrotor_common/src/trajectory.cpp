@@ -1,5 +1,6 @@
 #include "quadrotor_common/trajectory.h"
 
+#include <algorithm>
 #include <Eigen/Dense>
 
 #include "quadrotor_common/math_common.h"
@@ -7,35 +8,68 @@
 namespace quadrotor_common
 {
 
-Trajectory::Trajectory() :
-  timestamp(ros::Time::now()), trajectory_type(TrajectoryType::UNDEFINED),
-  points()
+namespace
 {
-}
 
-Trajectory::Trajectory(const quadrotor_msgs::Trajectory& trajectory_msg)
+// Index of the last point at or before time_from_start, searching forward
+// from first_index which has to be at or before it
+size_t findPointBefore(const Trajectory& trajectory,
+                       const ros::Duration& time_from_start,
+                       const size_t first_index)
 {
-  timestamp = trajectory_msg.header.stamp;
+  // Increasing query times mostly end up on the same or one of the next points
+  const size_t max_linear_steps = 4;
+  size_t index = first_index;
+  for (size_t step = 0; step < max_linear_steps; step++)
+  {
+    if (index + 1 >= trajectory.points.size()
+        || trajectory.points[index + 1].time_from_start > time_from_start)
+    {
+      return index;
+    }
+    index++;
+  }
+
+  const auto after = std::upper_bound(
+    trajectory.points.begin() + index + 1, trajectory.points.end(),
+    time_from_start,
+    [](const ros::Duration& time, const TrajectoryPoint& point)
+    { return time < point.time_from_start; });
+  return (after - trajectory.points.begin()) - 1;
+}
 
+Trajectory::TrajectoryType trajectoryTypeFromMessage(
+  const quadrotor_msgs::Trajectory& trajectory_msg)
+{
   switch (trajectory_msg.type)
   {
   case quadrotor_msgs::Trajectory::GENERAL:
-    trajectory_type = TrajectoryType::GENERAL;
-    break;
+    return Trajectory::TrajectoryType::GENERAL;
   case quadrotor_msgs::Trajectory::ACCELERATION:
-    trajectory_type = TrajectoryType::ACCELERATION;
-    break;
+    return Trajectory::TrajectoryType::ACCELERATION;
   case quadrotor_msgs::Trajectory::JERK:
-    trajectory_type = TrajectoryType::JERK;
-    break;
+    return Trajectory::TrajectoryType::JERK;
   case quadrotor_msgs::Trajectory::SNAP:
-    trajectory_type = TrajectoryType::SNAP;
-    break;
+    return Trajectory::TrajectoryType::SNAP;
   default:
-    trajectory_type = TrajectoryType::UNDEFINED;
-    break;
+    return Trajectory::TrajectoryType::UNDEFINED;
   }
+}
+
+} // namespace
 
+Trajectory::Trajectory() :
+  timestamp(ros::Time::now()), trajectory_type(TrajectoryType::UNDEFINED),
+  points()
+{
+}
+
+Trajectory::Trajectory(const quadrotor_msgs::Trajectory& trajectory_msg)
+{
+  timestamp = trajectory_msg.header.stamp;
+  trajectory_type = trajectoryTypeFromMessage(trajectory_msg);
+
+  points.reserve(trajectory_msg.points.size());
   for (int i = 0; i < trajectory_msg.points.size(); i++)
   {
     points.push_back(
@@ -54,6 +88,58 @@ Trajectory::~Trajectory()
 {
 }
 
+bool Trajectory::appendPoints(
+  const quadrotor_msgs::Trajectory& trajectory_msg)
+{
+  if (trajectory_msg.points.empty())
+  {
+    return true;
+  }
+  if (points.empty())
+  {
+    timestamp = trajectory_msg.header.stamp;
+    trajectory_type = trajectoryTypeFromMessage(trajectory_msg);
+  }
+  else if (trajectoryTypeFromMessage(trajectory_msg) != trajectory_type)
+  {
+    return false;
+  }
+
+  // Start of the message time base relative to timestamp
+  const ros::Duration time_offset = trajectory_msg.header.stamp - timestamp;
+  const ros::Duration start_time =
+    trajectory_msg.points.front().time_from_start + time_offset;
+  const auto first_replaced = std::lower_bound(
+    points.begin(), points.end(), start_time,
+    [](const TrajectoryPoint& point, const ros::Duration& time)
+    { return point.time_from_start < time; });
+  points.erase(first_replaced, points.end());
+
+  for (int i = 0; i < trajectory_msg.points.size(); i++)
+  {
+    points.push_back(
+      quadrotor_common::TrajectoryPoint(trajectory_msg.points[i]));
+    points.back().time_from_start += time_offset;
+  }
+
+  return true;
+}
+
+void Trajectory::compactPointsBefore(const ros::Duration& time_from_start)
+{
+  if (points.empty())
+  {
+    return;
+  }
+
+  // The last point at or before time_from_start is kept for interpolating
+  const size_t first_needed = findPointBefore(*this, time_from_start, 0);
+  if (2 * first_needed >= points.size())
+  {
+    points.erase(points.begin(), points.begin() + first_needed);
+  }
+}
+
 quadrotor_msgs::Trajectory Trajectory::toRosMessage() const
 {
   quadrotor_msgs::Trajectory ros_msg;
@@ -79,10 +165,10 @@ quadrotor_msgs::Trajectory Trajectory::toRosMessage() const
       break;
   }
 
-  std::list<quadrotor_common::TrajectoryPoint>::const_iterator it;
-  for (it = points.begin(); it != points.end(); it++)
+  ros_msg.points.reserve(points.size());
+  for (const quadrotor_common::TrajectoryPoint& point : points)
   {
-    ros_msg.points.push_back(it->toRosMessage());
+    ros_msg.points.push_back(point.toRosMessage());
   }
 
   return ros_msg;
@@ -97,17 +183,17 @@ nav_msgs::Path Trajectory::toRosPath() const
 
   geometry_msgs::PoseStamped pose;
 
-  std::list<quadrotor_common::TrajectoryPoint>::const_iterator it;
-  for (it = points.begin(); it != points.end(); it++)
+  path_msg.poses.reserve(points.size());
+  for (const quadrotor_common::TrajectoryPoint& point : points)
   {
-    pose.header.stamp = t + it->time_from_start;
-    pose.pose.position.x = it->position.x();
-    pose.pose.position.y = it->position.y();
-    pose.pose.position.z = it->position.z();
-    pose.pose.orientation.w = it->orientation.w();
-    pose.pose.orientation.x = it->orientation.x();
-    pose.pose.orientation.y = it->orientation.y();
-    pose.pose.orientation.z = it->orientation.z();
+    pose.header.stamp = t + point.time_from_start;
+    pose.pose.position.x = point.position.x();
+    pose.pose.position.y = point.position.y();
+    pose.pose.position.z = point.position.z();
+    pose.pose.orientation.w = point.orientation.w();
+    pose.pose.orientation.x = point.orientation.x();
+    pose.pose.orientation.y = point.orientation.y();
+    pose.pose.orientation.z = point.orientation.z();
     path_msg.poses.push_back(pose);
   }
 
@@ -116,34 +202,40 @@ nav_msgs::Path Trajectory::toRosPath() const
 
 quadrotor_common::TrajectoryPoint Trajectory::getStateAtTime(
   const ros::Duration& time_from_start) const
+{
+  size_t cursor = 0;
+  return getStateAtTime(time_from_start, &cursor);
+}
+
+quadrotor_common::TrajectoryPoint Trajectory::getStateAtTime(
+  const ros::Duration& time_from_start, size_t* cursor) const
 {
   if (time_from_start <= points.front().time_from_start)
   {
+    *cursor = 0;
     return points.front();
   }
   if (time_from_start >= points.back().time_from_start)
   {
+    *cursor = points.size() - 1;
     return points.back();
   }
 
-  quadrotor_common::TrajectoryPoint trajectory_point;
-
   // Find points p0 and p1 such that
-  // p0.time_from_start <= time_from_start <= p1.time_from_start
-  std::list<quadrotor_common::TrajectoryPoint>::const_iterator p1;
-  for (p1 = points.begin(); p1 != points.end(); p1++)
+  // p0.time_from_start <= time_from_start < p1.time_from_start
+  size_t first_index = *cursor;
+  if (first_index >= points.size()
+      || points[first_index].time_from_start > time_from_start)
   {
-    if (p1->time_from_start > time_from_start)
-    {
-      break;
-    }
+    first_index = 0;
   }
-  std::list<quadrotor_common::TrajectoryPoint>::const_iterator p0 = std::prev(
-    p1);
-  const double interp_ratio = (time_from_start - p0->time_from_start).toSec()
-    / (p1->time_from_start - p0->time_from_start).toSec();
+  *cursor = findPointBefore(*this, time_from_start, first_index);
+  const quadrotor_common::TrajectoryPoint& p0 = points[*cursor];
+  const quadrotor_common::TrajectoryPoint& p1 = points[*cursor + 1];
+  const double interp_ratio = (time_from_start - p0.time_from_start).toSec()
+    / (p1.time_from_start - p0.time_from_start).toSec();
 
-  return interpolate(*p0, *p1, interp_ratio);
+  return interpolate(p0, p1, interp_ratio);
 }
 
 } // namespace quadrotor_common
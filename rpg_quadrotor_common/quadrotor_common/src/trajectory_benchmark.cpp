@@ -0,0 +1,226 @@
+#include <chrono>
+#include <cstdio>
+#include <list>
+#include <random>
+#include <vector>
+
+#include <ros/time.h>
+
+#include "quadrotor_common/math_common.h"
+#include "quadrotor_common/trajectory.h"
+
+// Times the queries of a sampled trajectory against the linear scan through a
+// std::list of points it used before, random queries with binary search and
+// increasing queries as in a control loop with a cursor, and the conversion
+// to ROS messages. The last table streams a reference with num_points points
+// ahead at 100Hz, once rebuilt from the full message in every update and once
+// updated with the new points only.
+// Exits with 1 if the queries with and without cursor, the list and the vector
+// or the streamed and rebuilt references do not agree.
+// usage: trajectory_benchmark [num_points] [num_queries]
+
+namespace
+{
+
+double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()
+      - start).count();
+}
+
+quadrotor_common::TrajectoryPoint getStateAtTimeLinear(
+  const std::list<quadrotor_common::TrajectoryPoint>& points,
+  const ros::Duration& time_from_start)
+{
+  if (time_from_start <= points.front().time_from_start)
+  {
+    return points.front();
+  }
+  if (time_from_start >= points.back().time_from_start)
+  {
+    return points.back();
+  }
+
+  std::list<quadrotor_common::TrajectoryPoint>::const_iterator p1;
+  for (p1 = points.begin(); p1 != points.end(); p1++)
+  {
+    if (p1->time_from_start > time_from_start)
+    {
+      break;
+    }
+  }
+  std::list<quadrotor_common::TrajectoryPoint>::const_iterator p0 = std::prev(
+    p1);
+  const double interp_ratio = (time_from_start - p0->time_from_start).toSec()
+    / (p1->time_from_start - p0->time_from_start).toSec();
+
+  return quadrotor_common::interpolate(*p0, *p1, interp_ratio);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  ros::Time::init();
+
+  const int num_points = argc > 1 ? atoi(argv[1]) : 10000;
+  const int num_queries = argc > 2 ? atoi(argv[2]) : 10000;
+
+  // 100Hz samples of a smooth trajectory
+  const double dt = 0.01;
+  quadrotor_common::Trajectory trajectory;
+  trajectory.trajectory_type =
+    quadrotor_common::Trajectory::TrajectoryType::GENERAL;
+  for (int i = 0; i < num_points; i++)
+  {
+    const double t = i * dt;
+    quadrotor_common::TrajectoryPoint point;
+    point.time_from_start = ros::Duration(t);
+    point.position = Eigen::Vector3d(cos(t), sin(t), 0.1 * t);
+    point.velocity = Eigen::Vector3d(-sin(t), cos(t), 0.1);
+    point.acceleration = Eigen::Vector3d(-cos(t), -sin(t), 0.0);
+    trajectory.points.push_back(point);
+  }
+  const std::list<quadrotor_common::TrajectoryPoint> list_points(
+    trajectory.points.begin(), trajectory.points.end());
+  const double duration = (num_points - 1) * dt;
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> random_time(0.0, duration);
+  std::vector<ros::Duration> random_times(num_queries);
+  std::vector<ros::Duration> increasing_times(num_queries);
+  for (int i = 0; i < num_queries; i++)
+  {
+    random_times[i] = ros::Duration(random_time(generator));
+    // control loop running along the whole trajectory
+    increasing_times[i] = ros::Duration(duration * (i + 0.5) / num_queries);
+  }
+
+  bool mismatch = false;
+  printf("%10s %10s %12s %12s %12s %14s\n", "points", "queries", "order",
+         "list [us]", "vector [us]", "max difference");
+  for (const bool increasing : {false, true})
+  {
+    const std::vector<ros::Duration>& times =
+      increasing ? increasing_times : random_times;
+
+    std::vector<quadrotor_common::TrajectoryPoint,
+      Eigen::aligned_allocator<quadrotor_common::TrajectoryPoint>>
+      list_states(num_queries), states(num_queries);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_queries; i++)
+    {
+      list_states[i] = getStateAtTimeLinear(list_points, times[i]);
+    }
+    const double list_time = secondsSince(start) / num_queries;
+
+    start = std::chrono::steady_clock::now();
+    size_t cursor = 0;
+    for (int i = 0; i < num_queries; i++)
+    {
+      states[i] = increasing ? trajectory.getStateAtTime(times[i], &cursor)
+                             : trajectory.getStateAtTime(times[i]);
+    }
+    const double vector_time = secondsSince(start) / num_queries;
+
+    double max_difference = 0.0;
+    for (int i = 0; i < num_queries; i++)
+    {
+      max_difference = std::max(max_difference,
+                                (states[i].position
+                                 - list_states[i].position).norm());
+      if (increasing)
+      {
+        // the cursor must not change the result of the binary search
+        const quadrotor_common::TrajectoryPoint state =
+          trajectory.getStateAtTime(times[i]);
+        if (states[i].position != state.position
+            || states[i].velocity != state.velocity
+            || states[i].acceleration != state.acceleration)
+        {
+          mismatch = true;
+        }
+      }
+    }
+    if (!(max_difference <= 1e-9))
+    {
+      mismatch = true;
+    }
+    printf("%10d %10d %12s %12.3f %12.3f %14.2e\n", num_points, num_queries,
+           increasing ? "increasing" : "random", 1e6 * list_time,
+           1e6 * vector_time, max_difference);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  const quadrotor_msgs::Trajectory msg = trajectory.toRosMessage();
+  const double message_time = secondsSince(start);
+  start = std::chrono::steady_clock::now();
+  const nav_msgs::Path path = trajectory.toRosPath();
+  const double path_time = secondsSince(start);
+  start = std::chrono::steady_clock::now();
+  const quadrotor_common::Trajectory converted(msg);
+  const double conversion_time = secondsSince(start);
+  printf("\ntoRosMessage %.3f ms, toRosPath %.3f ms, from message %.3f ms\n",
+         1e3 * message_time, 1e3 * path_time, 1e3 * conversion_time);
+
+  // Every update moves the reference one point ahead and revises the last
+  // points before it
+  const int num_updates = 1000;
+  const int revised_points = 10;
+  quadrotor_msgs::Trajectory stream_msg = msg;
+  for (int i = 0; i < num_updates; i++)
+  {
+    quadrotor_common::TrajectoryPoint point;
+    point.time_from_start = ros::Duration((num_points + i) * dt);
+    stream_msg.points.push_back(point.toRosMessage());
+  }
+
+  double rebuild_time = 0.0;
+  double append_time = 0.0;
+  double max_difference = 0.0;
+  quadrotor_common::Trajectory streamed(msg);
+  quadrotor_msgs::Trajectory full_msg, update_msg;
+  update_msg.header = msg.header;
+  update_msg.type = msg.type;
+  for (int i = 0; i < num_updates; i++)
+  {
+    const ros::Duration current_time(i * dt);
+    full_msg.points.assign(stream_msg.points.begin() + i,
+                           stream_msg.points.begin() + i + num_points + 1);
+    update_msg.points.assign(
+      stream_msg.points.begin() + i + num_points + 1 - revised_points,
+      stream_msg.points.begin() + i + num_points + 1);
+
+    start = std::chrono::steady_clock::now();
+    const quadrotor_common::Trajectory rebuilt(full_msg);
+    rebuild_time += secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    streamed.appendPoints(update_msg);
+    streamed.compactPointsBefore(current_time);
+    append_time += secondsSince(start);
+
+    max_difference = std::max(
+      max_difference,
+      (streamed.getStateAtTime(current_time).position
+       - rebuilt.getStateAtTime(current_time).position).norm()
+      + (streamed.points.back().position - rebuilt.points.back().position)
+        .norm());
+  }
+  printf("\n%10s %10s %12s %12s %14s\n", "points", "updates", "rebuild [us]",
+         "append [us]", "max difference");
+  printf("%10d %10d %12.3f %12.3f %14.2e\n", num_points, num_updates,
+         1e6 * rebuild_time / num_updates, 1e6 * append_time / num_updates,
+         max_difference);
+  if (!(max_difference <= 1e-9))
+  {
+    mismatch = true;
+  }
+
+  if (mismatch)
+  {
+    fprintf(stderr, "\nThe compared results do not agree!\n");
+    return 1;
+  }
+  return 0;
+}
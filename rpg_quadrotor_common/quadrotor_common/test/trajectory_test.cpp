@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include <ros/time.h>
+#include <Eigen/Dense>
+
+#include "quadrotor_common/trajectory.h"
+
+namespace quadrotor_common
+{
+
+namespace
+{
+
+// Unevenly sampled helix
+Trajectory randomTrajectory(const int num_points, std::mt19937* generator)
+{
+  std::uniform_real_distribution<double> time_step(0.005, 0.02);
+  Trajectory trajectory;
+  trajectory.trajectory_type = Trajectory::TrajectoryType::GENERAL;
+  double t = 0.0;
+  for (int i = 0; i < num_points; i++)
+  {
+    TrajectoryPoint point;
+    point.time_from_start = ros::Duration(t);
+    point.position = Eigen::Vector3d(cos(t), sin(t), 0.1 * t);
+    point.velocity = Eigen::Vector3d(-sin(t), cos(t), 0.1);
+    point.acceleration = Eigen::Vector3d(-cos(t), -sin(t), 0.0);
+    trajectory.points.push_back(point);
+    t += time_step(*generator);
+  }
+  return trajectory;
+}
+
+void expectEqualStates(const TrajectoryPoint& state,
+                       const TrajectoryPoint& expected_state,
+                       const double time)
+{
+  EXPECT_TRUE(state.position == expected_state.position) << "t = " << time;
+  EXPECT_TRUE(state.velocity == expected_state.velocity) << "t = " << time;
+  EXPECT_TRUE(state.acceleration == expected_state.acceleration)
+    << "t = " << time;
+}
+
+} // namespace
+
+TEST(Trajectory, GetStateAtTimeWithCursorMatchesWithout)
+{
+  std::mt19937 generator(0);
+  const Trajectory trajectory = randomTrajectory(1000, &generator);
+  const double duration = trajectory.points.back().time_from_start.toSec();
+
+  // increasing times as in a control loop, starting and ending outside of the
+  // trajectory
+  size_t cursor = 0;
+  for (double t = -0.1; t < duration + 0.1; t += 0.003)
+  {
+    const TrajectoryPoint state = trajectory.getStateAtTime(ros::Duration(t),
+                                                            &cursor);
+    ASSERT_LT(cursor, trajectory.points.size());
+    expectEqualStates(state, trajectory.getStateAtTime(ros::Duration(t)), t);
+  }
+
+  // random times, the cursor is ahead of the query time half of the time
+  std::uniform_real_distribution<double> random_time(0.0, duration);
+  for (int i = 0; i < 1000; i++)
+  {
+    const double t = random_time(generator);
+    const TrajectoryPoint state = trajectory.getStateAtTime(ros::Duration(t),
+                                                            &cursor);
+    expectEqualStates(state, trajectory.getStateAtTime(ros::Duration(t)), t);
+  }
+}
+
+TEST(Trajectory, GetStateAtTimeCursorStaysValidAfterCompactingPoints)
+{
+  std::mt19937 generator(1);
+  Trajectory trajectory = randomTrajectory(1000, &generator);
+  const double duration = trajectory.points.back().time_from_start.toSec();
+
+  size_t cursor = 0;
+  for (double t = 0.0; t < duration; t += 0.01)
+  {
+    const ros::Duration time_from_start(t);
+    trajectory.compactPointsBefore(time_from_start);
+    const TrajectoryPoint state = trajectory.getStateAtTime(time_from_start,
+                                                            &cursor);
+    expectEqualStates(state, trajectory.getStateAtTime(time_from_start), t);
+  }
+  // Points before the last query are only kept until they are half of them
+  EXPECT_LT(trajectory.points.size(), 500u);
+}
+
+TEST(Trajectory, AppendPointsRebasesToTheTrajectoryTimestamp)
+{
+  std::mt19937 generator(2);
+  const Trajectory full = randomTrajectory(200, &generator);
+  const size_t first_appended = 150;
+
+  Trajectory trajectory = full;
+  trajectory.timestamp = ros::Time(100.0);
+  trajectory.points.resize(first_appended + 10);
+
+  // Same points, stamped one second later
+  const ros::Duration stamp_offset(1.0);
+  quadrotor_msgs::Trajectory update_msg = full.toRosMessage();
+  update_msg.header.stamp = trajectory.timestamp + stamp_offset;
+  update_msg.points.erase(update_msg.points.begin(),
+                          update_msg.points.begin() + first_appended);
+  for (quadrotor_msgs::TrajectoryPoint& point : update_msg.points)
+  {
+    point.time_from_start = point.time_from_start - stamp_offset;
+  }
+
+  ASSERT_TRUE(trajectory.appendPoints(update_msg));
+  ASSERT_EQ(trajectory.points.size(), full.points.size());
+  for (size_t i = 0; i < full.points.size(); i++)
+  {
+    EXPECT_NEAR(trajectory.points[i].time_from_start.toSec(),
+                full.points[i].time_from_start.toSec(), 1e-9);
+    EXPECT_TRUE(trajectory.points[i].position == full.points[i].position);
+  }
+}
+
+TEST(Trajectory, AppendPointsRejectsOtherTrajectoryTypes)
+{
+  std::mt19937 generator(3);
+  Trajectory trajectory = randomTrajectory(100, &generator);
+  quadrotor_msgs::Trajectory update_msg = trajectory.toRosMessage();
+  update_msg.type = quadrotor_msgs::Trajectory::SNAP;
+  update_msg.points.erase(update_msg.points.begin(),
+                          update_msg.points.begin() + 50);
+
+  EXPECT_FALSE(trajectory.appendPoints(update_msg));
+  EXPECT_EQ(trajectory.points.size(), 100u);
+}
+
+} // namespace quadrotor_common
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  ros::Time::init();
+
+  return RUN_ALL_TESTS();
+}
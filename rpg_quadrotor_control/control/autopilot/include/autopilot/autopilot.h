@@ -171,6 +171,8 @@ class AutoPilot {
   // Trajectory execution variables
   std::list<quadrotor_common::Trajectory> trajectory_queue_;
   ros::Time time_start_trajectory_execution_;
+  // Point of the executed trajectory at the last reference state
+  size_t trajectory_cursor_;
 
   // Control command input variables
   ros::Time time_last_control_command_input_received_;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <utility>
+
 #include <quadrotor_common/geometry_eigen_conversions.h>
 #include <quadrotor_common/math_common.h>
 #include <quadrotor_common/parameter_helper.h>
@@ -40,6 +43,7 @@ AutoPilot<Tcontroller, Tparams>::AutoPilot(const ros::NodeHandle& nh,
       stop_go_to_pose_thread_(false),
       trajectory_queue_(),
       time_start_trajectory_execution_(),
+      trajectory_cursor_(0),
       time_last_control_command_input_received_(),
       last_control_command_input_thrust_high_(false),
       stop_watchdog_thread_(false),
@@ -288,7 +292,7 @@ void AutoPilot<Tcontroller, Tparams>::goToPoseThread() {
 
           if (autopilot_state_ == States::GO_TO_POSE) {
             trajectory_queue_.clear();
-            trajectory_queue_.push_back(go_to_pose_traj);
+            trajectory_queue_.push_back(std::move(go_to_pose_traj));
             setAutoPilotState(States::TRAJECTORY_CONTROL);
           } else {
             ROS_WARN(
@@ -610,6 +614,30 @@ void AutoPilot<Tcontroller, Tparams>::trajectoryCallback(
           pnh_.getNamespace().c_str());
       return;
     }
+  } else if (msg->points.front().time_from_start > ros::Duration(0.0)) {
+    // A trajectory that does not start at its time stamp is a streamed update
+    // of the last trajectory in the queue, it replaces its points from the
+    // time of the first received point on
+    quadrotor_common::Trajectory& last_trajectory = trajectory_queue_.back();
+    const ros::Duration start_time = msg->header.stamp -
+                                     last_trajectory.timestamp +
+                                     msg->points.front().time_from_start;
+    if ((last_trajectory.getStateAtTime(start_time).position -
+         quadrotor_common::geometryToEigen(msg->points.front().pose.position))
+            .norm() > kPositionJumpTolerance_) {
+      ROS_WARN(
+          "[%s] Received trajectory update has a too large jump from the last "
+          "trajectory in the queue, will ignore trajectory",
+          pnh_.getNamespace().c_str());
+      return;
+    }
+    if (!last_trajectory.appendPoints(*msg)) {
+      ROS_WARN(
+          "[%s] Received trajectory update has a different type than the last "
+          "trajectory in the queue, will ignore trajectory",
+          pnh_.getNamespace().c_str());
+    }
+    return;
   } else {
     // Check that there is no jump from the last trajectory in the queue to the
     // newly received one
@@ -624,7 +652,7 @@ void AutoPilot<Tcontroller, Tparams>::trajectoryCallback(
     }
   }
 
-  trajectory_queue_.push_back(quadrotor_common::Trajectory(*msg));
+  trajectory_queue_.emplace_back(*msg);
 
   if (autopilot_state_ != States::TRAJECTORY_CONTROL) {
     setAutoPilotState(States::TRAJECTORY_CONTROL);
@@ -1104,7 +1132,11 @@ AutoPilot<Tcontroller, Tparams>::executeTrajectory(
 
   // Time from trajectory start and corresponding reference state.
   const ros::Duration dt = time_now - time_start_trajectory_execution_;
-  reference_state_ = trajectory_queue_.front().getStateAtTime(dt);
+  reference_state_ =
+      trajectory_queue_.front().getStateAtTime(dt, &trajectory_cursor_);
+  // Points before the current time are not needed anymore, streamed updates
+  // keep appending to the trajectory
+  trajectory_queue_.front().compactPointsBefore(dt);
 
   // New trajectory where we fill in our lookahead horizon.
   reference_trajectory_ = quadrotor_common::Trajectory();
@@ -1119,21 +1151,22 @@ AutoPilot<Tcontroller, Tparams>::executeTrajectory(
   for (std::list<quadrotor_common::Trajectory>::const_iterator it_trajectories =
            trajectory_queue_.begin();
        it_trajectories != trajectory_queue_.end(); it_trajectories++) {
-    // Loop over points on the trajectory
-    for (std::list<quadrotor_common::TrajectoryPoint>::const_iterator
-             it_points = it_trajectories->points.begin();
-         it_points != it_trajectories->points.end(); it_points++) {
+    // First point on the trajectory after the current time
+    const auto it_point = std::upper_bound(
+        it_trajectories->points.begin(), it_trajectories->points.end(),
+        dt.toSec() - time_wrapover,
+        [](const double time, const quadrotor_common::TrajectoryPoint& point) {
+          return time < point.time_from_start.toSec();
+        });
+    if (it_point != it_trajectories->points.end()) {
       // Check wether we reached our lookahead.
       // Use boolen flag to also break the outer loop.
-      if (it_points->time_from_start.toSec() >
+      if (it_point->time_from_start.toSec() >
           (dt.toSec() + predictive_control_lookahead_)) {
         lookahead_reached = true;
-        break;
-      }
-      // Add a point if the time corresponds to a sample on the lookahead.
-      if (it_points->time_from_start.toSec() > (dt.toSec() - time_wrapover)) {
-        reference_trajectory_.points.push_back(*it_points);
-        break;
+      } else {
+        // Add a point if the time corresponds to a sample on the lookahead.
+        reference_trajectory_.points.push_back(*it_point);
       }
     }
     if (lookahead_reached) break;  // Break on boolean flag.
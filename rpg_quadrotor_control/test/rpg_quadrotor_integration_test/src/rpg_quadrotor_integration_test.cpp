@@ -189,9 +189,8 @@ void QuadrotorIntegrationTest::run() {
       start_state.heading, end_state.heading, &manual_traj);
 
   bool autopilot_was_in_reference_control_mode = false;
-  while (ros::ok() && !manual_traj.points.empty()) {
-    autopilot_helper_.sendReferenceState(manual_traj.points.front());
-    manual_traj.points.pop_front();
+  for (size_t i = 0; ros::ok() && i < manual_traj.points.size(); i++) {
+    autopilot_helper_.sendReferenceState(manual_traj.points[i]);
     ros::spinOnce();
     if (!autopilot_was_in_reference_control_mode &&
         autopilot_helper_.getCurrentAutopilotState() ==
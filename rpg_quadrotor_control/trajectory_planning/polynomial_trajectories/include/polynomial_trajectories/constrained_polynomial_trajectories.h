@@ -31,7 +31,7 @@ Eigen::VectorXd computeConstraintMatriceB(
     const int order_of_continuity,
     const quadrotor_common::TrajectoryPoint& state, const int axis);
 
-std::vector<Eigen::MatrixXd> computeTrajectoryCoeff(
+PolynomialCoefficients computeTrajectoryCoeff(
     const quadrotor_common::TrajectoryPoint& s0,
     const quadrotor_common::TrajectoryPoint& s1, const int order_of_continuity,
     const double T);
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <quadrotor_common/trajectory_point.h>
+#include <ros/time.h>
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseLU>
 
 #include "polynomial_trajectories/polynomial_trajectory.h"
 #include "polynomial_trajectories/polynomial_trajectory_settings.h"
@@ -12,6 +16,16 @@ namespace polynomial_trajectories {
 
 namespace minimum_snap_trajectories {
 
+struct SegmentRefinementStatistics {
+  int iterations = 0;
+  // QP solves including the initial trajectory and line search steps
+  int num_solves = 0;
+  double initial_cost = 0.0;
+  double final_cost = 0.0;
+  // [s]
+  double computation_time = 0.0;
+};
+
 PolynomialTrajectory generateMinimumSnapTrajectory(
     const Eigen::VectorXd& segment_times,
     const quadrotor_common::TrajectoryPoint& start_state,
@@ -25,18 +39,22 @@ PolynomialTrajectory generateMinimumSnapTrajectory(
     const double max_velocity, const double max_normalized_thrust,
     const double max_roll_pitch_rate);
 
+// The segment times are refined with analytic cost gradients, keeping the
+// total execution time
 PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
     const quadrotor_common::TrajectoryPoint& start_state,
     const quadrotor_common::TrajectoryPoint& end_state,
-    const PolynomialTrajectorySettings& trajectory_settings);
+    const PolynomialTrajectorySettings& trajectory_settings,
+    SegmentRefinementStatistics* statistics = nullptr);
 PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
     const quadrotor_common::TrajectoryPoint& start_state,
     const quadrotor_common::TrajectoryPoint& end_state,
     const PolynomialTrajectorySettings& trajectory_settings,
     const double max_velocity, const double max_normalized_thrust,
-    const double max_roll_pitch_rate);
+    const double max_roll_pitch_rate,
+    SegmentRefinementStatistics* statistics = nullptr);
 
 PolynomialTrajectory generateMinimumSnapRingTrajectory(
     const Eigen::VectorXd& segment_times,
@@ -49,15 +67,47 @@ PolynomialTrajectory generateMinimumSnapRingTrajectory(
 
 PolynomialTrajectory generateMinimumSnapRingTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
-    const PolynomialTrajectorySettings& trajectory_settings);
+    const PolynomialTrajectorySettings& trajectory_settings,
+    SegmentRefinementStatistics* statistics = nullptr);
 PolynomialTrajectory generateMinimumSnapRingTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
     const PolynomialTrajectorySettings& trajectory_settings,
     const double max_velocity, const double max_normalized_thrust,
-    const double max_roll_pitch_rate);
+    const double max_roll_pitch_rate,
+    SegmentRefinementStatistics* statistics = nullptr);
 
 // these functions should not be used from the outside
 namespace implementation {
+// Factorized KKT system of a minimum snap QP. It only depends on the segment
+// times and the trajectory settings, so all axes and all QPs with the same
+// timing but different way points share it.
+struct QuadraticProgramFactorization {
+  Eigen::SparseMatrix<double> H;
+  Eigen::SparseMatrix<double> A_eq;
+  Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>
+      solver;
+  bool success = false;
+};
+
+// The trajectory generation, optionally with the gradient of the
+// optimization cost with respect to the segment times. The factorization is
+// taken from getFactorization unless one from getMinimumSnapFactorization for
+// the same segment times and settings is given.
+PolynomialTrajectory solveMinimumSnapTrajectory(
+    const Eigen::VectorXd& segment_times,
+    const quadrotor_common::TrajectoryPoint& start_state,
+    const quadrotor_common::TrajectoryPoint& end_state,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    Eigen::VectorXd* cost_gradient,
+    std::shared_ptr<const QuadraticProgramFactorization> factorization =
+        nullptr);
+PolynomialTrajectory solveMinimumSnapRingTrajectory(
+    const Eigen::VectorXd& segment_times,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    Eigen::VectorXd* cost_gradient,
+    std::shared_ptr<const QuadraticProgramFactorization> factorization =
+        nullptr);
+
 Eigen::MatrixXd generate1DTrajectory(const int num_polynoms,
                                      const int polynomial_order,
                                      const Eigen::MatrixXd& H,
@@ -65,53 +115,114 @@ Eigen::MatrixXd generate1DTrajectory(const int num_polynoms,
                                      const Eigen::MatrixXd& A,
                                      const Eigen::VectorXd& b,
                                      double* optimization_cost);
+Eigen::MatrixXd generate1DTrajectory(const int num_polynoms,
+                                     const int polynomial_order,
+                                     const Eigen::SparseMatrix<double>& H,
+                                     const Eigen::VectorXd& f,
+                                     const Eigen::SparseMatrix<double>& A,
+                                     const Eigen::VectorXd& b,
+                                     double* optimization_cost);
+// QP solution to one row of polynomial coefficients per segment
+Eigen::MatrixXd reshapeSolution(const Eigen::VectorXd& solution,
+                                const int num_polynoms,
+                                const int polynomial_order);
 
+// The dense matrices are the sparse ones converted, the sparse versions are
+// used by the trajectory generation
 Eigen::MatrixXd generateHMatrix(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& tau_dot);
+Eigen::SparseMatrix<double> generateSparseHMatrix(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const Eigen::VectorXd& tau_dot);
 Eigen::VectorXd generateFVector(
     const PolynomialTrajectorySettings& trajectory_settings,
     const Eigen::VectorXd& way_points_1D, const int num_polynoms);
 Eigen::MatrixXd generateEqualityConstraintsAMatrix(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& tau_dot);
+Eigen::SparseMatrix<double> generateSparseEqualityConstraintsAMatrix(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const Eigen::VectorXd& tau_dot);
 Eigen::VectorXd generateEqualityConstraintsBVector(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& way_points_1D,
-    const Eigen::Vector3d& start_conditions,
-    const Eigen::Vector3d& end_conditions);
+    const Eigen::Vector4d& start_conditions,
+    const Eigen::Vector4d& end_conditions);
 
 Eigen::MatrixXd generateRingEqualityConstraintsAMatrix(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& tau_dot);
+Eigen::SparseMatrix<double> generateSparseRingEqualityConstraintsAMatrix(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const Eigen::VectorXd& tau_dot);
 Eigen::VectorXd generateRingEqualityConstraintsBVector(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& way_points_1D);
 
+// Power of tau_dot each equality constraint scales with
+Eigen::VectorXd generateConstraintTimeExponents(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const bool ring_trajectory);
+// Analytic gradient of the optimal cost with respect to the segment times
+// from the KKT solution of all axes (one column per axis)
+Eigen::VectorXd computeSegmentTimeGradient(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const Eigen::VectorXd& segment_times,
+    const QuadraticProgramFactorization& factorization,
+    const Eigen::MatrixXd& solutions, const Eigen::MatrixXd& multipliers,
+    const bool ring_trajectory);
+
 Eigen::VectorXd computeCostGradient(
     const PolynomialTrajectory& initial_trajectory,
     const PolynomialTrajectorySettings& trajectory_settings);
 Eigen::VectorXd computeSearchDirection(
     const PolynomialTrajectory& initial_trajectory,
     const Eigen::VectorXd& gradient);
-Eigen::VectorXd updateSegmentTimes(
+// Backtracking line search along the search direction, false if no step
+// decreases the cost
+bool updateSegmentTimes(const PolynomialTrajectory& initial_trajectory,
+                        const Eigen::VectorXd& gradient,
+                        const PolynomialTrajectorySettings& trajectory_settings,
+                        PolynomialTrajectory* trajectory,
+                        Eigen::VectorXd* updated_gradient, int* num_solves);
+// Recomputes an open or ring trajectory of the same type with new segment
+// times
+PolynomialTrajectory solveWithSegmentTimes(
+    const PolynomialTrajectory& trajectory,
+    const Eigen::VectorXd& segment_times,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    Eigen::VectorXd* cost_gradient);
+PolynomialTrajectory refineSegmentTimes(
     const PolynomialTrajectory& initial_trajectory,
-    const Eigen::VectorXd& gradient,
-    const PolynomialTrajectorySettings& trajectory_settings);
+    const Eigen::VectorXd& initial_gradient,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const ros::WallTime& start_time, SegmentRefinementStatistics* statistics);
 
+// Scales the execution time until the largest of the maxima is just below its
+// limit, by bracketing and regula falsi on the time scale
 PolynomialTrajectory enforceMaximumVelocityAndThrust(
     const PolynomialTrajectory& initial_trajectory,
     const PolynomialTrajectorySettings& trajectory_settings,
     const double max_velocity, const double max_normalized_thrust,
     const double max_roll_pitch_rate);
 
-bool computeMaximaGradient(
-    const PolynomialTrajectory& trajectory, const Eigen::Vector3d& maxima,
-    const PolynomialTrajectorySettings& trajectory_settings,
-    Eigen::Vector3d* gradient);
+// Largest ratio of the velocity, thrust and roll pitch rate maxima to their
+// limits
+double computeMaximaRatio(const PolynomialTrajectory& trajectory,
+                          const Eigen::Vector3d& desired_maxima);
+
+// QP objective of the coefficients of an open minimum snap trajectory summed
+// over all axes, the way points are taken from the segment boundaries. Equals
+// the optimization cost of a solved trajectory and also applies to
+// trajectories spliced from several solutions.
+double computeOptimizationCost(
+    const PolynomialTrajectory& trajectory,
+    const PolynomialTrajectorySettings& trajectory_settings);
 
-std::vector<Eigen::MatrixXd> reorganiceCoefficientsSegmentWise(
-    const std::vector<Eigen::MatrixXd>& coefficients, const int num_segments,
+// Solutions has one column per dimension
+PolynomialCoefficients reorganiceCoefficientsSegmentWise(
+    const Eigen::MatrixXd& solutions, const int num_segments,
     const int polynomial_order);
 PolynomialTrajectorySettings ensureFeasibleTrajectorySettings(
     const PolynomialTrajectorySettings& original_trajectory_settings,
@@ -125,6 +236,38 @@ Eigen::VectorXd solveQuadraticProgram(const Eigen::MatrixXd& H,
                                       const Eigen::MatrixXd& A_eq,
                                       const Eigen::VectorXd& b_eq,
                                       double* objective_value);
+// Sparse LU of the banded KKT system, linear in the number of segments
+Eigen::VectorXd solveQuadraticProgram(const Eigen::SparseMatrix<double>& H,
+                                      const Eigen::VectorXd& f,
+                                      const Eigen::SparseMatrix<double>& A_eq,
+                                      const Eigen::VectorXd& b_eq,
+                                      double* objective_value);
+std::shared_ptr<QuadraticProgramFactorization> factorizeQuadraticProgram(
+    const Eigen::SparseMatrix<double>& H,
+    const Eigen::SparseMatrix<double>& A_eq);
+// Solves one QP per column of f and b_eq with the same factorization
+Eigen::MatrixXd solveQuadraticPrograms(
+    const QuadraticProgramFactorization& factorization,
+    const Eigen::MatrixXd& f, const Eigen::MatrixXd& b_eq,
+    Eigen::VectorXd* objective_values,
+    Eigen::MatrixXd* multipliers = nullptr);
+// Returns the factorization for these segment times and settings, from a
+// small least recently used cache if it was computed before. Thread safe.
+std::shared_ptr<const QuadraticProgramFactorization> getFactorization(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const Eigen::VectorXd& segment_times, const bool ring_trajectory);
+// Lowest polynomial order for which the QP is feasible
+int minimumPolynomialOrder(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_segments, const bool ring_trajectory);
+// The factorization the solvers use for these segment times and settings.
+// Holding it keeps it alive independently of the cache, e.g. to solve many
+// QPs with the same timing while other threads replace the cache entries.
+std::shared_ptr<const QuadraticProgramFactorization>
+getMinimumSnapFactorization(
+    const Eigen::VectorXd& segment_times,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const bool ring_trajectory);
 }  // namespace implementation
 
 }  // namespace minimum_snap_trajectories
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+namespace polynomial_trajectories {
+
+// Polynomial coefficients of all segments of a trajectory in one contiguous,
+// aligned block of [segments x dimension x coefficients]. A segment is a
+// (dimension x coefficients) row major block, so the coefficients of one axis
+// are contiguous.
+class PolynomialCoefficients {
+ public:
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                        Eigen::RowMajor>
+      SegmentMatrix;
+  typedef Eigen::Map<SegmentMatrix> SegmentMap;
+  typedef Eigen::Map<const SegmentMatrix> ConstSegmentMap;
+  // View of the x, y and z rows of a segment (the first three of dimension),
+  // with the number of coefficients known at compile time for the common
+  // orders or Eigen::Dynamic
+  template <int NumberOfCoefficients>
+  using FixedSegmentMap = Eigen::Map<
+      const Eigen::Matrix<double, 3, NumberOfCoefficients, Eigen::RowMajor>>;
+
+  PolynomialCoefficients();
+  PolynomialCoefficients(const int number_of_segments, const int dimension,
+                         const int number_of_coefficients);
+  explicit PolynomialCoefficients(
+      const std::vector<Eigen::MatrixXd>& segment_coefficients);
+  virtual ~PolynomialCoefficients();
+
+  // All coefficients are set to zero
+  void resize(const int number_of_segments, const int dimension,
+              const int number_of_coefficients);
+
+  int size() const { return number_of_segments_; }
+  bool empty() const { return number_of_segments_ == 0; }
+  int dimension() const { return dimension_; }
+  int numberOfCoefficients() const { return number_of_coefficients_; }
+
+  SegmentMap operator[](const int segment) {
+    return SegmentMap(data_.data() + segment * segmentSize(), dimension_,
+                      number_of_coefficients_);
+  }
+  ConstSegmentMap operator[](const int segment) const {
+    return ConstSegmentMap(data_.data() + segment * segmentSize(), dimension_,
+                           number_of_coefficients_);
+  }
+  template <int NumberOfCoefficients>
+  FixedSegmentMap<NumberOfCoefficients> fixedSegment(const int segment) const {
+    return FixedSegmentMap<NumberOfCoefficients>(
+        data_.data() + segment * segmentSize(), 3, number_of_coefficients_);
+  }
+
+  double* data() { return data_.data(); }
+  const double* data() const { return data_.data(); }
+
+ private:
+  int segmentSize() const { return dimension_ * number_of_coefficients_; }
+
+  int number_of_segments_;
+  int dimension_;
+  int number_of_coefficients_;
+  std::vector<double, Eigen::aligned_allocator<double>> data_;
+};
+
+}  // namespace polynomial_trajectories
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <quadrotor_common/trajectory_point.h>
 #include <ros/duration.h>
 #include <Eigen/Dense>
@@ -8,14 +10,35 @@
 
 namespace polynomial_trajectories {
 
+// States sampled from a trajectory, one row per sample time and one column
+// per axis, so each axis is contiguous
+struct TrajectorySamples {
+  Eigen::VectorXd times;
+  Eigen::MatrixX3d position;
+  Eigen::MatrixX3d velocity;
+  Eigen::MatrixX3d acceleration;
+  Eigen::MatrixX3d jerk;
+  Eigen::MatrixX3d snap;
+};
+
 quadrotor_common::TrajectoryPoint getPointFromTrajectory(
     const PolynomialTrajectory& trajectory,
     const ros::Duration& time_from_start);
+// Evaluates the trajectory at all times [s], which should be sorted so that
+// the segments are walked once. Times outside of the trajectory are wrapped
+// for ring trajectories and clamped to its ends otherwise.
+bool sampleTrajectory(const PolynomialTrajectory& trajectory,
+                      const Eigen::VectorXd& times, TrajectorySamples* samples);
 Eigen::VectorXd computeFactorials(const int length, const int order);
 Eigen::VectorXd dVec(const int number_of_coefficients,
                      const int derivative_order);
 Eigen::VectorXd tVec(const int number_of_coefficients,
                      const int derivative_order, const double t);
+// The maxima of velocity, acceleration, jerk, snap and thrust norms are exact,
+// they are found per segment from the roots of the derivative of the squared
+// norm polynomial. The roll pitch rate is not a polynomial, its maximum is
+// found by branch and bound with interval bounds, sampling only where the
+// bound is above the current maximum (relative tolerance 1e-3).
 void computeMaxima(const PolynomialTrajectory& trajectory,
                    double* maximal_velocity, double* maximal_acceleration,
                    double* maximal_jerk, double* maximal_snap);
@@ -23,6 +46,11 @@ void computeQuadRelevantMaxima(const PolynomialTrajectory& trajectory,
                                double* maximal_velocity,
                                double* maximal_normalized_thrust,
                                double* maximal_roll_pitch_rate);
+// Reference for computeQuadRelevantMaxima, samples the trajectory every 10ms
+void sampleQuadRelevantMaxima(const PolynomialTrajectory& trajectory,
+                              double* maximal_velocity,
+                              double* maximal_normalized_thrust,
+                              double* maximal_roll_pitch_rate);
 bool isStartAndEndStateFeasibleUnderConstraints(
     const quadrotor_common::TrajectoryPoint& start_state,
     const quadrotor_common::TrajectoryPoint& end_state,
@@ -31,4 +59,40 @@ bool isStartAndEndStateFeasibleUnderConstraints(
 double computeRollPitchRateNormFromTrajectoryPoint(
     const quadrotor_common::TrajectoryPoint& desired_state);
 
+namespace implementation {
+
+// Polynomials are given by their coefficients in ascending order
+
+// Coefficients (rows: dimension) of the derivative_order-th derivative of a
+// segment with respect to time, as polynomial of tau in [0, 1]
+Eigen::MatrixXd segmentDerivativeCoefficients(
+    const PolynomialTrajectory& trajectory, const int segment,
+    const int derivative_order);
+// Batch evaluation of sampleTrajectory, NumberOfCoefficients can be
+// Eigen::Dynamic
+template <int NumberOfCoefficients>
+void sampleSegments(const PolynomialTrajectory& trajectory,
+                    const Eigen::VectorXd& times, TrajectorySamples* samples);
+double evaluatePolynomial(const Eigen::VectorXd& coefficients,
+                          const double tau);
+Eigen::VectorXd differentiatePolynomial(const Eigen::VectorXd& coefficients);
+Eigen::VectorXd multiplyPolynomials(const Eigen::VectorXd& a,
+                                    const Eigen::VectorXd& b);
+// Sum of the squared polynomials in the rows of coefficients
+Eigen::VectorXd squaredNormPolynomial(const Eigen::MatrixXd& coefficients);
+// All real roots in [lower, upper], sorted, found by isolating them between
+// the roots of the derivative
+std::vector<double> polynomialRootsInInterval(
+    const Eigen::VectorXd& coefficients, const double lower,
+    const double upper);
+double maximizePolynomial(const Eigen::VectorXd& coefficients,
+                          const double lower, const double upper);
+// Centered form enclosure of the polynomial on [lower, upper]
+void boundPolynomial(const Eigen::VectorXd& coefficients, const double lower,
+                     const double upper, double* minimum, double* maximum);
+double maximizeRollPitchRate(const Eigen::MatrixXd& thrust_coefficients,
+                             const Eigen::MatrixXd& jerk_coefficients);
+
+}  // namespace implementation
+
 }  // namespace polynomial_trajectories
@@ -6,6 +6,8 @@
 #include <ros/duration.h>
 #include <Eigen/Dense>
 
+#include "polynomial_trajectories/polynomial_coefficients.h"
+
 namespace polynomial_trajectories {
 
 enum class TrajectoryType {
@@ -23,9 +25,9 @@ struct PolynomialTrajectory {
 
   TrajectoryType trajectory_type;
   // Polynomial coefficients
-  // Each element of this vector contains the coefficients for one polynomial
-  // segment (rows: dimension, columns: order)
-  std::vector<Eigen::MatrixXd> coeff;
+  // coeff[i] contains the coefficients for polynomial segment i
+  // (rows: dimension, columns: order), all segments share one allocation
+  PolynomialCoefficients coeff;
   ros::Duration T;
   quadrotor_common::TrajectoryPoint start_state;
   quadrotor_common::TrajectoryPoint end_state;
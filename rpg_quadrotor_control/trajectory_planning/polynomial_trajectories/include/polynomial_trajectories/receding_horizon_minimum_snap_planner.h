@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+
+#include <quadrotor_common/trajectory_point.h>
+#include <ros/time.h>
+#include <Eigen/Dense>
+
+#include "polynomial_trajectories/polynomial_trajectory.h"
+#include "polynomial_trajectories/polynomial_trajectory_settings.h"
+
+namespace polynomial_trajectories {
+
+struct RecedingHorizonSettings {
+  // Number of segments that are re-optimized in each replanning step
+  int window_segments = 4;
+  // Replanning starts this far ahead of the current time [s], it has to cover
+  // the replanning period and the computation time
+  double commit_horizon = 0.05;
+  // The segment that is flown is only split if this much of it remains [s]
+  double min_segment_time = 0.05;
+  // Time budget for one replanning step [s], the segment time refinement stops
+  // before it would exceed it
+  double max_computation_time = 0.01;
+  bool refine_segment_times = true;
+};
+
+struct RecedingHorizonStatistics {
+  int window_segments = 0;
+  int refinement_iterations = 0;
+  int num_solves = 0;
+  // Cost of the re-optimized window only, the trajectory has the cost of all
+  // its segments
+  double window_optimization_cost = 0.0;
+  // [s]
+  double computation_time = 0.0;
+  bool deadline_met = true;
+};
+
+// Minimum snap planner for flying through a list of way points that can move
+// while the trajectory is flown.
+//
+// Each replanning step keeps the committed part of the current trajectory (up
+// to the current time plus the commit horizon) and re-optimizes the following
+// window of segments through the updated way points, warm started with the
+// previous segment times. The window starts with the full state of the
+// committed trajectory and, if segments remain after it, ends with the full
+// state of the previous trajectory at its last way point, so the spliced
+// trajectory is continuous up to the continuity order. Way point changes after
+// the window are picked up once they enter it.
+//
+// Segments that have been flown completely are dropped, the time base of the
+// trajectory moves by getTimeShift() in each replanning step.
+//
+// The window problem has a fixed size, so a replanning step takes constant
+// time independent of the number of way points. The segment times of the
+// window are only refined when it starts at a way point, and only while the
+// next refinement iteration fits into max_computation_time.
+class RecedingHorizonMinimumSnapPlanner {
+ public:
+  RecedingHorizonMinimumSnapPlanner(
+      const PolynomialTrajectorySettings& trajectory_settings,
+      const RecedingHorizonSettings& receding_horizon_settings);
+  virtual ~RecedingHorizonMinimumSnapPlanner();
+
+  // Plans the full trajectory through trajectory_settings.way_points
+  bool initialize(const Eigen::VectorXd& segment_times,
+                  const quadrotor_common::TrajectoryPoint& start_state,
+                  const quadrotor_common::TrajectoryPoint& end_state);
+  // time_from_start is the current time on the trajectory of the last call,
+  // way_points is the full list of way points given to initialize with
+  // updated positions
+  bool replan(const double time_from_start,
+              const std::vector<Eigen::Vector3d>& way_points);
+
+  const PolynomialTrajectory& getTrajectory() const { return trajectory_; }
+  // Time [s] by which the trajectory start moved forward in the last replan
+  double getTimeShift() const { return time_shift_; }
+  const RecedingHorizonStatistics& getStatistics() const {
+    return statistics_;
+  }
+
+ private:
+  PolynomialTrajectory optimizeWindow(
+      const Eigen::VectorXd& segment_times,
+      const quadrotor_common::TrajectoryPoint& start_state,
+      const quadrotor_common::TrajectoryPoint& end_state,
+      const PolynomialTrajectorySettings& window_settings,
+      const bool refine_segment_times, const ros::WallTime& start_time);
+  void spliceTrajectory(const std::vector<Eigen::MatrixXd>& prefix,
+                        const std::vector<double>& prefix_times,
+                        const std::vector<int>& prefix_way_points,
+                        const PolynomialTrajectory& window,
+                        const std::vector<int>& window_way_points,
+                        const int tail_start,
+                        const quadrotor_common::TrajectoryPoint& start_state);
+
+  PolynomialTrajectorySettings trajectory_settings_;
+  RecedingHorizonSettings receding_horizon_settings_;
+
+  PolynomialTrajectory trajectory_;
+  quadrotor_common::TrajectoryPoint end_state_;
+  // Index of the way point each segment ends at, -1 if it ends at a split
+  // point and the number of way points for the end state
+  std::vector<int> segment_way_points_;
+  double time_shift_;
+  RecedingHorizonStatistics statistics_;
+};
+
+}  // namespace polynomial_trajectories
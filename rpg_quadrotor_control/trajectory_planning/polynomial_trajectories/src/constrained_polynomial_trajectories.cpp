@@ -226,12 +226,12 @@ Eigen::VectorXd implementation::computeConstraintMatriceB(
   return b;
 }
 
-std::vector<Eigen::MatrixXd> implementation::computeTrajectoryCoeff(
+PolynomialCoefficients implementation::computeTrajectoryCoeff(
     const quadrotor_common::TrajectoryPoint& s0,
     const quadrotor_common::TrajectoryPoint& s1, const int order_of_continuity,
     const double T) {
   int number_of_coefficients = 2 * order_of_continuity;
-  Eigen::MatrixXd p_coeff = Eigen::MatrixXd::Zero(3, number_of_coefficients);
+  PolynomialCoefficients coefficients(1, 3, number_of_coefficients);
 
   // solve the problem for each axis
   for (int axis = 0; axis < 3; axis++) {
@@ -249,13 +249,10 @@ std::vector<Eigen::MatrixXd> implementation::computeTrajectoryCoeff(
     b.tail(order_of_continuity) = implementation::computeConstraintMatriceB(
         order_of_continuity, s1, axis);
 
-    p_coeff.row(axis) = A.inverse() * b;
+    coefficients[0].row(axis) = A.inverse() * b;
   }
 
-  std::vector<Eigen::MatrixXd> coeff_vec;
-  coeff_vec.push_back(p_coeff);
-
-  return coeff_vec;
+  return coefficients;
 }
 
 Eigen::Vector3d implementation::computeMaximaGradient(
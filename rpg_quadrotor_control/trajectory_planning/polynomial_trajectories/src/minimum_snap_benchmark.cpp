@@ -0,0 +1,318 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <ros/ros.h>
+#include <Eigen/Dense>
+
+#include "polynomial_trajectories/minimum_snap_trajectories.h"
+#include "polynomial_trajectories/polynomial_trajectories_common.h"
+#include "polynomial_trajectories/receding_horizon_minimum_snap_planner.h"
+
+// Compares the dense and the sparse minimum snap QP solver on random race
+// tracks and times the full trajectory generation with the sparse solver,
+// once with new segment times (factorization) and once replanning moved way
+// points with the same timing (cached factorization, solve only).
+// A second table reports the segment time refinement starting from unit
+// segment times, a third one compares computeQuadRelevantMaxima to sampling
+// the trajectory, the differences are relative to the sampled maxima. The
+// fifth one samples the trajectories at 1kHz point by point and in a batch.
+// The last one replans with the receding horizon planner at 50Hz while the
+// way points move.
+// Exits with 1 if the dense and sparse solutions, the bounded and sampled
+// maxima or the single and batch samples do not agree, or if the refinement
+// increases the cost.
+// usage: minimum_snap_benchmark [max_dense_way_points] [repetitions]
+
+namespace mst = polynomial_trajectories::minimum_snap_trajectories;
+
+namespace {
+
+double secondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "minimum_snap_benchmark");
+
+  const int max_dense_way_points = argc > 1 ? atoi(argv[1]) : 100;
+  const int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+  Eigen::VectorXd minimization_weights(5);
+  minimization_weights << 0.0, 1.0, 1.0, 1.0, 1.0;
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> step(-5.0, 5.0);
+
+  std::vector<polynomial_trajectories::PolynomialTrajectorySettings>
+      refinement_problems;
+  std::vector<quadrotor_common::TrajectoryPoint> refinement_end_states;
+  bool mismatch = false;
+
+  printf("%10s %12s %12s %12s %12s %14s\n", "waypoints", "dense [ms]",
+         "sparse [ms]", "full [ms]", "replan [ms]", "max coeff diff");
+  for (const int num_way_points : {5, 10, 20, 50, 100, 200, 500}) {
+    // random walk through the way points with unit segment times
+    std::vector<Eigen::Vector3d> way_points;
+    Eigen::Vector3d position = Eigen::Vector3d::Zero();
+    for (int i = 0; i < num_way_points; i++) {
+      position += Eigen::Vector3d(step(generator), step(generator),
+                                  0.2 * step(generator));
+      way_points.push_back(position);
+    }
+    quadrotor_common::TrajectoryPoint start_state, end_state;
+    start_state.position = Eigen::Vector3d::Zero();
+    end_state.position = position + Eigen::Vector3d(5.0, 0.0, 0.0);
+    polynomial_trajectories::PolynomialTrajectorySettings settings(
+        way_points, minimization_weights, 7, 4);
+    const int num_segments = num_way_points + 1;
+    const Eigen::VectorXd segment_times = Eigen::VectorXd::Ones(num_segments);
+
+    // the QP of the x axis as set up by generateMinimumSnapTrajectory
+    settings.way_points = mst::implementation::addStartAndEndToWayPointList(
+        way_points, start_state.position, end_state.position);
+    Eigen::VectorXd way_points_x(num_segments + 1);
+    for (int i = 0; i < num_segments + 1; i++) {
+      way_points_x(i) = settings.way_points[i].x();
+    }
+    const Eigen::VectorXd tau_dot = segment_times.cwiseInverse();
+    const Eigen::SparseMatrix<double> H =
+        mst::implementation::generateSparseHMatrix(settings, num_segments,
+                                                   tau_dot);
+    const Eigen::SparseMatrix<double> A_eq =
+        mst::implementation::generateSparseEqualityConstraintsAMatrix(
+            settings, num_segments, tau_dot);
+    const Eigen::VectorXd f = mst::implementation::generateFVector(
+        settings, way_points_x, num_segments);
+    const Eigen::VectorXd b_eq =
+        mst::implementation::generateEqualityConstraintsBVector(
+            settings, num_segments, way_points_x, Eigen::Vector4d::Zero(),
+            Eigen::Vector4d::Zero());
+
+    double cost;
+    auto start = std::chrono::steady_clock::now();
+    Eigen::VectorXd sparse_solution;
+    for (int r = 0; r < repetitions; r++) {
+      sparse_solution =
+          mst::implementation::solveQuadraticProgram(H, f, A_eq, b_eq, &cost);
+    }
+    const double sparse_time = secondsSince(start) / repetitions;
+
+    double dense_time = -1.0;
+    double max_difference = -1.0;
+    if (num_way_points <= max_dense_way_points) {
+      const Eigen::MatrixXd H_dense(H);
+      const Eigen::MatrixXd A_dense(A_eq);
+      start = std::chrono::steady_clock::now();
+      Eigen::VectorXd dense_solution;
+      for (int r = 0; r < repetitions; r++) {
+        dense_solution = mst::implementation::solveQuadraticProgram(
+            H_dense, f, A_dense, b_eq, &cost);
+      }
+      dense_time = secondsSince(start) / repetitions;
+      max_difference = (dense_solution - sparse_solution).cwiseAbs().maxCoeff();
+      if (!(max_difference <=
+            1e-6 * std::max(dense_solution.cwiseAbs().maxCoeff(), 1.0))) {
+        mismatch = true;
+      }
+    }
+
+    settings.way_points = way_points;
+    refinement_problems.push_back(settings);
+    refinement_end_states.push_back(end_state);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; r++) {
+      mst::generateMinimumSnapTrajectory((1.0 + 1e-3 * r) * segment_times,
+                                         start_state, end_state, settings);
+    }
+    const double full_time = secondsSince(start) / repetitions;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; r++) {
+      settings.way_points[r % num_way_points] += Eigen::Vector3d::UnitZ();
+      mst::generateMinimumSnapTrajectory(segment_times, start_state, end_state,
+                                         settings);
+    }
+    const double replan_time = secondsSince(start) / repetitions;
+
+    if (dense_time < 0.0) {
+      printf("%10d %12s %12.3f %12.3f %12.3f %14s\n", num_way_points, "-",
+             1e3 * sparse_time, 1e3 * full_time, 1e3 * replan_time, "-");
+    } else {
+      printf("%10d %12.3f %12.3f %12.3f %12.3f %14.2e\n", num_way_points,
+             1e3 * dense_time, 1e3 * sparse_time, 1e3 * full_time,
+             1e3 * replan_time, max_difference);
+    }
+  }
+
+  printf("\n%10s %12s %12s %12s %14s %14s\n", "waypoints", "iterations",
+         "QP solves", "time [ms]", "initial cost", "refined cost");
+  for (size_t i = 0; i < refinement_problems.size(); i++) {
+    const int num_way_points = refinement_problems[i].way_points.size();
+    if (num_way_points > 200) {
+      continue;
+    }
+    quadrotor_common::TrajectoryPoint start_state;
+    start_state.position = Eigen::Vector3d::Zero();
+    mst::SegmentRefinementStatistics statistics;
+    mst::generateMinimumSnapTrajectoryWithSegmentRefinement(
+        Eigen::VectorXd::Ones(num_way_points + 1), start_state,
+        refinement_end_states[i], refinement_problems[i], &statistics);
+    printf("%10d %12d %12d %12.3f %14.4e %14.4e\n", num_way_points,
+           statistics.iterations, statistics.num_solves,
+           1e3 * statistics.computation_time, statistics.initial_cost,
+           statistics.final_cost);
+    if (!(statistics.final_cost <= statistics.initial_cost)) {
+      mismatch = true;
+    }
+  }
+
+  printf("\n%10s %12s %12s %12s %12s %12s\n", "waypoints", "sampled [ms]",
+         "bounded [ms]", "vel diff", "thrust diff", "rate diff");
+  for (size_t i = 0; i < refinement_problems.size(); i++) {
+    const int num_way_points = refinement_problems[i].way_points.size();
+    quadrotor_common::TrajectoryPoint start_state;
+    start_state.position = Eigen::Vector3d::Zero();
+    const polynomial_trajectories::PolynomialTrajectory trajectory =
+        mst::generateMinimumSnapTrajectory(
+            Eigen::VectorXd::Constant(num_way_points + 1, 2.0), start_state,
+            refinement_end_states[i], refinement_problems[i]);
+
+    Eigen::Vector3d sampled_maxima, maxima;
+    auto start = std::chrono::steady_clock::now();
+    polynomial_trajectories::sampleQuadRelevantMaxima(
+        trajectory, &sampled_maxima.x(), &sampled_maxima.y(),
+        &sampled_maxima.z());
+    const double sampled_time = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; r++) {
+      polynomial_trajectories::computeQuadRelevantMaxima(
+          trajectory, &maxima.x(), &maxima.y(), &maxima.z());
+    }
+    const double bounded_time = secondsSince(start) / repetitions;
+
+    const Eigen::Vector3d difference =
+        (maxima - sampled_maxima).cwiseQuotient(sampled_maxima);
+    // The bounded maxima may only be below the sampled ones by the branch and
+    // bound tolerance of the roll pitch rate
+    if (!(difference.minCoeff() >= -2e-3 && difference.maxCoeff() <= 1e-2)) {
+      mismatch = true;
+    }
+    printf("%10d %12.3f %12.3f %12.2e %12.2e %12.2e\n", num_way_points,
+           1e3 * sampled_time, 1e3 * bounded_time, difference.x(),
+           difference.y(), difference.z());
+  }
+
+  printf("\n%10s %12s %12s %12s %14s\n", "waypoints", "samples",
+         "single [ms]", "batch [ms]", "max difference");
+  for (size_t i = 0; i < refinement_problems.size(); i++) {
+    const int num_way_points = refinement_problems[i].way_points.size();
+    quadrotor_common::TrajectoryPoint start_state;
+    start_state.position = Eigen::Vector3d::Zero();
+    const polynomial_trajectories::PolynomialTrajectory trajectory =
+        mst::generateMinimumSnapTrajectory(
+            Eigen::VectorXd::Constant(num_way_points + 1, 2.0), start_state,
+            refinement_end_states[i], refinement_problems[i]);
+    // The single queries take a ros::Duration, the batch gets the same
+    // nanosecond times
+    const int num_samples = 1000.0 * trajectory.T.toSec();
+    Eigen::VectorXd times =
+        Eigen::VectorXd::LinSpaced(num_samples, 0.0, trajectory.T.toSec());
+    for (int k = 0; k < num_samples; k++) {
+      times(k) = ros::Duration(times(k)).toSec();
+    }
+
+    std::vector<quadrotor_common::TrajectoryPoint> points(num_samples);
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < num_samples; k++) {
+      points[k] = polynomial_trajectories::getPointFromTrajectory(
+          trajectory, ros::Duration(times(k)));
+    }
+    const double single_time = secondsSince(start);
+
+    polynomial_trajectories::TrajectorySamples samples;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; r++) {
+      polynomial_trajectories::sampleTrajectory(trajectory, times, &samples);
+    }
+    const double batch_time = secondsSince(start) / repetitions;
+
+    double max_difference = 0.0;
+    for (int k = 0; k < num_samples; k++) {
+      max_difference = std::max(
+          max_difference,
+          (samples.position.row(k).transpose() - points[k].position)
+              .cwiseAbs()
+              .maxCoeff());
+      max_difference = std::max(
+          max_difference,
+          (samples.snap.row(k).transpose() - points[k].snap).cwiseAbs()
+              .maxCoeff() /
+              std::max(points[k].snap.norm(), 1.0));
+    }
+    printf("%10d %12d %12.3f %12.3f %14.2e\n", num_way_points, num_samples,
+           1e3 * single_time, 1e3 * batch_time, max_difference);
+    if (!(max_difference <= 1e-9)) {
+      mismatch = true;
+    }
+  }
+
+  printf("\n%10s %12s %12s %12s %12s\n", "waypoints", "replans",
+         "mean [ms]", "max [ms]", "misses");
+  std::uniform_real_distribution<double> motion(-0.01, 0.01);
+  for (size_t i = 0; i < refinement_problems.size(); i++) {
+    const int num_way_points = refinement_problems[i].way_points.size();
+    quadrotor_common::TrajectoryPoint start_state;
+    start_state.position = Eigen::Vector3d::Zero();
+    polynomial_trajectories::RecedingHorizonMinimumSnapPlanner planner(
+        refinement_problems[i],
+        polynomial_trajectories::RecedingHorizonSettings());
+    if (!planner.initialize(Eigen::VectorXd::Constant(num_way_points + 1, 2.0),
+                            start_state, refinement_end_states[i])) {
+      continue;
+    }
+
+    std::vector<Eigen::Vector3d> way_points = refinement_problems[i].way_points;
+    const double replanning_period = 0.02;
+    const int max_replans = 500;
+    double time_from_start = 0.0;
+    double total_time = 0.0;
+    double max_time = 0.0;
+    int replans = 0;
+    int misses = 0;
+    while (replans < max_replans &&
+           time_from_start < planner.getTrajectory().T.toSec()) {
+      time_from_start += replanning_period;
+      for (Eigen::Vector3d& way_point : way_points) {
+        way_point +=
+            Eigen::Vector3d(motion(generator), motion(generator), 0.0);
+      }
+      if (!planner.replan(time_from_start, way_points)) {
+        break;
+      }
+      time_from_start -= planner.getTimeShift();
+      const polynomial_trajectories::RecedingHorizonStatistics& statistics =
+          planner.getStatistics();
+      total_time += statistics.computation_time;
+      max_time = std::max(max_time, statistics.computation_time);
+      if (!statistics.deadline_met) {
+        misses++;
+      }
+      replans++;
+    }
+    printf("%10d %12d %12.3f %12.3f %12d\n", num_way_points, replans,
+           1e3 * total_time / std::max(replans, 1), 1e3 * max_time, misses);
+  }
+
+  if (mismatch) {
+    fprintf(stderr, "\nThe compared results do not agree!\n");
+    return 1;
+  }
+  return 0;
+}
@@ -1,6 +1,9 @@
 #include "polynomial_trajectories/minimum_snap_trajectories.h"
 
 #include <ros/ros.h>
+#include <limits>
+#include <list>
+#include <mutex>
 
 #include "polynomial_trajectories/polynomial_trajectories_common.h"
 
@@ -13,6 +16,18 @@ PolynomialTrajectory generateMinimumSnapTrajectory(
     const quadrotor_common::TrajectoryPoint& start_state,
     const quadrotor_common::TrajectoryPoint& end_state,
     const PolynomialTrajectorySettings& trajectory_settings) {
+  return implementation::solveMinimumSnapTrajectory(
+      segment_times, start_state, end_state, trajectory_settings, nullptr);
+}
+
+PolynomialTrajectory implementation::solveMinimumSnapTrajectory(
+    const Eigen::VectorXd& segment_times,
+    const quadrotor_common::TrajectoryPoint& start_state,
+    const quadrotor_common::TrajectoryPoint& end_state,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    Eigen::VectorXd* cost_gradient,
+    std::shared_ptr<const implementation::QuadraticProgramFactorization>
+        factorization) {
   const int num_segments = segment_times.size();
 
   if (num_segments != trajectory_settings.way_points.size() + 1) {
@@ -38,13 +53,10 @@ PolynomialTrajectory generateMinimumSnapTrajectory(
   minimum_snap_trajectory.end_state.time_from_start = minimum_snap_trajectory.T;
 
   // Ensure trajectory settings that result in feasible optimization problem
-  const int min_poly_order = 2 +
-                             ceil(trajectory_settings.continuity_order *
-                                  (num_segments + 1) / float(num_segments)) -
-                             1;
   PolynomialTrajectorySettings new_trajectory_settings =
-      implementation::ensureFeasibleTrajectorySettings(trajectory_settings,
-                                                       min_poly_order);
+      implementation::ensureFeasibleTrajectorySettings(
+          trajectory_settings, implementation::minimumPolynomialOrder(
+                                   trajectory_settings, num_segments, false));
 
   // Add start and end position to way points vector
   new_trajectory_settings.way_points =
@@ -52,63 +64,57 @@ PolynomialTrajectory generateMinimumSnapTrajectory(
           trajectory_settings.way_points, start_state.position,
           end_state.position);
 
-  // Compute tau dot
-  // Definition: tau(i) = (time - wp_times_zero_start_(i)) /
-  //     (wp_times_zero_start_(i+1) - wp_times_zero_start_(i))
-  // Therefore tau_dot(i) = 1.0 / (wp_times_zero_start_(i+1) -
-  //     wp_times_zero_start_(i))
-  Eigen::VectorXd tau_dot(num_segments);
-  for (int i = 0; i < num_segments; i++) {
-    tau_dot(i) = 1.0 / segment_times(i);
+  // H and A_eq only depend on the segment times, so all axes share one
+  // factorization which is reused when replanning with the same timing
+  if (!factorization) {
+    factorization = implementation::getFactorization(new_trajectory_settings,
+                                                     segment_times, false);
   }
 
-  // Compute common matrices used for optimization later on
-  Eigen::MatrixXd H = implementation::generateHMatrix(new_trajectory_settings,
-                                                      num_segments, tau_dot);
-  Eigen::MatrixXd A_eq = implementation::generateEqualityConstraintsAMatrix(
-      new_trajectory_settings, num_segments, tau_dot);
-
-  std::vector<Eigen::MatrixXd> coefficients;
-  // Compute trajectory for each spatial dimension
+  Eigen::MatrixXd f(factorization->H.rows(), 3);
+  Eigen::MatrixXd b_eq(factorization->A_eq.rows(), 3);
   for (int d = 0; d < 3; d++) {
     Eigen::VectorXd way_points_d = Eigen::VectorXd::Zero(num_segments + 1);
     for (int i = 0; i < num_segments + 1; i++) {
-      Eigen::VectorXd way_point_i = new_trajectory_settings.way_points[i];
-      way_points_d(i) = way_point_i(d);
+      way_points_d(i) = new_trajectory_settings.way_points[i](d);
     }
 
-    Eigen::Vector3d start_conditions(start_state.velocity(d),
-                                     start_state.acceleration(d),
-                                     start_state.jerk(d));
-    Eigen::Vector3d end_conditions(
-        end_state.velocity(d), end_state.acceleration(d), end_state.jerk(d));
+    Eigen::Vector4d start_conditions(
+        start_state.velocity(d), start_state.acceleration(d),
+        start_state.jerk(d), start_state.snap(d));
+    Eigen::Vector4d end_conditions(end_state.velocity(d),
+                                   end_state.acceleration(d),
+                                   end_state.jerk(d), end_state.snap(d));
 
-    Eigen::MatrixXd coefficients_for_this_dimension;
-    Eigen::VectorXd f = implementation::generateFVector(
-        new_trajectory_settings, way_points_d, num_segments);
-    Eigen::VectorXd b_eq = implementation::generateEqualityConstraintsBVector(
+    f.col(d) = implementation::generateFVector(new_trajectory_settings,
+                                               way_points_d, num_segments);
+    b_eq.col(d) = implementation::generateEqualityConstraintsBVector(
         new_trajectory_settings, num_segments, way_points_d, start_conditions,
         end_conditions);
+  }
 
-    double cost_dimension;
-    coefficients_for_this_dimension = implementation::generate1DTrajectory(
-        num_segments, new_trajectory_settings.polynomial_order, H, f, A_eq,
-        b_eq, &cost_dimension);
-    if (cost_dimension > 1e20 || std::isnan(cost_dimension)) {
-      ROS_ERROR("[%s] Could not solve quadratic program.",
-                ros::this_node::getName().c_str());
-      minimum_snap_trajectory.trajectory_type =
-          polynomial_trajectories::TrajectoryType::UNDEFINED;
-      return minimum_snap_trajectory;
-    }
-
-    minimum_snap_trajectory.optimization_cost += cost_dimension;
-    coefficients.push_back(coefficients_for_this_dimension);
+  // Compute trajectory for all spatial dimensions at once
+  Eigen::VectorXd costs;
+  Eigen::MatrixXd multipliers;
+  const Eigen::MatrixXd solutions = implementation::solveQuadraticPrograms(
+      *factorization, f, b_eq, &costs, &multipliers);
+  if (costs.maxCoeff() > 1e20 || costs.hasNaN()) {
+    ROS_ERROR("[%s] Could not solve quadratic program.",
+              ros::this_node::getName().c_str());
+    minimum_snap_trajectory.trajectory_type =
+        polynomial_trajectories::TrajectoryType::UNDEFINED;
+    return minimum_snap_trajectory;
+  }
+  minimum_snap_trajectory.optimization_cost = costs.sum();
+  if (cost_gradient != nullptr) {
+    *cost_gradient = implementation::computeSegmentTimeGradient(
+        new_trajectory_settings, segment_times, *factorization, solutions,
+        multipliers, false);
   }
 
   minimum_snap_trajectory.coeff =
       implementation::reorganiceCoefficientsSegmentWise(
-          coefficients, num_segments, new_trajectory_settings.polynomial_order);
+          solutions, num_segments, new_trajectory_settings.polynomial_order);
 
   return minimum_snap_trajectory;
 }
@@ -195,15 +201,21 @@ PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
     const quadrotor_common::TrajectoryPoint& start_state,
     const quadrotor_common::TrajectoryPoint& end_state,
-    const PolynomialTrajectorySettings& trajectory_settings) {
+    const PolynomialTrajectorySettings& trajectory_settings,
+    SegmentRefinementStatistics* statistics) {
+  const ros::WallTime start_time = ros::WallTime::now();
+
   // Compute trajectory with initial values
-  PolynomialTrajectory initial_trajectory = generateMinimumSnapTrajectory(
-      initial_segment_times, start_state, end_state, trajectory_settings);
+  Eigen::VectorXd gradient;
+  PolynomialTrajectory initial_trajectory =
+      implementation::solveMinimumSnapTrajectory(initial_segment_times,
+                                                 start_state, end_state,
+                                                 trajectory_settings, &gradient);
   if (initial_trajectory.trajectory_type ==
       polynomial_trajectories::TrajectoryType::UNDEFINED) {
     return initial_trajectory;
   }
-  initial_trajectory.trajectory_type ==
+  initial_trajectory.trajectory_type =
       polynomial_trajectories::TrajectoryType::MINIMUM_SNAP_OPTIMIZED_SEGMENTS;
 
   if (trajectory_settings.way_points.empty()) {
@@ -211,32 +223,9 @@ PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
     return initial_trajectory;
   }
 
-  PolynomialTrajectory trajectory = initial_trajectory;
-
-  std::vector<double> costs;
-  costs.push_back(initial_trajectory.optimization_cost);
-
-  const int max_refinement_iterations = 20;
-  for (int i = 0; i < max_refinement_iterations; i++) {
-    Eigen::VectorXd gradient =
-        implementation::computeCostGradient(trajectory, trajectory_settings);
-
-    Eigen::VectorXd segment_times = implementation::updateSegmentTimes(
-        trajectory, gradient, trajectory_settings);
-
-    trajectory = generateMinimumSnapTrajectory(segment_times, start_state,
-                                               end_state, trajectory_settings);
-
-    if (fabs(costs.back() - trajectory.optimization_cost) < 1e-2) {
-      costs.push_back(trajectory.optimization_cost);
-      break;
-    }
-    costs.push_back(trajectory.optimization_cost);
-  }
-
-  trajectory.trajectory_type = initial_trajectory.trajectory_type;
-
-  return trajectory;
+  return implementation::refineSegmentTimes(
+      initial_trajectory, gradient, trajectory_settings, start_time,
+      statistics);
 }
 
 PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
@@ -245,7 +234,7 @@ PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
     const quadrotor_common::TrajectoryPoint& end_state,
     const PolynomialTrajectorySettings& trajectory_settings,
     const double max_velocity, const double max_normalized_thrust,
-    const double max_roll_pitch_rate)
+    const double max_roll_pitch_rate, SegmentRefinementStatistics* statistics)
 
 {
   if (!isStartAndEndStateFeasibleUnderConstraints(
@@ -303,7 +292,7 @@ PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
   PolynomialTrajectory initial_trajectory =
       generateMinimumSnapTrajectoryWithSegmentRefinement(
           bounds_violating_segment_times, start_state, end_state,
-          trajectory_settings);
+          trajectory_settings, statistics);
 
   if (initial_trajectory.trajectory_type ==
       polynomial_trajectories::TrajectoryType::UNDEFINED) {
@@ -321,6 +310,16 @@ PolynomialTrajectory generateMinimumSnapTrajectoryWithSegmentRefinement(
 PolynomialTrajectory generateMinimumSnapRingTrajectory(
     const Eigen::VectorXd& segment_times,
     const PolynomialTrajectorySettings& trajectory_settings) {
+  return implementation::solveMinimumSnapRingTrajectory(
+      segment_times, trajectory_settings, nullptr);
+}
+
+PolynomialTrajectory implementation::solveMinimumSnapRingTrajectory(
+    const Eigen::VectorXd& segment_times,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    Eigen::VectorXd* cost_gradient,
+    std::shared_ptr<const implementation::QuadraticProgramFactorization>
+        factorization) {
   if (trajectory_settings.way_points.size() <= 2) {
     ROS_ERROR(
         "[%s] To create a ring trajectory, at least 2 way points must be "
@@ -359,62 +358,54 @@ PolynomialTrajectory generateMinimumSnapRingTrajectory(
   minimum_snap_trajectory.T = ros::Duration(segment_times.sum());
 
   // Ensure trajectory settings that result in feasible optimization problem
-  PolynomialTrajectorySettings new_trajectory_settings = trajectory_settings;
-  const int min_poly_order = trajectory_settings.continuity_order + 1;
-  new_trajectory_settings = implementation::ensureFeasibleTrajectorySettings(
-      trajectory_settings, min_poly_order);
-
-  // Compute tau dot
-  // Definition: tau(i) = (time - wp_times_zero_start_(i)) /
-  //     (wp_times_zero_start_(i+1) - wp_times_zero_start_(i))
-  // Therefore tau_dot(i) = 1.0 / (wp_times_zero_start_(i+1) -
-  //     wp_times_zero_start_(i))
-  Eigen::VectorXd tau_dot(num_segments);
-  for (int i = 0; i < num_segments; i++) {
-    tau_dot(i) = 1.0 / segment_times(i);
+  PolynomialTrajectorySettings new_trajectory_settings =
+      implementation::ensureFeasibleTrajectorySettings(
+          trajectory_settings, implementation::minimumPolynomialOrder(
+                                   trajectory_settings, num_segments, true));
+
+  // H and A_eq only depend on the segment times, so all axes share one
+  // factorization which is reused when replanning with the same timing
+  if (!factorization) {
+    factorization = implementation::getFactorization(new_trajectory_settings,
+                                                     segment_times, true);
   }
 
-  // Compute common matrices used for optimization later on
-  Eigen::MatrixXd H = implementation::generateHMatrix(new_trajectory_settings,
-                                                      num_segments, tau_dot);
-  Eigen::MatrixXd A_eq = implementation::generateRingEqualityConstraintsAMatrix(
-      new_trajectory_settings, num_segments, tau_dot);
-
-  std::vector<Eigen::MatrixXd> coefficients;
-  // Compute trajectory for each spatial dimension
+  Eigen::MatrixXd f(factorization->H.rows(), 3);
+  Eigen::MatrixXd b_eq(factorization->A_eq.rows(), 3);
   for (int d = 0; d < 3; d++) {
     Eigen::VectorXd way_points_d = Eigen::VectorXd::Zero(num_waypoints);
     for (int i = 0; i < num_waypoints; i++) {
-      Eigen::VectorXd way_point_i = trajectory_settings.way_points[i];
-      way_points_d(i) = way_point_i(d);
+      way_points_d(i) = trajectory_settings.way_points[i](d);
     }
 
-    Eigen::MatrixXd coefficients_for_this_dimension;
-    Eigen::VectorXd f = implementation::generateFVector(
-        new_trajectory_settings, way_points_d, num_segments);
-    Eigen::VectorXd b_eq =
-        implementation::generateRingEqualityConstraintsBVector(
-            new_trajectory_settings, num_segments, way_points_d);
-
-    double cost_dimension;
-    coefficients_for_this_dimension = implementation::generate1DTrajectory(
-        num_segments, new_trajectory_settings.polynomial_order, H, f, A_eq,
-        b_eq, &cost_dimension);
-    if (cost_dimension > 1e20 || std::isnan(cost_dimension)) {
-      ROS_ERROR("[%s] Could not solve quadratic program.",
-                ros::this_node::getName().c_str());
-      minimum_snap_trajectory.trajectory_type =
-          polynomial_trajectories::TrajectoryType::UNDEFINED;
-      return minimum_snap_trajectory;
-    }
+    f.col(d) = implementation::generateFVector(new_trajectory_settings,
+                                               way_points_d, num_segments);
+    b_eq.col(d) = implementation::generateRingEqualityConstraintsBVector(
+        new_trajectory_settings, num_segments, way_points_d);
+  }
 
-    minimum_snap_trajectory.optimization_cost += cost_dimension;
-    coefficients.push_back(coefficients_for_this_dimension);
+  // Compute trajectory for all spatial dimensions at once
+  Eigen::VectorXd costs;
+  Eigen::MatrixXd multipliers;
+  const Eigen::MatrixXd solutions = implementation::solveQuadraticPrograms(
+      *factorization, f, b_eq, &costs, &multipliers);
+  if (costs.maxCoeff() > 1e20 || costs.hasNaN()) {
+    ROS_ERROR("[%s] Could not solve quadratic program.",
+              ros::this_node::getName().c_str());
+    minimum_snap_trajectory.trajectory_type =
+        polynomial_trajectories::TrajectoryType::UNDEFINED;
+    return minimum_snap_trajectory;
+  }
+  minimum_snap_trajectory.optimization_cost = costs.sum();
+  if (cost_gradient != nullptr) {
+    *cost_gradient = implementation::computeSegmentTimeGradient(
+        new_trajectory_settings, segment_times, *factorization, solutions,
+        multipliers, true);
   }
 
   minimum_snap_trajectory.coeff =
       implementation::reorganiceCoefficientsSegmentWise(
-          coefficients, num_segments, new_trajectory_settings.polynomial_order);
+          solutions, num_segments, new_trajectory_settings.polynomial_order);
 
   // Set start and end state after computing trajectory
   quadrotor_common::TrajectoryPoint quad_state;
@@ -467,57 +458,32 @@ PolynomialTrajectory generateMinimumSnapRingTrajectory(
 
 PolynomialTrajectory generateMinimumSnapRingTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
-    const PolynomialTrajectorySettings& trajectory_settings) {
-  // Compute trajectory with initial values
-  PolynomialTrajectory initial_trajectory = generateMinimumSnapRingTrajectory(
-      initial_segment_times, trajectory_settings);
+    const PolynomialTrajectorySettings& trajectory_settings,
+    SegmentRefinementStatistics* statistics) {
+  const ros::WallTime start_time = ros::WallTime::now();
 
+  // Compute trajectory with initial values
+  Eigen::VectorXd gradient;
+  PolynomialTrajectory initial_trajectory =
+      implementation::solveMinimumSnapRingTrajectory(
+          initial_segment_times, trajectory_settings, &gradient);
   if (initial_trajectory.trajectory_type ==
       polynomial_trajectories::TrajectoryType::UNDEFINED) {
     return initial_trajectory;
   }
-  initial_trajectory.trajectory_type ==
-      polynomial_trajectories::TrajectoryType::
-          MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS;
-
-  if (trajectory_settings.way_points.empty()) {
-    // There is only one segment so no refinement is required
-    return initial_trajectory;
-  }
-
-  PolynomialTrajectory trajectory = initial_trajectory;
-
-  std::vector<double> costs;
-  costs.push_back(initial_trajectory.optimization_cost);
-
-  const int max_refinement_iterations = 20;
-  for (int i = 0; i < max_refinement_iterations; i++) {
-    Eigen::VectorXd gradient =
-        implementation::computeCostGradient(trajectory, trajectory_settings);
-
-    Eigen::VectorXd segment_times = implementation::updateSegmentTimes(
-        trajectory, gradient, trajectory_settings);
+  initial_trajectory.trajectory_type = polynomial_trajectories::
+      TrajectoryType::MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS;
 
-    trajectory =
-        generateMinimumSnapRingTrajectory(segment_times, trajectory_settings);
-
-    if (fabs(costs.back() - trajectory.optimization_cost) < 1e-2) {
-      costs.push_back(trajectory.optimization_cost);
-      break;
-    }
-    costs.push_back(trajectory.optimization_cost);
-  }
-
-  trajectory.trajectory_type = initial_trajectory.trajectory_type;
-
-  return trajectory;
+  return implementation::refineSegmentTimes(
+      initial_trajectory, gradient, trajectory_settings, start_time,
+      statistics);
 }
 
 PolynomialTrajectory generateMinimumSnapRingTrajectoryWithSegmentRefinement(
     const Eigen::VectorXd& initial_segment_times,
     const PolynomialTrajectorySettings& trajectory_settings,
     const double max_velocity, const double max_normalized_thrust,
-    const double max_roll_pitch_rate) {
+    const double max_roll_pitch_rate, SegmentRefinementStatistics* statistics) {
   // Compute initial trajectory such that bounds on velocity and thrust must
   // be violated
   double straight_line_distance = 0.0;
@@ -536,7 +502,7 @@ PolynomialTrajectory generateMinimumSnapRingTrajectoryWithSegmentRefinement(
 
   PolynomialTrajectory initial_trajectory =
       generateMinimumSnapRingTrajectoryWithSegmentRefinement(
-          bounds_violating_segment_times, trajectory_settings);
+          bounds_violating_segment_times, trajectory_settings, statistics);
 
   if (initial_trajectory.trajectory_type ==
       polynomial_trajectories::TrajectoryType::UNDEFINED) {
@@ -563,8 +529,27 @@ Eigen::MatrixXd generate1DTrajectory(const int num_polynoms,
   Eigen::VectorXd solution =
       implementation::solveQuadraticProgram(H, f, A, b, optimization_cost);
 
-  Eigen::MatrixXd coefficients;
-  coefficients = Eigen::Map<Eigen::MatrixXd>(
+  return reshapeSolution(solution, num_polynoms, polynomial_order);
+}
+
+Eigen::MatrixXd generate1DTrajectory(const int num_polynoms,
+                                     const int polynomial_order,
+                                     const Eigen::SparseMatrix<double>& H,
+                                     const Eigen::VectorXd& f,
+                                     const Eigen::SparseMatrix<double>& A,
+                                     const Eigen::VectorXd& b,
+                                     double* optimization_cost) {
+  Eigen::VectorXd solution =
+      implementation::solveQuadraticProgram(H, f, A, b, optimization_cost);
+
+  return reshapeSolution(solution, num_polynoms, polynomial_order);
+}
+
+Eigen::MatrixXd reshapeSolution(const Eigen::VectorXd& solution,
+                                const int num_polynoms,
+                                const int polynomial_order) {
+  // one row of coefficients per segment
+  Eigen::MatrixXd coefficients = Eigen::Map<const Eigen::MatrixXd>(
       solution.data(), polynomial_order + 1, num_polynoms);
   coefficients.transposeInPlace();
 
@@ -574,6 +559,13 @@ Eigen::MatrixXd generate1DTrajectory(const int num_polynoms,
 Eigen::MatrixXd generateHMatrix(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& tau_dot) {
+  return Eigen::MatrixXd(
+      generateSparseHMatrix(trajectory_settings, num_polynoms, tau_dot));
+}
+
+Eigen::SparseMatrix<double> generateSparseHMatrix(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const Eigen::VectorXd& tau_dot) {
   // up to which order derivatives should be minimized
   const int k_r = trajectory_settings.minimization_weights.size() - 1;
   const int poly_order = trajectory_settings.polynomial_order;
@@ -584,17 +576,18 @@ Eigen::MatrixXd generateHMatrix(
     factorials(i) = i * factorials(i - 1);
   }
 
-  // Initialize zero H matrix
-  Eigen::MatrixXd H = Eigen::MatrixXd::Zero((poly_order + 1) * num_polynoms,
-                                            (poly_order + 1) * num_polynoms);
-
-  // Create the H matrix
+  // The cost of a segment only depends on its own coefficients, so H is
+  // block diagonal. Each block is a weighted sum of the basis matrices of the
+  // minimized derivatives, scaled with the segment time.
+  std::vector<int> derivative_orders;
+  std::vector<Eigen::MatrixXd> weighted_bases;
   for (int hh = 0; hh < std::min(poly_order, k_r + 1); hh++) {
     if (trajectory_settings.minimization_weights(hh) != 0.0) {
       const int num_terms = poly_order - hh + 1;
 
       // Create a basis matrix which is used for computations later on
-      Eigen::MatrixXd H_basis = Eigen::MatrixXd::Zero(num_terms, num_terms);
+      Eigen::MatrixXd H_basis =
+          Eigen::MatrixXd::Zero(poly_order + 1, poly_order + 1);
       for (int i = 0; i < num_terms; i++) {
         for (int j = 0; j < num_terms; j++) {
           double numerator =
@@ -605,35 +598,34 @@ Eigen::MatrixXd generateHMatrix(
         }
       }
 
-      // Create another basis matrix
-      Eigen::MatrixXd H_times = Eigen::MatrixXd::Zero(num_terms, num_terms);
-      for (int i = 0; i < num_terms; i++) {
-        for (int j = 0; j < num_terms; j++) {
-          H_times(i, j) = 1.0;
-        }
-      }
-
-      Eigen::MatrixXd H_hh = Eigen::MatrixXd::Zero(
-          (poly_order + 1) * num_polynoms, (poly_order + 1) * num_polynoms);
-      for (int k = 0; k < num_polynoms; k++) {
-        H_hh.block(k * (poly_order + 1), k * (poly_order + 1), num_terms,
-                   num_terms) =
-            H_times.cwiseProduct(H_basis) * pow(tau_dot(k), 2.0 * hh);
-      }
+      derivative_orders.push_back(hh);
+      weighted_bases.push_back(trajectory_settings.minimization_weights(hh) *
+                               H_basis);
+    }
+  }
 
-      Eigen::MatrixXd weight_matrix = Eigen::MatrixXd::Zero(
-          (poly_order + 1) * num_polynoms, (poly_order + 1) * num_polynoms);
-      for (int i = 0; i < num_polynoms; i++) {
-        weight_matrix.block(i * (poly_order + 1), i * (poly_order + 1),
-                            poly_order + 1, poly_order + 1) =
-            trajectory_settings.minimization_weights(hh) *
-            Eigen::MatrixXd::Ones(poly_order + 1, poly_order + 1);
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(num_polynoms * (poly_order + 1) * (poly_order + 1));
+  Eigen::MatrixXd H_k(poly_order + 1, poly_order + 1);
+  for (int k = 0; k < num_polynoms; k++) {
+    H_k.setZero();
+    for (int b = 0; b < int(weighted_bases.size()); b++) {
+      H_k += weighted_bases[b] * pow(tau_dot(k), 2.0 * derivative_orders[b]);
+    }
+    for (int j = 0; j < poly_order + 1; j++) {
+      for (int i = 0; i < poly_order + 1; i++) {
+        if (H_k(i, j) != 0.0) {
+          triplets.emplace_back(k * (poly_order + 1) + i,
+                                k * (poly_order + 1) + j, H_k(i, j));
+        }
       }
-
-      H += H_hh.cwiseProduct(weight_matrix);
     }
   }
 
+  Eigen::SparseMatrix<double> H((poly_order + 1) * num_polynoms,
+                                (poly_order + 1) * num_polynoms);
+  H.setFromTriplets(triplets.begin(), triplets.end());
+
   return H;
 }
 
@@ -667,21 +659,29 @@ Eigen::VectorXd generateFVector(
 Eigen::MatrixXd generateEqualityConstraintsAMatrix(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& tau_dot) {
+  return Eigen::MatrixXd(generateSparseEqualityConstraintsAMatrix(
+      trajectory_settings, num_polynoms, tau_dot));
+}
+
+Eigen::SparseMatrix<double> generateSparseEqualityConstraintsAMatrix(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const Eigen::VectorXd& tau_dot) {
   const int poly_order = trajectory_settings.polynomial_order;
   const int continuity_order = trajectory_settings.continuity_order;
   const int num_constraints =
       2 * num_polynoms + continuity_order * (num_polynoms + 1);
 
-  Eigen::MatrixXd A =
-      Eigen::MatrixXd::Zero(num_constraints, (poly_order + 1) * num_polynoms);
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(num_polynoms * (poly_order + 2) +
+                   continuity_order * (num_polynoms + 1) * (poly_order + 1));
 
   //
   // Create position constraints at waypoints
   //
   for (int i = 0; i < num_polynoms; i++) {
-    A(2 * i, (poly_order + 1) * i + poly_order) = 1.0;
+    triplets.emplace_back(2 * i, (poly_order + 1) * i + poly_order, 1.0);
     for (int j = 0; j < poly_order + 1; j++) {
-      A(2 * i + 1, (poly_order + 1) * i + j) = 1.0;
+      triplets.emplace_back(2 * i + 1, (poly_order + 1) * i + j, 1.0);
     }
   }
 
@@ -692,13 +692,14 @@ Eigen::MatrixXd generateEqualityConstraintsAMatrix(
     Eigen::VectorXd factors = computeFactorials(poly_order - k, k);
     for (int j = 0; j < num_polynoms - 1; j++) {
       for (int i = 0; i < poly_order - k; i++) {
-        A(2 * num_polynoms + k * (num_polynoms - 1) + j,
-          j * (poly_order + 1) + i) =
-            factors(poly_order - k - 1 - i) * pow(tau_dot(j), k + 1);
+        triplets.emplace_back(
+            2 * num_polynoms + k * (num_polynoms - 1) + j,
+            j * (poly_order + 1) + i,
+            factors(poly_order - k - 1 - i) * pow(tau_dot(j), k + 1));
       }
-      A(2 * num_polynoms + k * (num_polynoms - 1) + j,
-        (j + 1) * (poly_order + 1) + (poly_order - 1 - k)) =
-          -factors(0) * pow(tau_dot(j + 1), k + 1);
+      triplets.emplace_back(2 * num_polynoms + k * (num_polynoms - 1) + j,
+                            (j + 1) * (poly_order + 1) + (poly_order - 1 - k),
+                            -factors(0) * pow(tau_dot(j + 1), k + 1));
     }
   }
 
@@ -706,24 +707,30 @@ Eigen::MatrixXd generateEqualityConstraintsAMatrix(
   // point
   for (int k = 0; k < continuity_order; k++) {
     Eigen::VectorXd factors = computeFactorials(poly_order - k, k);
-    A(2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2,
-      poly_order - 1 - k) = factors(0) * pow(tau_dot(0), k + 1);
+    triplets.emplace_back(
+        2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2,
+        poly_order - 1 - k, factors(0) * pow(tau_dot(0), k + 1));
     for (int i = 0; i < poly_order - k; i++) {
-      A(2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2 + 1,
-        (num_polynoms - 1) * (poly_order + 1) + i) =
+      triplets.emplace_back(
+          2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2 + 1,
+          (num_polynoms - 1) * (poly_order + 1) + i,
           factors(poly_order - k - 1 - i) *
-          pow(tau_dot(num_polynoms - 1), k + 1);
+              pow(tau_dot(num_polynoms - 1), k + 1));
     }
   }
 
+  Eigen::SparseMatrix<double> A(num_constraints,
+                                (poly_order + 1) * num_polynoms);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+
   return A;
 }
 
 Eigen::VectorXd generateEqualityConstraintsBVector(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& way_points_1D,
-    const Eigen::Vector3d& start_conditions,
-    const Eigen::Vector3d& end_conditions) {
+    const Eigen::Vector4d& start_conditions,
+    const Eigen::Vector4d& end_conditions) {
   const int continuity_order = trajectory_settings.continuity_order;
   const int num_constraints =
       2 * num_polynoms + continuity_order * (num_polynoms + 1);
@@ -742,7 +749,7 @@ Eigen::VectorXd generateEqualityConstraintsBVector(
 
   // Create constraints for the derivatives of position at the start and end
   // point
-  for (int k = 0; k < std::min(continuity_order, 3); k++) {
+  for (int k = 0; k < std::min(continuity_order, 4); k++) {
     b(2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2) =
         start_conditions(k);
     b(2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2 + 1) =
@@ -755,19 +762,27 @@ Eigen::VectorXd generateEqualityConstraintsBVector(
 Eigen::MatrixXd generateRingEqualityConstraintsAMatrix(
     const PolynomialTrajectorySettings& trajectory_settings,
     const int num_polynoms, const Eigen::VectorXd& tau_dot) {
+  return Eigen::MatrixXd(generateSparseRingEqualityConstraintsAMatrix(
+      trajectory_settings, num_polynoms, tau_dot));
+}
+
+Eigen::SparseMatrix<double> generateSparseRingEqualityConstraintsAMatrix(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const Eigen::VectorXd& tau_dot) {
   const int poly_order = trajectory_settings.polynomial_order;
   const int continuity_order = trajectory_settings.continuity_order;
   const int num_constraints =
       2 * num_polynoms + continuity_order * num_polynoms;
 
-  Eigen::MatrixXd A =
-      Eigen::MatrixXd::Zero(num_constraints, (poly_order + 1) * num_polynoms);
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(num_polynoms * (poly_order + 2) +
+                   continuity_order * num_polynoms * (poly_order + 1));
 
   // Create position constraints at waypoints
   for (int i = 0; i < num_polynoms; i++) {
-    A(2 * i, (poly_order + 1) * i + poly_order) = 1.0;
+    triplets.emplace_back(2 * i, (poly_order + 1) * i + poly_order, 1.0);
     for (int j = 0; j < poly_order + 1; j++) {
-      A(2 * i + 1, (poly_order + 1) * i + j) = 1.0;
+      triplets.emplace_back(2 * i + 1, (poly_order + 1) * i + j, 1.0);
     }
   }
 
@@ -776,20 +791,26 @@ Eigen::MatrixXd generateRingEqualityConstraintsAMatrix(
     Eigen::VectorXd factors = computeFactorials(poly_order - k, k);
     for (int j = 0; j < num_polynoms; j++) {
       for (int i = 0; i < poly_order - k; i++) {
-        A(2 * num_polynoms + k * num_polynoms + j, j * (poly_order + 1) + i) =
-            factors(poly_order - k - 1 - i) * pow(tau_dot(j), k + 1);
+        triplets.emplace_back(
+            2 * num_polynoms + k * num_polynoms + j, j * (poly_order + 1) + i,
+            factors(poly_order - k - 1 - i) * pow(tau_dot(j), k + 1));
       }
       if (j < num_polynoms - 1) {
-        A(2 * num_polynoms + k * num_polynoms + j,
-          (j + 1) * (poly_order + 1) + (poly_order - 1 - k)) =
-            -factors(0) * pow(tau_dot(j + 1), k + 1);
+        triplets.emplace_back(2 * num_polynoms + k * num_polynoms + j,
+                              (j + 1) * (poly_order + 1) + (poly_order - 1 - k),
+                              -factors(0) * pow(tau_dot(j + 1), k + 1));
       } else {
-        A(2 * num_polynoms + k * num_polynoms + j, poly_order - k - 1) =
-            -factors(0) * pow(tau_dot(0), k + 1);
+        triplets.emplace_back(2 * num_polynoms + k * num_polynoms + j,
+                              poly_order - k - 1,
+                              -factors(0) * pow(tau_dot(0), k + 1));
       }
     }
   }
 
+  Eigen::SparseMatrix<double> A(num_constraints,
+                                (poly_order + 1) * num_polynoms);
+  A.setFromTriplets(triplets.begin(), triplets.end());
+
   return A;
 }
 
@@ -814,54 +835,102 @@ Eigen::VectorXd generateRingEqualityConstraintsBVector(
   return b;
 }
 
-Eigen::VectorXd computeCostGradient(
-    const PolynomialTrajectory& initial_trajectory,
-    const PolynomialTrajectorySettings& trajectory_settings) {
-  int num_segments = int(initial_trajectory.segment_times.size());
-  Eigen::VectorXd gradient = Eigen::VectorXd::Zero(num_segments);
+Eigen::VectorXd generateConstraintTimeExponents(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_polynoms, const bool ring_trajectory) {
+  const int continuity_order = trajectory_settings.continuity_order;
 
-  for (int segment = 0; segment < num_segments; segment++) {
-    // compute delta S
-    Eigen::VectorXd delta_s =
-        -1.0 / (num_segments - 1) * Eigen::VectorXd::Ones(num_segments);
-    delta_s(segment) = 1.0;
-
-    // compute new segment times
-    double gradient_computation_step_size = 0.01;
-    Eigen::VectorXd segment_times = initial_trajectory.segment_times +
-                                    gradient_computation_step_size * delta_s;
-
-    // compute new cost by solving optimization with new segment times
-    PolynomialTrajectory trajectory;
-    if (initial_trajectory.trajectory_type ==
-        polynomial_trajectories::TrajectoryType::
-            MINIMUM_SNAP_OPTIMIZED_SEGMENTS) {
-      trajectory = generateMinimumSnapTrajectory(
-          segment_times, initial_trajectory.start_state,
-          initial_trajectory.end_state, trajectory_settings);
-    } else if (initial_trajectory.trajectory_type ==
-               polynomial_trajectories::TrajectoryType::
-                   MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
-      trajectory =
-          generateMinimumSnapRingTrajectory(segment_times, trajectory_settings);
+  // A constraint on the k-th derivative scales with tau_dot^k of the segment
+  // each coefficient belongs to, position constraints do not scale
+  Eigen::VectorXd exponents;
+  if (ring_trajectory) {
+    exponents = Eigen::VectorXd::Zero(2 * num_polynoms +
+                                      continuity_order * num_polynoms);
+    for (int k = 0; k < continuity_order; k++) {
+      exponents.segment(2 * num_polynoms + k * num_polynoms, num_polynoms)
+          .setConstant(k + 1);
     }
+  } else {
+    exponents = Eigen::VectorXd::Zero(2 * num_polynoms +
+                                      continuity_order * (num_polynoms + 1));
+    for (int k = 0; k < continuity_order; k++) {
+      exponents
+          .segment(2 * num_polynoms + k * (num_polynoms - 1), num_polynoms - 1)
+          .setConstant(k + 1);
+      exponents
+          .segment(
+              2 * num_polynoms + continuity_order * (num_polynoms - 1) + k * 2,
+              2)
+          .setConstant(k + 1);
+    }
+  }
+
+  return exponents;
+}
 
-    // add element to gradient
-    gradient(segment) =
-        (trajectory.optimization_cost - initial_trajectory.optimization_cost) /
-        gradient_computation_step_size;
+Eigen::VectorXd computeSegmentTimeGradient(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const Eigen::VectorXd& segment_times,
+    const QuadraticProgramFactorization& factorization,
+    const Eigen::MatrixXd& solutions, const Eigen::MatrixXd& multipliers,
+    const bool ring_trajectory) {
+  const int num_segments = segment_times.size();
+  const int num_coefficients = trajectory_settings.polynomial_order + 1;
+
+  // The optimal cost J = x' H x + f' x subject to A_eq x = b_eq only depends
+  // on the segment times through H and A_eq, so by the envelope theorem
+  //   dJ/dT_i = x' dH/dT_i x + lambda' dA_eq/dT_i x
+  // with the Lagrange multipliers lambda of the KKT system. All entries
+  // scale with a power of tau_dot = 1 / T of the segment their coefficient
+  // belongs to, so T_i * dH/dT_i and T_i * dA_eq/dT_i are H and A_eq with
+  // every term multiplied by minus its power of tau_dot.
+  PolynomialTrajectorySettings derivative_settings = trajectory_settings;
+  for (int hh = 0; hh < derivative_settings.minimization_weights.size();
+       hh++) {
+    derivative_settings.minimization_weights(hh) *= -2.0 * hh;
+  }
+  const Eigen::SparseMatrix<double> H_derivative = generateSparseHMatrix(
+      derivative_settings, num_segments, segment_times.cwiseInverse());
+  const Eigen::VectorXd exponents = generateConstraintTimeExponents(
+      trajectory_settings, num_segments, ring_trajectory);
+  const Eigen::SparseMatrix<double> A_derivative =
+      (-exponents).asDiagonal() * factorization.A_eq;
+
+  const Eigen::MatrixXd terms = solutions.cwiseProduct(
+      H_derivative * solutions +
+      Eigen::MatrixXd(A_derivative.transpose() * multipliers));
+
+  // sum up the terms of each segment over all axes
+  Eigen::VectorXd gradient(num_segments);
+  for (int i = 0; i < num_segments; i++) {
+    gradient(i) =
+        terms.middleRows(i * num_coefficients, num_coefficients).sum() /
+        segment_times(i);
   }
 
   return gradient;
 }
 
+Eigen::VectorXd computeCostGradient(
+    const PolynomialTrajectory& initial_trajectory,
+    const PolynomialTrajectorySettings& trajectory_settings) {
+  // The factorization for these segment times is cached, so this is only a
+  // back substitution
+  Eigen::VectorXd gradient;
+  solveWithSegmentTimes(initial_trajectory, initial_trajectory.segment_times,
+                        trajectory_settings, &gradient);
+
+  return gradient;
+}
+
 Eigen::VectorXd computeSearchDirection(
     const PolynomialTrajectory& initial_trajectory,
     const Eigen::VectorXd& gradient) {
-  // compute search direction starting from -gradient then scale it such that
-  // the norm of its elements are maximally
-  // (max_segment_update_ratio * segment_times(i))
-  Eigen::VectorXd search_direction = -gradient;
+  // compute search direction starting from -gradient projected such that the
+  // execution time stays the same, then scale it such that the norm of its
+  // elements are maximally (max_segment_update_ratio * segment_times(i))
+  Eigen::VectorXd search_direction =
+      -(gradient.array() - gradient.mean()).matrix();
   const double max_segment_update_ratio = 0.5;
 
   for (int i = 0; i < search_direction.rows(); i++) {
@@ -869,69 +938,127 @@ Eigen::VectorXd computeSearchDirection(
         max_segment_update_ratio * initial_trajectory.segment_times(i)) {
       search_direction *=
           (max_segment_update_ratio * initial_trajectory.segment_times(i) /
-           search_direction(i));
+           fabs(search_direction(i)));
     }
   }
 
-  // adapt search direction such that its vector sum is zero (total time of
-  // trajectory stays the same)
-  // we want |segment_times + search_direction| /
-  //     normalization_factor = trajectory.T
-  double normalization_factor =
-      (initial_trajectory.segment_times + search_direction).sum() /
-      initial_trajectory.T.toSec();
-
-  // and we want (segment_times + search_direction) / normalization_factor =
-  //     segment_times + adjusted_search_direction
-  search_direction = (initial_trajectory.segment_times + search_direction) /
-                         normalization_factor -
-                     initial_trajectory.segment_times;
-
   return search_direction;
 }
 
-Eigen::VectorXd updateSegmentTimes(
-    const PolynomialTrajectory& initial_trajectory,
-    const Eigen::VectorXd& gradient,
-    const PolynomialTrajectorySettings& trajectory_settings) {
-  Eigen::VectorXd updated_segment_times;
-
+bool updateSegmentTimes(const PolynomialTrajectory& initial_trajectory,
+                        const Eigen::VectorXd& gradient,
+                        const PolynomialTrajectorySettings& trajectory_settings,
+                        PolynomialTrajectory* trajectory,
+                        Eigen::VectorXd* updated_gradient, int* num_solves) {
   const Eigen::VectorXd search_direction =
       computeSearchDirection(initial_trajectory, gradient);
-  double step_ratio = 1.0;
+  // directional derivative of the cost along the search direction
+  const double slope = search_direction.dot(gradient);
+  if (slope >= 0.0) {
+    return false;
+  }
 
+  // backtracking line search with the Armijo condition
   const double backtracking_alpha = 0.1;
   const double backtracking_beta = 0.5;
+  const int max_line_search_steps = 10;
 
-  for (;;) {
-    Eigen::VectorXd step = step_ratio * search_direction;
-
-    updated_segment_times = initial_trajectory.segment_times + step;
-
-    // compute new cost by solving optimization with new segment times
-    PolynomialTrajectory trajectory;
-    if (initial_trajectory.trajectory_type ==
-        polynomial_trajectories::TrajectoryType::
-            MINIMUM_SNAP_OPTIMIZED_SEGMENTS) {
-      trajectory = generateMinimumSnapTrajectory(
-          updated_segment_times, initial_trajectory.start_state,
-          initial_trajectory.end_state, trajectory_settings);
-    } else if (initial_trajectory.trajectory_type ==
-               polynomial_trajectories::TrajectoryType::
-                   MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
-      trajectory = generateMinimumSnapRingTrajectory(updated_segment_times,
-                                                     trajectory_settings);
+  double step_ratio = 1.0;
+  for (int i = 0; i < max_line_search_steps; i++) {
+    const Eigen::VectorXd updated_segment_times =
+        initial_trajectory.segment_times + step_ratio * search_direction;
+    if (updated_segment_times.minCoeff() > 0.0) {
+      *trajectory =
+          solveWithSegmentTimes(initial_trajectory, updated_segment_times,
+                                trajectory_settings, updated_gradient);
+      (*num_solves)++;
+      if (trajectory->trajectory_type !=
+              polynomial_trajectories::TrajectoryType::UNDEFINED &&
+          trajectory->optimization_cost <
+              initial_trajectory.optimization_cost +
+                  backtracking_alpha * step_ratio * slope) {
+        return true;
+      }
     }
-
     step_ratio *= backtracking_beta;
-    if (trajectory.optimization_cost <
-        initial_trajectory.optimization_cost +
-            backtracking_alpha * step.dot(gradient)) {
+  }
+
+  return false;
+}
+
+PolynomialTrajectory solveWithSegmentTimes(
+    const PolynomialTrajectory& trajectory,
+    const Eigen::VectorXd& segment_times,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    Eigen::VectorXd* cost_gradient) {
+  PolynomialTrajectory new_trajectory;
+  if (trajectory.trajectory_type ==
+          polynomial_trajectories::TrajectoryType::MINIMUM_SNAP_RING ||
+      trajectory.trajectory_type == polynomial_trajectories::TrajectoryType::
+                                        MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
+    new_trajectory = solveMinimumSnapRingTrajectory(
+        segment_times, trajectory_settings, cost_gradient);
+  } else {
+    new_trajectory = solveMinimumSnapTrajectory(
+        segment_times, trajectory.start_state, trajectory.end_state,
+        trajectory_settings, cost_gradient);
+  }
+  if (new_trajectory.trajectory_type !=
+      polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    new_trajectory.trajectory_type = trajectory.trajectory_type;
+  }
+
+  return new_trajectory;
+}
+
+PolynomialTrajectory refineSegmentTimes(
+    const PolynomialTrajectory& initial_trajectory,
+    const Eigen::VectorXd& initial_gradient,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const ros::WallTime& start_time, SegmentRefinementStatistics* statistics) {
+  PolynomialTrajectory trajectory = initial_trajectory;
+  Eigen::VectorXd gradient = initial_gradient;
+
+  SegmentRefinementStatistics refinement_statistics;
+  refinement_statistics.initial_cost = initial_trajectory.optimization_cost;
+  refinement_statistics.num_solves = 1;
+
+  const int max_refinement_iterations = 20;
+  for (int i = 0; i < max_refinement_iterations; i++) {
+    PolynomialTrajectory updated_trajectory;
+    Eigen::VectorXd updated_gradient;
+    if (!updateSegmentTimes(trajectory, gradient, trajectory_settings,
+                            &updated_trajectory, &updated_gradient,
+                            &refinement_statistics.num_solves)) {
+      // no descent step found, the segment times are (locally) optimal
+      break;
+    }
+    refinement_statistics.iterations++;
+
+    const double improvement =
+        trajectory.optimization_cost - updated_trajectory.optimization_cost;
+    trajectory = updated_trajectory;
+    gradient = updated_gradient;
+    if (improvement < 1e-2) {
       break;
     }
   }
 
-  return updated_segment_times;
+  refinement_statistics.final_cost = trajectory.optimization_cost;
+  refinement_statistics.computation_time =
+      (ros::WallTime::now() - start_time).toSec();
+  ROS_DEBUG(
+      "[%s] Segment time refinement: %d iterations, %d QP solves, cost %f -> "
+      "%f in %f ms.",
+      ros::this_node::getName().c_str(), refinement_statistics.iterations,
+      refinement_statistics.num_solves, refinement_statistics.initial_cost,
+      refinement_statistics.final_cost,
+      1e3 * refinement_statistics.computation_time);
+  if (statistics != nullptr) {
+    *statistics = refinement_statistics;
+  }
+
+  return trajectory;
 }
 
 PolynomialTrajectory enforceMaximumVelocityAndThrust(
@@ -948,251 +1075,169 @@ PolynomialTrajectory enforceMaximumVelocityAndThrust(
     return initial_trajectory;
   }
 
-  PolynomialTrajectory trajectory = initial_trajectory;
-  Eigen::Vector3d desired_maxima =
+  const Eigen::Vector3d desired_maxima =
       Eigen::Vector3d(max_velocity, max_normalized_thrust, max_roll_pitch_rate);
-
-  Eigen::Vector3d prev_maxima;
-  computeQuadRelevantMaxima(trajectory, &prev_maxima.x(), &prev_maxima.y(),
-                            &prev_maxima.z());
-
-  while (prev_maxima.x() <= 1.01 * desired_maxima.x() &&
-         prev_maxima.y() <= 1.01 * desired_maxima.y() &&
-         prev_maxima.z() <= 1.01 * desired_maxima.z()) {
-    if ((prev_maxima.x() >= 0.99 * desired_maxima.x() ||
-         prev_maxima.y() >= 0.99 * desired_maxima.y() ||
-         prev_maxima.z() >= 0.99 * desired_maxima.z()) &&
-        (prev_maxima.x() <= desired_maxima.x() &&
-         prev_maxima.y() <= desired_maxima.y() &&
-         prev_maxima.z() <= desired_maxima.z())) {
-      return trajectory;
+  // A trajectory is accepted once its largest maximum is at most this
+  // fraction below the limit
+  const double tolerance = 0.01;
+  const int max_solves = 20;
+
+  // All segment times are scaled by the same factor, which keeps their ratio
+  // from the segment refinement. The limits are bracketed by halving or
+  // doubling the execution time, then the scale at which the largest maximum
+  // reaches its limit is found by regula falsi (Illinois). Its value is the
+  // inverse maxima ratio minus one, which is linear in the scale when the
+  // velocity is limiting.
+  PolynomialTrajectory trajectory = initial_trajectory;
+  PolynomialTrajectory feasible_trajectory;
+  PolynomialTrajectory closest_trajectory = initial_trajectory;
+  double closest_value = 0.0;
+  double scale = 1.0;
+  double feasible_scale = 0.0;
+  double feasible_value = 0.0;
+  double infeasible_scale = 0.0;
+  double infeasible_value = 0.0;
+  bool found_feasible = false;
+  bool found_infeasible = false;
+  int last_side = 0;
+  int num_solves = 0;
+  while (true) {
+    const double value =
+        1.0 / computeMaximaRatio(trajectory, desired_maxima) - 1.0;
+    if (value >= 0.0) {
+      feasible_trajectory = trajectory;
+      found_feasible = true;
+      if (value <= tolerance) {
+        break;
+      }
+      if (last_side == 1) {
+        infeasible_value *= 0.5;
+      }
+      feasible_scale = scale;
+      feasible_value = value;
+      last_side = 1;
+    } else {
+      // The maxima do not always decrease with the execution time, e.g. with
+      // non zero boundary derivatives, so the limits might not be reachable
+      if (!found_infeasible || value > closest_value) {
+        closest_trajectory = trajectory;
+        closest_value = value;
+      }
+      if (last_side == -1) {
+        feasible_value *= 0.5;
+      }
+      infeasible_scale = scale;
+      infeasible_value = value;
+      found_infeasible = true;
+      last_side = -1;
     }
 
-    if (initial_trajectory.trajectory_type ==
-            polynomial_trajectories::TrajectoryType::MINIMUM_SNAP ||
-        initial_trajectory.trajectory_type ==
-            polynomial_trajectories::TrajectoryType::
-                MINIMUM_SNAP_OPTIMIZED_SEGMENTS) {
-      trajectory = generateMinimumSnapTrajectory(
-          0.9 * trajectory.segment_times, initial_trajectory.start_state,
-          initial_trajectory.end_state, trajectory_settings);
-    } else if (initial_trajectory.trajectory_type ==
-                   polynomial_trajectories::TrajectoryType::MINIMUM_SNAP_RING ||
-               initial_trajectory.trajectory_type ==
-                   polynomial_trajectories::TrajectoryType::
-                       MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
-      trajectory = generateMinimumSnapRingTrajectory(
-          0.9 * trajectory.segment_times, trajectory_settings);
+    if (num_solves >= max_solves) {
+      break;
+    }
+    if (!found_infeasible) {
+      scale = 0.5 * feasible_scale;
+    } else if (!found_feasible) {
+      scale = 2.0 * infeasible_scale;
+    } else {
+      if (feasible_scale - infeasible_scale <= 1e-6 * feasible_scale) {
+        break;
+      }
+      scale = (infeasible_scale * feasible_value -
+               feasible_scale * infeasible_value) /
+              (feasible_value - infeasible_value);
     }
 
+    trajectory = solveWithSegmentTimes(initial_trajectory,
+                                       scale * initial_trajectory.segment_times,
+                                       trajectory_settings, nullptr);
+    num_solves++;
     // Check if generateMinimumSnap<Ring>Trajectory() was successful
     if (trajectory.trajectory_type ==
         polynomial_trajectories::TrajectoryType::UNDEFINED) {
       return trajectory;
     }
-
-    computeQuadRelevantMaxima(trajectory, &prev_maxima.x(), &prev_maxima.y(),
-                              &prev_maxima.z());
   }
 
-  // compute gradient of maxima with respect to T
-  Eigen::Vector3d maxima_gradient;
-  if (!computeMaximaGradient(trajectory, prev_maxima, trajectory_settings,
-                             &maxima_gradient)) {
-    trajectory.trajectory_type =
-        polynomial_trajectories::TrajectoryType::UNDEFINED;
-    return trajectory;
+  if (!found_feasible) {
+    ROS_WARN(
+        "[%s] Could not find a trajectory within the maximum velocity, thrust "
+        "and roll pitch rate, returning the closest one (%f s).",
+        ros::this_node::getName().c_str(), closest_trajectory.T.toSec());
+    return closest_trajectory;
   }
+  ROS_DEBUG(
+      "[%s] Enforced maximum velocity and thrust with %d QP solves, execution "
+      "time %f s -> %f s.",
+      ros::this_node::getName().c_str(), num_solves,
+      initial_trajectory.T.toSec(), feasible_trajectory.T.toSec());
 
-  // Iteratively optimize execution time
-  const int max_iterations = 15;
-  for (int i = 0; i < max_iterations; i++) {
-    Eigen::Vector3d new_intersections =
-        (desired_maxima - prev_maxima).cwiseQuotient(maxima_gradient) +
-        trajectory.T.toSec() * Eigen::Vector3d::Ones();
-
-    for (int i = 0; i < 3; i++) {
-      if (fabs(maxima_gradient(i)) < 5e-2) {
-        // make it negative since we will filter this out later
-        new_intersections(i) = -1.0;
-      }
-    }
-
-    Eigen::Vector3d prev_gradient = maxima_gradient;
-    PolynomialTrajectory prev_trajectory = trajectory;
-    bool exhaustivly_search_minimum = false;
-    Eigen::Vector3d maxima;
-
-    if (new_intersections.maxCoeff() > initial_trajectory.T.toSec()) {
-      // the ratio of segment times remains with scaling the execution time so
-      // only compute trajectory without segment refinement
-      if (initial_trajectory.trajectory_type ==
-              polynomial_trajectories::TrajectoryType::MINIMUM_SNAP ||
-          initial_trajectory.trajectory_type ==
-              polynomial_trajectories::TrajectoryType::
-                  MINIMUM_SNAP_OPTIMIZED_SEGMENTS) {
-        trajectory = generateMinimumSnapTrajectory(
-            trajectory.segment_times / trajectory.T.toSec() *
-                new_intersections.maxCoeff(),
-            initial_trajectory.start_state, initial_trajectory.end_state,
-            trajectory_settings);
-      } else if (initial_trajectory.trajectory_type ==
-                     polynomial_trajectories::TrajectoryType::
-                         MINIMUM_SNAP_RING ||
-                 initial_trajectory.trajectory_type ==
-                     polynomial_trajectories::TrajectoryType::
-                         MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
-        trajectory = generateMinimumSnapRingTrajectory(
-            trajectory.segment_times / trajectory.T.toSec() *
-                new_intersections.maxCoeff(),
-            trajectory_settings);
-      }
-
-      // Check if generateMinimumSnap<Ring>Trajectory() was successful
-      if (trajectory.trajectory_type ==
-          polynomial_trajectories::TrajectoryType::UNDEFINED) {
-        return trajectory;
-      }
-
-      computeQuadRelevantMaxima(trajectory, &maxima.x(), &maxima.y(),
-                                &maxima.z());
-
-      if (maxima.x() <= 1.01 * desired_maxima.x() &&
-          maxima.y() <= 1.01 * desired_maxima.y() &&
-          maxima.z() <= 1.01 * desired_maxima.z()) {
-        // we are close enough at the limits so we stop here
-        break;
-      }
+  return feasible_trajectory;
+}
 
-      // compute gradient of maxima with respect to T
-      if (!computeMaximaGradient(trajectory, maxima, trajectory_settings,
-                                 &maxima_gradient)) {
-        trajectory.trajectory_type =
-            polynomial_trajectories::TrajectoryType::UNDEFINED;
-        return trajectory;
-      }
+double computeMaximaRatio(const PolynomialTrajectory& trajectory,
+                          const Eigen::Vector3d& desired_maxima) {
+  Eigen::Vector3d maxima;
+  computeQuadRelevantMaxima(trajectory, &maxima.x(), &maxima.y(), &maxima.z());
 
-      // check if gradient flipped sign
-      if ((prev_gradient.cwiseProduct(maxima_gradient)).minCoeff() < 0.0) {
-        trajectory = prev_trajectory;
-        maxima_gradient = prev_gradient;
-        exhaustivly_search_minimum = true;
-      }
-    } else {
-      exhaustivly_search_minimum = true;
-    }
+  return maxima.cwiseQuotient(desired_maxima).maxCoeff();
+}
 
-    if (exhaustivly_search_minimum) {
-      for (int j = i; j < max_iterations; j++) {
-        if (initial_trajectory.trajectory_type ==
-                polynomial_trajectories::TrajectoryType::MINIMUM_SNAP ||
-            initial_trajectory.trajectory_type ==
-                polynomial_trajectories::TrajectoryType::
-                    MINIMUM_SNAP_OPTIMIZED_SEGMENTS) {
-          trajectory = generateMinimumSnapTrajectory(
-              1.1 * trajectory.segment_times, initial_trajectory.start_state,
-              initial_trajectory.end_state, trajectory_settings);
-        } else if (initial_trajectory.trajectory_type ==
-                       polynomial_trajectories::TrajectoryType::
-                           MINIMUM_SNAP_RING ||
-                   initial_trajectory.trajectory_type ==
-                       polynomial_trajectories::TrajectoryType::
-                           MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
-          trajectory = generateMinimumSnapRingTrajectory(
-              1.1 * trajectory.segment_times, trajectory_settings);
-        }
+double computeOptimizationCost(
+    const PolynomialTrajectory& trajectory,
+    const PolynomialTrajectorySettings& trajectory_settings) {
+  const int num_segments = trajectory.number_of_segments;
+  const int number_of_coefficients = trajectory.coeff.numberOfCoefficients();
 
-        // Check if generateMinimumSnap<Ring>Trajectory() was successful
-        if (trajectory.trajectory_type ==
-            polynomial_trajectories::TrajectoryType::UNDEFINED) {
-          return trajectory;
-        }
+  // Same normalization of the weights as in ensureFeasibleTrajectorySettings
+  PolynomialTrajectorySettings cost_settings = trajectory_settings;
+  cost_settings.polynomial_order = number_of_coefficients - 1;
+  cost_settings.minimization_weights =
+      trajectory_settings.minimization_weights /
+      trajectory_settings.minimization_weights.maxCoeff();
 
-        computeQuadRelevantMaxima(trajectory, &maxima.x(), &maxima.y(),
-                                  &maxima.z());
-        if ((maxima.x() > desired_maxima.x() &&
-             maxima.x() > prev_maxima.x() + 1e-6) ||
-            (maxima.y() > desired_maxima.y() &&
-             maxima.y() > prev_maxima.y() + 1e-6) ||
-            (maxima.z() > desired_maxima.z() &&
-             maxima.z() > prev_maxima.z() + 1e-6)) {
-          trajectory = prev_trajectory;
-          break;
-        }
-        if (maxima.x() <= 1.01 * desired_maxima.x() &&
-            maxima.y() <= 1.01 * desired_maxima.y() &&
-            maxima.z() <= 1.01 * desired_maxima.z()) {
-          // Reached desired maxima so we take this trajectory
-          break;
-        }
-        prev_maxima = maxima;
-        prev_trajectory = trajectory;
-      }
+  const Eigen::SparseMatrix<double> H = generateSparseHMatrix(
+      cost_settings, num_segments, trajectory.segment_times.cwiseInverse());
 
-      break;
+  double cost = 0.0;
+  for (int d = 0; d < 3; d++) {
+    Eigen::VectorXd solution(num_segments * number_of_coefficients);
+    Eigen::VectorXd way_points_d(num_segments + 1);
+    for (int segment = 0; segment < num_segments; segment++) {
+      solution.segment(segment * number_of_coefficients,
+                       number_of_coefficients) =
+          trajectory.coeff[segment].row(d).transpose();
+      // descending in tau, so the last coefficient is the start position
+      way_points_d(segment) =
+          trajectory.coeff[segment](d, number_of_coefficients - 1);
     }
-    prev_maxima = maxima;
-  }
+    way_points_d(num_segments) = trajectory.coeff[num_segments - 1].row(d).sum();
 
-  trajectory.trajectory_type = initial_trajectory.trajectory_type;
-
-  return trajectory;
-}
-
-bool computeMaximaGradient(
-    const PolynomialTrajectory& trajectory, const Eigen::Vector3d& maxima,
-    const PolynomialTrajectorySettings& trajectory_settings,
-    Eigen::Vector3d* gradient) {
-  PolynomialTrajectory gradient_trajectory = trajectory;
-  if (trajectory.trajectory_type ==
-          polynomial_trajectories::TrajectoryType::MINIMUM_SNAP ||
-      trajectory.trajectory_type == polynomial_trajectories::TrajectoryType::
-                                        MINIMUM_SNAP_OPTIMIZED_SEGMENTS) {
-    gradient_trajectory = generateMinimumSnapTrajectory(
-        1.01 * trajectory.segment_times, trajectory.start_state,
-        trajectory.end_state, trajectory_settings);
-  } else if (trajectory.trajectory_type ==
-                 polynomial_trajectories::TrajectoryType::MINIMUM_SNAP_RING ||
-             trajectory.trajectory_type ==
-                 polynomial_trajectories::TrajectoryType::
-                     MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS) {
-    gradient_trajectory = generateMinimumSnapRingTrajectory(
-        1.01 * trajectory.segment_times, trajectory_settings);
-  }
-
-  // Check if generateMinimumSnap<Ring>Trajectory() was successful
-  if (gradient_trajectory.trajectory_type ==
-      polynomial_trajectories::TrajectoryType::UNDEFINED) {
-    return false;
+    const Eigen::VectorXd f =
+        generateFVector(cost_settings, way_points_d, num_segments);
+    cost += solution.dot(H * solution) + f.dot(solution);
   }
 
-  Eigen::Vector3d gradient_trajectory_maxima;
-  computeQuadRelevantMaxima(
-      gradient_trajectory, &gradient_trajectory_maxima.x(),
-      &gradient_trajectory_maxima.y(), &gradient_trajectory_maxima.z());
-
-  *gradient = (gradient_trajectory_maxima - maxima) /
-              (gradient_trajectory.T - trajectory.T).toSec();
-
-  return true;
+  return cost;
 }
 
-std::vector<Eigen::MatrixXd> reorganiceCoefficientsSegmentWise(
-    const std::vector<Eigen::MatrixXd>& coefficients, const int num_segments,
+PolynomialCoefficients reorganiceCoefficientsSegmentWise(
+    const Eigen::MatrixXd& solutions, const int num_segments,
     const int polynomial_order) {
-  std::vector<Eigen::MatrixXd> reorganized_coefficients;
+  const int number_of_coefficients = polynomial_order + 1;
+  PolynomialCoefficients reorganized_coefficients(num_segments, 3,
+                                                  number_of_coefficients);
 
-  // Reorganize coefficients such that each element of the vector contains the
-  // coefficients for one trajectory segment
+  // The solution of each dimension holds the coefficients segment after
+  // segment, copy them into the segment blocks
   for (int segment = 0; segment < num_segments; segment++) {
-    Eigen::MatrixXd segment_coeff =
-        Eigen::MatrixXd::Zero(3, polynomial_order + 1);
-
     for (int dimension = 0; dimension < 3; dimension++) {
-      segment_coeff.row(dimension) = coefficients[dimension].row(segment);
+      reorganized_coefficients[segment].row(dimension) =
+          solutions.col(dimension)
+              .segment(segment * number_of_coefficients,
+                       number_of_coefficients)
+              .transpose();
     }
-
-    reorganized_coefficients.push_back(segment_coeff);
   }
 
   return reorganized_coefficients;
@@ -1267,6 +1312,187 @@ Eigen::VectorXd solveQuadraticProgram(const Eigen::MatrixXd& H,
   return solution;
 }
 
+Eigen::VectorXd solveQuadraticProgram(const Eigen::SparseMatrix<double>& H,
+                                      const Eigen::VectorXd& f,
+                                      const Eigen::SparseMatrix<double>& A_eq,
+                                      const Eigen::VectorXd& b_eq,
+                                      double* objective_value) {
+  Eigen::VectorXd objective_values;
+  const Eigen::VectorXd solution = solveQuadraticPrograms(
+      *factorizeQuadraticProgram(H, A_eq), f, b_eq, &objective_values);
+  *objective_value = objective_values(0);
+
+  return solution;
+}
+
+std::shared_ptr<QuadraticProgramFactorization> factorizeQuadraticProgram(
+    const Eigen::SparseMatrix<double>& H,
+    const Eigen::SparseMatrix<double>& A_eq) {
+  auto factorization = std::make_shared<QuadraticProgramFactorization>();
+  factorization->H = H;
+  factorization->A_eq = A_eq;
+
+  const int num_variables = H.rows();
+  const int num_constraints = A_eq.rows();
+
+  // Same Lagrange system as the dense solver. H is block diagonal and the
+  // constraints only couple neighboring segments, so the KKT matrix is banded
+  // and its sparse factorization scales linearly with the number of segments
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(H.nonZeros() + 2 * A_eq.nonZeros());
+  for (int k = 0; k < H.outerSize(); k++) {
+    for (Eigen::SparseMatrix<double>::InnerIterator it(H, k); it; ++it) {
+      triplets.emplace_back(it.row(), it.col(), 2.0 * it.value());
+    }
+  }
+  for (int k = 0; k < A_eq.outerSize(); k++) {
+    for (Eigen::SparseMatrix<double>::InnerIterator it(A_eq, k); it; ++it) {
+      triplets.emplace_back(num_variables + it.row(), it.col(), it.value());
+      triplets.emplace_back(it.col(), num_variables + it.row(), it.value());
+    }
+  }
+  Eigen::SparseMatrix<double> A_lagrange(num_variables + num_constraints,
+                                         num_variables + num_constraints);
+  A_lagrange.setFromTriplets(triplets.begin(), triplets.end());
+
+  // The KKT matrix is indefinite, so use LU instead of a Cholesky type
+  // factorization
+  factorization->solver.compute(A_lagrange);
+  factorization->success = factorization->solver.info() == Eigen::Success;
+
+  return factorization;
+}
+
+Eigen::MatrixXd solveQuadraticPrograms(
+    const QuadraticProgramFactorization& factorization,
+    const Eigen::MatrixXd& f, const Eigen::MatrixXd& b_eq,
+    Eigen::VectorXd* objective_values, Eigen::MatrixXd* multipliers) {
+  const int num_variables = factorization.H.rows();
+  const int num_constraints = factorization.A_eq.rows();
+  const int num_programs = f.cols();
+
+  if (!factorization.success) {
+    // callers treat a NaN cost as a failed optimization
+    *objective_values = Eigen::VectorXd::Constant(
+        num_programs, std::numeric_limits<double>::quiet_NaN());
+    if (multipliers != nullptr) {
+      *multipliers =
+          Eigen::MatrixXd::Constant(num_constraints, num_programs,
+                                    std::numeric_limits<double>::quiet_NaN());
+    }
+    return Eigen::MatrixXd::Constant(num_variables, num_programs,
+                                     std::numeric_limits<double>::quiet_NaN());
+  }
+
+  Eigen::MatrixXd b_lagrange(num_variables + num_constraints, num_programs);
+  b_lagrange.topRows(num_variables) = -f;
+  b_lagrange.bottomRows(num_constraints) = b_eq;
+
+  const Eigen::MatrixXd x = factorization.solver.solve(b_lagrange);
+  Eigen::MatrixXd solutions = x.topRows(num_variables);
+  if (multipliers != nullptr) {
+    *multipliers = x.bottomRows(num_constraints);
+  }
+
+  *objective_values = (solutions.transpose() * (factorization.H * solutions))
+                          .diagonal() +
+                      (f.transpose() * solutions).diagonal();
+
+  return solutions;
+}
+
+std::shared_ptr<const QuadraticProgramFactorization> getFactorization(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const Eigen::VectorXd& segment_times, const bool ring_trajectory) {
+  struct CacheEntry {
+    Eigen::VectorXd segment_times;
+    Eigen::VectorXd minimization_weights;
+    int polynomial_order;
+    int continuity_order;
+    bool ring_trajectory;
+    std::shared_ptr<const QuadraticProgramFactorization> factorization;
+  };
+  static const size_t kCacheSize = 16;
+  static std::list<CacheEntry> cache;
+  static std::mutex cache_mutex;
+
+  auto matches = [&](const CacheEntry& entry) {
+    return entry.ring_trajectory == ring_trajectory &&
+           entry.polynomial_order == trajectory_settings.polynomial_order &&
+           entry.continuity_order == trajectory_settings.continuity_order &&
+           entry.segment_times.size() == segment_times.size() &&
+           entry.segment_times == segment_times &&
+           entry.minimization_weights.size() ==
+               trajectory_settings.minimization_weights.size() &&
+           entry.minimization_weights ==
+               trajectory_settings.minimization_weights;
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto it = cache.begin(); it != cache.end(); it++) {
+      if (matches(*it)) {
+        // move to the front, the back is evicted first
+        cache.splice(cache.begin(), cache, it);
+        return cache.front().factorization;
+      }
+    }
+  }
+
+  // factorize outside of the lock, other threads keep using the cache
+  const int num_segments = segment_times.size();
+  const Eigen::VectorXd tau_dot = segment_times.cwiseInverse();
+  const Eigen::SparseMatrix<double> H =
+      generateSparseHMatrix(trajectory_settings, num_segments, tau_dot);
+  const Eigen::SparseMatrix<double> A_eq =
+      ring_trajectory ? generateSparseRingEqualityConstraintsAMatrix(
+                            trajectory_settings, num_segments, tau_dot)
+                      : generateSparseEqualityConstraintsAMatrix(
+                            trajectory_settings, num_segments, tau_dot);
+  std::shared_ptr<const QuadraticProgramFactorization> factorization =
+      factorizeQuadraticProgram(H, A_eq);
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache.push_front({segment_times, trajectory_settings.minimization_weights,
+                    trajectory_settings.polynomial_order,
+                    trajectory_settings.continuity_order, ring_trajectory,
+                    factorization});
+  if (cache.size() > kCacheSize) {
+    cache.pop_back();
+  }
+
+  return factorization;
+}
+
+int minimumPolynomialOrder(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const int num_segments, const bool ring_trajectory) {
+  if (ring_trajectory) {
+    return trajectory_settings.continuity_order + 1;
+  }
+  return 2 +
+         ceil(trajectory_settings.continuity_order * (num_segments + 1) /
+              float(num_segments)) -
+         1;
+}
+
+std::shared_ptr<const QuadraticProgramFactorization>
+getMinimumSnapFactorization(
+    const Eigen::VectorXd& segment_times,
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const bool ring_trajectory) {
+  const int num_segments = segment_times.size();
+  if (num_segments == 0) {
+    return nullptr;
+  }
+  return getFactorization(
+      ensureFeasibleTrajectorySettings(
+          trajectory_settings,
+          minimumPolynomialOrder(trajectory_settings, num_segments,
+                                 ring_trajectory)),
+      segment_times, ring_trajectory);
+}
+
 }  // namespace implementation
 
 }  // namespace minimum_snap_trajectories
@@ -0,0 +1,38 @@
+#include "polynomial_trajectories/polynomial_coefficients.h"
+
+namespace polynomial_trajectories {
+
+PolynomialCoefficients::PolynomialCoefficients()
+    : number_of_segments_(0), dimension_(0), number_of_coefficients_(0) {}
+
+PolynomialCoefficients::PolynomialCoefficients(
+    const int number_of_segments, const int dimension,
+    const int number_of_coefficients) {
+  resize(number_of_segments, dimension, number_of_coefficients);
+}
+
+PolynomialCoefficients::PolynomialCoefficients(
+    const std::vector<Eigen::MatrixXd>& segment_coefficients) {
+  if (segment_coefficients.empty()) {
+    resize(0, 0, 0);
+    return;
+  }
+  resize(segment_coefficients.size(), segment_coefficients[0].rows(),
+         segment_coefficients[0].cols());
+  for (int segment = 0; segment < number_of_segments_; segment++) {
+    (*this)[segment] = segment_coefficients[segment];
+  }
+}
+
+PolynomialCoefficients::~PolynomialCoefficients() {}
+
+void PolynomialCoefficients::resize(const int number_of_segments,
+                                    const int dimension,
+                                    const int number_of_coefficients) {
+  number_of_segments_ = number_of_segments;
+  dimension_ = dimension;
+  number_of_coefficients_ = number_of_coefficients;
+  data_.assign(number_of_segments * dimension * number_of_coefficients, 0.0);
+}
+
+}  // namespace polynomial_trajectories
@@ -1,6 +1,8 @@
 #include "polynomial_trajectories/polynomial_trajectories_common.h"
 
 #include <ros/ros.h>
+#include <algorithm>
+#include <utility>
 
 namespace polynomial_trajectories {
 
@@ -130,8 +132,9 @@ quadrotor_common::TrajectoryPoint getPointFromTrajectory(
       tau_dot(i) = 1.0 / trajectory.segment_times(i);
     }
 
+    const PolynomialCoefficients::ConstSegmentMap segment_coefficients =
+        trajectory.coeff[m];
     for (int d = 0; d < 3; d++) {
-      Eigen::MatrixXd segment_coefficients = trajectory.coeff[m];
       for (int i = 0; i < poly_order + 1; i++) {
         desired_position(d) +=
             segment_coefficients(d, i) * pow(tau, poly_order - i);
@@ -174,6 +177,53 @@ quadrotor_common::TrajectoryPoint getPointFromTrajectory(
   return desired_state;
 }
 
+bool sampleTrajectory(const PolynomialTrajectory& trajectory,
+                      const Eigen::VectorXd& times,
+                      TrajectorySamples* samples) {
+  if (trajectory.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    ROS_ERROR("[%s] The type of the trajectory you wanted to sample is not "
+              "defined!",
+              ros::this_node::getName().c_str());
+    return false;
+  }
+  if (trajectory.coeff.empty() || trajectory.coeff.dimension() < 3) {
+    ROS_ERROR("[%s] The passed trajectory contains no 3D polynomial "
+              "coefficients!",
+              ros::this_node::getName().c_str());
+    return false;
+  }
+
+  const int num_samples = times.size();
+  samples->times = times;
+  samples->position.resize(num_samples, 3);
+  samples->velocity.resize(num_samples, 3);
+  samples->acceleration.resize(num_samples, 3);
+  samples->jerk.resize(num_samples, 3);
+  samples->snap.resize(num_samples, 3);
+
+  // Fixed size evaluation for the common polynomial orders 5, 7, 9 and 11
+  switch (trajectory.coeff.numberOfCoefficients()) {
+    case 6:
+      implementation::sampleSegments<6>(trajectory, times, samples);
+      break;
+    case 8:
+      implementation::sampleSegments<8>(trajectory, times, samples);
+      break;
+    case 10:
+      implementation::sampleSegments<10>(trajectory, times, samples);
+      break;
+    case 12:
+      implementation::sampleSegments<12>(trajectory, times, samples);
+      break;
+    default:
+      implementation::sampleSegments<Eigen::Dynamic>(trajectory, times,
+                                                     samples);
+  }
+
+  return true;
+}
+
 Eigen::VectorXd computeFactorials(const int length, const int order) {
   Eigen::VectorXd factorials = Eigen::VectorXd::Zero(length);
 
@@ -235,27 +285,25 @@ void computeMaxima(const PolynomialTrajectory& trajectory,
   *maximal_acceleration = 0.0;
   *maximal_jerk = 0.0;
   *maximal_snap = 0.0;
-  double dt = 0.05;
-  if (trajectory.T.toSec() < 0.5) {
-    dt = 0.005;
+  if (trajectory.trajectory_type ==
+          polynomial_trajectories::TrajectoryType::UNDEFINED ||
+      trajectory.coeff.empty()) {
+    return;
   }
-  double t = 0.0;
-  while (t + dt <= trajectory.T.toSec()) {
-    t += dt;
-    quadrotor_common::TrajectoryPoint state =
-        getPointFromTrajectory(trajectory, ros::Duration(t));
-    double velocity = state.velocity.norm();
-    double acceleration = state.acceleration.norm();
-    double jerk = state.jerk.norm();
 
-    if (velocity > *maximal_velocity) {
-      *maximal_velocity = velocity;
-    }
-    if (acceleration > *maximal_acceleration) {
-      *maximal_acceleration = acceleration;
-    }
-    if (jerk > *maximal_jerk) {
-      *maximal_jerk = jerk;
+  for (int m = 0; m < trajectory.number_of_segments; m++) {
+    double* maxima[4] = {maximal_velocity, maximal_acceleration, maximal_jerk,
+                         maximal_snap};
+    for (int i = 0; i < 4; i++) {
+      const Eigen::VectorXd squared_norm =
+          implementation::squaredNormPolynomial(
+              implementation::segmentDerivativeCoefficients(trajectory, m,
+                                                            i + 1));
+      *maxima[i] = std::max(
+          *maxima[i],
+          sqrt(std::max(
+              implementation::maximizePolynomial(squared_norm, 0.0, 1.0),
+              0.0)));
     }
   }
 }
@@ -274,6 +322,49 @@ void computeQuadRelevantMaxima(const PolynomialTrajectory& trajectory,
   *maximal_normalized_thrust = 0.0;
   *maximal_roll_pitch_rate = 0.0;
 
+  for (int m = 0; m < trajectory.number_of_segments; m++) {
+    const Eigen::MatrixXd velocity =
+        implementation::segmentDerivativeCoefficients(trajectory, m, 1);
+    Eigen::MatrixXd thrust =
+        implementation::segmentDerivativeCoefficients(trajectory, m, 2);
+    thrust(2, 0) += 9.81;
+    const Eigen::MatrixXd jerk =
+        implementation::segmentDerivativeCoefficients(trajectory, m, 3);
+
+    *maximal_velocity =
+        std::max(*maximal_velocity,
+                 sqrt(std::max(implementation::maximizePolynomial(
+                                   implementation::squaredNormPolynomial(
+                                       velocity),
+                                   0.0, 1.0),
+                               0.0)));
+    *maximal_normalized_thrust =
+        std::max(*maximal_normalized_thrust,
+                 sqrt(std::max(implementation::maximizePolynomial(
+                                   implementation::squaredNormPolynomial(
+                                       thrust),
+                                   0.0, 1.0),
+                               0.0)));
+    *maximal_roll_pitch_rate =
+        std::max(*maximal_roll_pitch_rate,
+                 implementation::maximizeRollPitchRate(thrust, jerk));
+  }
+}
+
+void sampleQuadRelevantMaxima(const PolynomialTrajectory& trajectory,
+                              double* maximal_velocity,
+                              double* maximal_normalized_thrust,
+                              double* maximal_roll_pitch_rate) {
+  if (trajectory.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    ROS_ERROR("Could not compute maxima since trajectory type is UNDEFINED");
+    return;
+  }
+
+  *maximal_velocity = 0.0;
+  *maximal_normalized_thrust = 0.0;
+  *maximal_roll_pitch_rate = 0.0;
+
   const Eigen::Vector3d gravity(0.0, 0.0, 9.81);
 
   double dt = 0.01;
@@ -357,4 +448,366 @@ double computeRollPitchRateNormFromTrajectoryPoint(
   return roll_pitch_rate;
 }
 
+namespace implementation {
+
+template <int NumberOfCoefficients>
+void sampleSegments(const PolynomialTrajectory& trajectory,
+                    const Eigen::VectorXd& times, TrajectorySamples* samples) {
+  typedef Eigen::Matrix<double, 3, NumberOfCoefficients, Eigen::RowMajor>
+      CoefficientMatrix;
+
+  Eigen::MatrixX3d* derivatives[5] = {
+      &samples->position, &samples->velocity, &samples->acceleration,
+      &samples->jerk, &samples->snap};
+  const int number_of_coefficients = trajectory.coeff.numberOfCoefficients();
+
+  const bool is_ring =
+      trajectory.trajectory_type ==
+          polynomial_trajectories::TrajectoryType::MINIMUM_SNAP_RING ||
+      trajectory.trajectory_type == polynomial_trajectories::TrajectoryType::
+                                        MINIMUM_SNAP_RING_OPTIMIZED_SEGMENTS;
+  const bool is_fully_constrained =
+      trajectory.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::FULLY_CONSTRAINED;
+  const double duration = trajectory.T.toSec();
+  const int num_segments =
+      is_fully_constrained ? 1 : trajectory.number_of_segments;
+
+  // Current segment [segment_start, segment_end] and its derivative
+  // coefficients in ascending order of tau, zero padded to the same size and
+  // only rebuilt from the coefficient block when the segment changes, as in
+  // segmentDerivativeCoefficients
+  int segment = -1;
+  double segment_start = 0.0;
+  double segment_end = 0.0;
+  CoefficientMatrix coefficients[5];
+  for (int r = 0; r < 5; r++) {
+    coefficients[r].setZero(3, number_of_coefficients);
+  }
+
+  for (int i = 0; i < times.size(); i++) {
+    double t = times(i);
+    if (is_ring && (t < 0.0 || t > duration)) {
+      t -= duration * floor(t / duration);
+    }
+    t = std::min(std::max(t, 0.0), duration);
+
+    if (segment < 0 || t < segment_start || t > segment_end) {
+      if (segment < 0 || t < segment_start) {
+        segment = 0;
+        segment_start = 0.0;
+        segment_end =
+            num_segments > 1 ? trajectory.segment_times(0) : duration;
+      }
+      // At a segment boundary the earlier segment is used
+      while (t > segment_end && segment < num_segments - 1) {
+        segment++;
+        segment_start = segment_end;
+        segment_end += trajectory.segment_times(segment);
+      }
+      const PolynomialCoefficients::FixedSegmentMap<NumberOfCoefficients>
+          segment_coefficients =
+              trajectory.coeff.fixedSegment<NumberOfCoefficients>(segment);
+      double tau_dot;
+      if (is_fully_constrained) {
+        // ascending in t over the whole trajectory
+        for (int k = 0; k < number_of_coefficients; k++) {
+          coefficients[0].col(k) =
+              segment_coefficients.col(k) * pow(duration, k);
+        }
+        tau_dot = 1.0 / duration;
+      } else {
+        // descending in tau
+        for (int k = 0; k < number_of_coefficients; k++) {
+          coefficients[0].col(k) =
+              segment_coefficients.col(number_of_coefficients - 1 - k);
+        }
+        tau_dot = 1.0 / trajectory.segment_times(segment);
+      }
+      for (int r = 1; r < 5; r++) {
+        coefficients[r].setZero();
+        for (int k = 0; k + 1 < number_of_coefficients; k++) {
+          coefficients[r].col(k) =
+              (k + 1) * tau_dot * coefficients[r - 1].col(k + 1);
+        }
+      }
+    }
+
+    const double tau = (t - segment_start) / (segment_end - segment_start);
+    for (int r = 0; r < 5; r++) {
+      Eigen::Vector3d value = coefficients[r].col(number_of_coefficients - 1);
+      for (int k = number_of_coefficients - 2; k >= 0; k--) {
+        value = value * tau + coefficients[r].col(k);
+      }
+      derivatives[r]->row(i) = value.transpose();
+    }
+  }
+}
+
+Eigen::MatrixXd segmentDerivativeCoefficients(
+    const PolynomialTrajectory& trajectory, const int segment,
+    const int derivative_order) {
+  const PolynomialCoefficients::ConstSegmentMap segment_coefficients =
+      trajectory.coeff[segment];
+  const int number_of_coefficients = segment_coefficients.cols();
+
+  // Bring the coefficients to ascending order in tau = t / T
+  Eigen::MatrixXd coefficients(segment_coefficients.rows(),
+                               number_of_coefficients);
+  double tau_dot;
+  if (trajectory.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::FULLY_CONSTRAINED) {
+    // ascending in t over the whole trajectory
+    const double duration = trajectory.T.toSec();
+    for (int k = 0; k < number_of_coefficients; k++) {
+      coefficients.col(k) = segment_coefficients.col(k) * pow(duration, k);
+    }
+    tau_dot = 1.0 / duration;
+  } else {
+    // descending in tau
+    for (int k = 0; k < number_of_coefficients; k++) {
+      coefficients.col(k) =
+          segment_coefficients.col(number_of_coefficients - 1 - k);
+    }
+    tau_dot = 1.0 / trajectory.segment_times(segment);
+  }
+
+  for (int i = 0; i < derivative_order; i++) {
+    const int n = coefficients.cols();
+    if (n <= 1) {
+      return Eigen::MatrixXd::Zero(coefficients.rows(), 1);
+    }
+    Eigen::MatrixXd derivative(coefficients.rows(), n - 1);
+    for (int k = 0; k < n - 1; k++) {
+      derivative.col(k) = (k + 1) * tau_dot * coefficients.col(k + 1);
+    }
+    coefficients = derivative;
+  }
+
+  return coefficients;
+}
+
+double evaluatePolynomial(const Eigen::VectorXd& coefficients,
+                          const double tau) {
+  double value = 0.0;
+  for (int k = coefficients.size() - 1; k >= 0; k--) {
+    value = value * tau + coefficients(k);
+  }
+  return value;
+}
+
+Eigen::VectorXd differentiatePolynomial(const Eigen::VectorXd& coefficients) {
+  if (coefficients.size() <= 1) {
+    return Eigen::VectorXd::Zero(1);
+  }
+  Eigen::VectorXd derivative(coefficients.size() - 1);
+  for (int k = 0; k < derivative.size(); k++) {
+    derivative(k) = (k + 1) * coefficients(k + 1);
+  }
+  return derivative;
+}
+
+Eigen::VectorXd multiplyPolynomials(const Eigen::VectorXd& a,
+                                    const Eigen::VectorXd& b) {
+  Eigen::VectorXd product = Eigen::VectorXd::Zero(a.size() + b.size() - 1);
+  for (int i = 0; i < a.size(); i++) {
+    product.segment(i, b.size()) += a(i) * b;
+  }
+  return product;
+}
+
+Eigen::VectorXd squaredNormPolynomial(const Eigen::MatrixXd& coefficients) {
+  Eigen::VectorXd squared_norm =
+      Eigen::VectorXd::Zero(2 * coefficients.cols() - 1);
+  for (int d = 0; d < coefficients.rows(); d++) {
+    squared_norm += multiplyPolynomials(coefficients.row(d).transpose(),
+                                        coefficients.row(d).transpose());
+  }
+  return squared_norm;
+}
+
+std::vector<double> polynomialRootsInInterval(
+    const Eigen::VectorXd& coefficients, const double lower,
+    const double upper) {
+  std::vector<double> roots;
+
+  // Drop vanishing leading coefficients, they would make the root isolation
+  // of the derivative ill conditioned
+  const double scale = coefficients.cwiseAbs().maxCoeff();
+  int degree = coefficients.size() - 1;
+  while (degree > 0 && fabs(coefficients(degree)) <= 1e-14 * scale) {
+    degree--;
+  }
+  if (degree == 0 || scale == 0.0) {
+    return roots;
+  }
+  const Eigen::VectorXd polynomial = coefficients.head(degree + 1);
+  if (degree == 1) {
+    const double root = -polynomial(0) / polynomial(1);
+    if (root >= lower && root <= upper) {
+      roots.push_back(root);
+    }
+    return roots;
+  }
+
+  // The polynomial is monotonic between the roots of its derivative, so each
+  // of these intervals contains at most one root
+  const Eigen::VectorXd derivative = differentiatePolynomial(polynomial);
+  std::vector<double> breakpoints =
+      polynomialRootsInInterval(derivative, lower, upper);
+  breakpoints.insert(breakpoints.begin(), lower);
+  breakpoints.push_back(upper);
+
+  for (size_t i = 0; i + 1 < breakpoints.size(); i++) {
+    double a = breakpoints[i];
+    double b = breakpoints[i + 1];
+    const double f_a = evaluatePolynomial(polynomial, a);
+    const double f_b = evaluatePolynomial(polynomial, b);
+    if (f_a == 0.0) {
+      if (roots.empty() || roots.back() != a) {
+        roots.push_back(a);
+      }
+      continue;
+    }
+    if (f_a * f_b > 0.0) {
+      continue;
+    }
+    if (f_b == 0.0) {
+      roots.push_back(b);
+      continue;
+    }
+    // Newton iterations safeguarded by bisection of the bracket
+    double root = 0.5 * (a + b);
+    for (int iteration = 0; iteration < 100; iteration++) {
+      const double f_root = evaluatePolynomial(polynomial, root);
+      if (f_root == 0.0) {
+        break;
+      }
+      if ((f_root > 0.0) == (f_a > 0.0)) {
+        a = root;
+      } else {
+        b = root;
+      }
+      double next_root = root - f_root / evaluatePolynomial(derivative, root);
+      if (!(next_root > a && next_root < b)) {
+        next_root = 0.5 * (a + b);
+      }
+      const double step = fabs(next_root - root);
+      root = next_root;
+      if (step < 1e-12) {
+        break;
+      }
+    }
+    if (roots.empty() || roots.back() != root) {
+      roots.push_back(root);
+    }
+  }
+
+  return roots;
+}
+
+double maximizePolynomial(const Eigen::VectorXd& coefficients,
+                          const double lower, const double upper) {
+  double maximum = std::max(evaluatePolynomial(coefficients, lower),
+                            evaluatePolynomial(coefficients, upper));
+  for (const double root : polynomialRootsInInterval(
+           differentiatePolynomial(coefficients), lower, upper)) {
+    maximum = std::max(maximum, evaluatePolynomial(coefficients, root));
+  }
+  return maximum;
+}
+
+void boundPolynomial(const Eigen::VectorXd& coefficients, const double lower,
+                     const double upper, double* minimum, double* maximum) {
+  // Taylor shift to the center of the interval, p(c + h) = sum q_k h^k
+  const double center = 0.5 * (lower + upper);
+  const double radius = 0.5 * (upper - lower);
+  Eigen::VectorXd shifted = coefficients;
+  const int n = shifted.size();
+  for (int i = 0; i < n - 1; i++) {
+    for (int k = n - 2; k >= i; k--) {
+      shifted(k) += center * shifted(k + 1);
+    }
+  }
+
+  double deviation = 0.0;
+  double radius_power = 1.0;
+  for (int k = 1; k < n; k++) {
+    radius_power *= radius;
+    deviation += fabs(shifted(k)) * radius_power;
+  }
+  *minimum = shifted(0) - deviation;
+  *maximum = shifted(0) + deviation;
+}
+
+double maximizeRollPitchRate(const Eigen::MatrixXd& thrust_coefficients,
+                             const Eigen::MatrixXd& jerk_coefficients) {
+  // The roll pitch rate is |f x j| / |f|^2 with the thrust f and jerk j, see
+  // computeRollPitchRateNormFromTrajectoryPoint
+  std::vector<Eigen::VectorXd> cross_product(3);
+  for (int d = 0; d < 3; d++) {
+    const int d1 = (d + 1) % 3;
+    const int d2 = (d + 2) % 3;
+    cross_product[d] =
+        multiplyPolynomials(thrust_coefficients.row(d1).transpose(),
+                            jerk_coefficients.row(d2).transpose()) -
+        multiplyPolynomials(thrust_coefficients.row(d2).transpose(),
+                            jerk_coefficients.row(d1).transpose());
+  }
+  const Eigen::VectorXd squared_thrust =
+      squaredNormPolynomial(thrust_coefficients);
+
+  auto roll_pitch_rate = [&](const double tau) {
+    const Eigen::Vector3d rate_vector(
+        evaluatePolynomial(cross_product[0], tau),
+        evaluatePolynomial(cross_product[1], tau),
+        evaluatePolynomial(cross_product[2], tau));
+    const double thrust_squared = evaluatePolynomial(squared_thrust, tau);
+    return thrust_squared > 0.0 ? rate_vector.norm() / thrust_squared : 0.0;
+  };
+
+  // Branch and bound: intervals whose upper bound is below the best sampled
+  // rate are discarded, the others are sampled at their center and split
+  const double relative_tolerance = 1e-3;
+  const double min_interval_width = 1e-3;
+  double maximum = std::max(roll_pitch_rate(0.0), roll_pitch_rate(1.0));
+  std::vector<std::pair<double, double>> intervals;
+  intervals.push_back(std::make_pair(0.0, 1.0));
+  while (!intervals.empty()) {
+    const std::pair<double, double> interval = intervals.back();
+    intervals.pop_back();
+
+    double minimum_thrust_squared, maximum_thrust_squared;
+    boundPolynomial(squared_thrust, interval.first, interval.second,
+                    &minimum_thrust_squared, &maximum_thrust_squared);
+    if (minimum_thrust_squared > 0.0) {
+      double maximum_rate_vector_squared = 0.0;
+      for (int d = 0; d < 3; d++) {
+        double minimum_component, maximum_component;
+        boundPolynomial(cross_product[d], interval.first, interval.second,
+                        &minimum_component, &maximum_component);
+        maximum_rate_vector_squared +=
+            pow(std::max(fabs(minimum_component), fabs(maximum_component)),
+                2.0);
+      }
+      const double upper_bound =
+          sqrt(maximum_rate_vector_squared) / minimum_thrust_squared;
+      if (upper_bound <= (1.0 + relative_tolerance) * maximum) {
+        continue;
+      }
+    }
+
+    const double center = 0.5 * (interval.first + interval.second);
+    maximum = std::max(maximum, roll_pitch_rate(center));
+    if (interval.second - interval.first > min_interval_width) {
+      intervals.push_back(std::make_pair(interval.first, center));
+      intervals.push_back(std::make_pair(center, interval.second));
+    }
+  }
+
+  return maximum;
+}
+
+}  // namespace implementation
+
 }  // namespace polynomial_trajectories
@@ -0,0 +1,325 @@
+#include "polynomial_trajectories/receding_horizon_minimum_snap_planner.h"
+
+#include <ros/ros.h>
+#include <algorithm>
+
+#include "polynomial_trajectories/minimum_snap_trajectories.h"
+#include "polynomial_trajectories/polynomial_trajectories_common.h"
+
+namespace polynomial_trajectories {
+
+RecedingHorizonMinimumSnapPlanner::RecedingHorizonMinimumSnapPlanner(
+    const PolynomialTrajectorySettings& trajectory_settings,
+    const RecedingHorizonSettings& receding_horizon_settings)
+    : trajectory_settings_(trajectory_settings),
+      receding_horizon_settings_(receding_horizon_settings),
+      time_shift_(0.0) {}
+
+RecedingHorizonMinimumSnapPlanner::~RecedingHorizonMinimumSnapPlanner() {}
+
+bool RecedingHorizonMinimumSnapPlanner::initialize(
+    const Eigen::VectorXd& segment_times,
+    const quadrotor_common::TrajectoryPoint& start_state,
+    const quadrotor_common::TrajectoryPoint& end_state) {
+  const ros::WallTime start_time = ros::WallTime::now();
+  statistics_ = RecedingHorizonStatistics();
+  time_shift_ = 0.0;
+
+  const PolynomialTrajectory trajectory = optimizeWindow(
+      segment_times, start_state, end_state, trajectory_settings_, true,
+      start_time);
+  if (trajectory.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    return false;
+  }
+  trajectory_ = trajectory;
+  end_state_ = end_state;
+
+  const int num_way_points = trajectory_settings_.way_points.size();
+  segment_way_points_.resize(num_way_points + 1);
+  for (int i = 0; i <= num_way_points; i++) {
+    segment_way_points_[i] = i;
+  }
+
+  statistics_.window_segments = trajectory_.number_of_segments;
+  statistics_.computation_time = (ros::WallTime::now() - start_time).toSec();
+  return true;
+}
+
+bool RecedingHorizonMinimumSnapPlanner::replan(
+    const double time_from_start,
+    const std::vector<Eigen::Vector3d>& way_points) {
+  const ros::WallTime start_time = ros::WallTime::now();
+  statistics_ = RecedingHorizonStatistics();
+  time_shift_ = 0.0;
+
+  if (trajectory_.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    ROS_ERROR("[%s] Receding horizon planner is not initialized.",
+              ros::this_node::getName().c_str());
+    return false;
+  }
+  if (way_points.size() != trajectory_settings_.way_points.size()) {
+    ROS_ERROR(
+        "[%s] Receding horizon planner got %d way points instead of %d.",
+        ros::this_node::getName().c_str(), int(way_points.size()),
+        int(trajectory_settings_.way_points.size()));
+    return false;
+  }
+  trajectory_settings_.way_points = way_points;
+
+  const int num_segments = trajectory_.number_of_segments;
+  const int num_way_points = way_points.size();
+  const double duration = trajectory_.T.toSec();
+  const double current_time =
+      std::min(std::max(time_from_start, 0.0), duration);
+  const double commit_time =
+      current_time + receding_horizon_settings_.commit_horizon;
+
+  // Segment start times, the segment that is flown and the one at the commit
+  // time
+  std::vector<double> segment_start_times(num_segments + 1, 0.0);
+  for (int i = 0; i < num_segments; i++) {
+    segment_start_times[i + 1] =
+        segment_start_times[i] + trajectory_.segment_times(i);
+  }
+  int first_segment = 0;
+  while (first_segment < num_segments - 1 &&
+         current_time > segment_start_times[first_segment + 1]) {
+    first_segment++;
+  }
+  int commit_segment = first_segment;
+  while (commit_segment < num_segments - 1 &&
+         commit_time > segment_start_times[commit_segment + 1]) {
+    commit_segment++;
+  }
+  if (commit_time >= duration) {
+    // Everything is committed, nothing to replan
+    statistics_.computation_time = (ros::WallTime::now() - start_time).toSec();
+    return true;
+  }
+
+  // Committed prefix, the segment at the commit time is split if enough of it
+  // remains, otherwise it is committed as a whole
+  std::vector<Eigen::MatrixXd> prefix;
+  std::vector<double> prefix_times;
+  std::vector<int> prefix_way_points;
+  for (int i = first_segment; i < commit_segment; i++) {
+    prefix.push_back(trajectory_.coeff[i]);
+    prefix_times.push_back(trajectory_.segment_times(i));
+    prefix_way_points.push_back(segment_way_points_[i]);
+  }
+  const double committed_time =
+      commit_time - segment_start_times[commit_segment];
+  const double remaining_time =
+      segment_start_times[commit_segment + 1] - commit_time;
+  int window_start = commit_segment;
+  double window_start_time = commit_time;
+  double first_window_segment_time = remaining_time;
+  bool split = false;
+  if (remaining_time < receding_horizon_settings_.min_segment_time) {
+    prefix.push_back(trajectory_.coeff[commit_segment]);
+    prefix_times.push_back(trajectory_.segment_times(commit_segment));
+    prefix_way_points.push_back(segment_way_points_[commit_segment]);
+    window_start = commit_segment + 1;
+    window_start_time = segment_start_times[commit_segment + 1];
+    if (window_start >= num_segments) {
+      statistics_.computation_time =
+          (ros::WallTime::now() - start_time).toSec();
+      return true;
+    }
+    first_window_segment_time = trajectory_.segment_times(window_start);
+  } else if (committed_time > 1e-6) {
+    // The committed part of the segment, reparameterized to tau in [0, 1]
+    // with tau_old = ratio * tau, the coefficients are in descending order
+    const double ratio =
+        committed_time / trajectory_.segment_times(commit_segment);
+    Eigen::MatrixXd split_segment = trajectory_.coeff[commit_segment];
+    const int number_of_coefficients = split_segment.cols();
+    for (int k = 0; k < number_of_coefficients; k++) {
+      split_segment.col(k) *= pow(ratio, number_of_coefficients - 1 - k);
+    }
+    prefix.push_back(split_segment);
+    prefix_times.push_back(committed_time);
+    prefix_way_points.push_back(-1);
+    split = true;
+  }
+
+  // Window through the updated way points, warm started with the previous
+  // segment times
+  const int window_end =
+      std::min(window_start + receding_horizon_settings_.window_segments,
+               num_segments);
+  const int window_size = window_end - window_start;
+  Eigen::VectorXd window_times(window_size);
+  PolynomialTrajectorySettings window_settings = trajectory_settings_;
+  window_settings.way_points.clear();
+  std::vector<int> window_way_points;
+  for (int i = window_start; i < window_end; i++) {
+    window_times(i - window_start) = i == window_start
+                                         ? first_window_segment_time
+                                         : trajectory_.segment_times(i);
+    window_way_points.push_back(segment_way_points_[i]);
+    if (i < window_end - 1) {
+      const int way_point = segment_way_points_[i];
+      if (way_point >= 0 && way_point < num_way_points) {
+        window_settings.way_points.push_back(way_points[way_point]);
+      } else {
+        window_settings.way_points.push_back(
+            getPointFromTrajectory(
+                trajectory_, ros::Duration(segment_start_times[i + 1]))
+                .position);
+      }
+    }
+  }
+
+  const quadrotor_common::TrajectoryPoint window_start_state =
+      getPointFromTrajectory(trajectory_, ros::Duration(window_start_time));
+  // The window joins the remaining segments with their full state
+  const quadrotor_common::TrajectoryPoint window_end_state =
+      window_end == num_segments
+          ? end_state_
+          : getPointFromTrajectory(
+                trajectory_, ros::Duration(segment_start_times[window_end]));
+
+  // The segment times are only refined when the window starts at a segment
+  // boundary. The time of a split segment is where the way point was planned
+  // to be reached, refining it in every replanning step would keep moving the
+  // way point ahead of the vehicle at the cost of the following segments.
+  const PolynomialTrajectory window =
+      optimizeWindow(window_times, window_start_state, window_end_state,
+                     window_settings, !split, start_time);
+  if (window.trajectory_type ==
+      polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    ROS_WARN("[%s] Receding horizon replanning failed, keeping the previous "
+             "trajectory.",
+             ros::this_node::getName().c_str());
+    statistics_.computation_time = (ros::WallTime::now() - start_time).toSec();
+    statistics_.deadline_met = statistics_.computation_time <=
+                               receding_horizon_settings_.max_computation_time;
+    return false;
+  }
+
+  time_shift_ = segment_start_times[first_segment];
+  quadrotor_common::TrajectoryPoint start_state =
+      getPointFromTrajectory(trajectory_, ros::Duration(time_shift_));
+  start_state.time_from_start = ros::Duration(0.0);
+  spliceTrajectory(prefix, prefix_times, prefix_way_points, window,
+                   window_way_points, window_end, start_state);
+
+  statistics_.window_segments = window_size;
+  statistics_.window_optimization_cost = window.optimization_cost;
+  statistics_.computation_time = (ros::WallTime::now() - start_time).toSec();
+  statistics_.deadline_met = statistics_.computation_time <=
+                             receding_horizon_settings_.max_computation_time;
+  return true;
+}
+
+PolynomialTrajectory RecedingHorizonMinimumSnapPlanner::optimizeWindow(
+    const Eigen::VectorXd& segment_times,
+    const quadrotor_common::TrajectoryPoint& start_state,
+    const quadrotor_common::TrajectoryPoint& end_state,
+    const PolynomialTrajectorySettings& window_settings,
+    const bool refine_segment_times, const ros::WallTime& start_time) {
+  const bool refine = refine_segment_times &&
+                      receding_horizon_settings_.refine_segment_times &&
+                      segment_times.size() > 1;
+  Eigen::VectorXd gradient;
+  PolynomialTrajectory window =
+      minimum_snap_trajectories::implementation::solveMinimumSnapTrajectory(
+          segment_times, start_state, end_state, window_settings,
+          refine ? &gradient : nullptr);
+  statistics_.num_solves++;
+  if (!refine || window.trajectory_type ==
+                     polynomial_trajectories::TrajectoryType::UNDEFINED) {
+    return window;
+  }
+
+  // Segment time refinement as in
+  // generateMinimumSnapTrajectoryWithSegmentRefinement, but only as long as
+  // the next iteration, estimated by the longest one so far, fits into the
+  // time budget
+  const int max_refinement_iterations = 20;
+  double iteration_time = (ros::WallTime::now() - start_time).toSec();
+  for (int i = 0; i < max_refinement_iterations; i++) {
+    const ros::WallTime iteration_start = ros::WallTime::now();
+    if ((iteration_start - start_time).toSec() + iteration_time >
+        receding_horizon_settings_.max_computation_time) {
+      break;
+    }
+    PolynomialTrajectory updated_window;
+    Eigen::VectorXd updated_gradient;
+    if (!minimum_snap_trajectories::implementation::updateSegmentTimes(
+            window, gradient, window_settings, &updated_window,
+            &updated_gradient, &statistics_.num_solves)) {
+      break;
+    }
+    statistics_.refinement_iterations++;
+    const double improvement =
+        window.optimization_cost - updated_window.optimization_cost;
+    window = updated_window;
+    gradient = updated_gradient;
+    if (improvement < 1e-2) {
+      break;
+    }
+    iteration_time = std::max(
+        iteration_time, (ros::WallTime::now() - iteration_start).toSec());
+  }
+
+  return window;
+}
+
+void RecedingHorizonMinimumSnapPlanner::spliceTrajectory(
+    const std::vector<Eigen::MatrixXd>& prefix,
+    const std::vector<double>& prefix_times,
+    const std::vector<int>& prefix_way_points,
+    const PolynomialTrajectory& window,
+    const std::vector<int>& window_way_points, const int tail_start,
+    const quadrotor_common::TrajectoryPoint& start_state) {
+  const int num_tail_segments = trajectory_.number_of_segments - tail_start;
+  const int num_segments =
+      prefix.size() + window.number_of_segments + num_tail_segments;
+  // The window can have a higher polynomial order if it is short, lower
+  // orders get zero coefficients for the highest powers
+  const int number_of_coefficients =
+      std::max(trajectory_.coeff.numberOfCoefficients(),
+               window.coeff.numberOfCoefficients());
+
+  PolynomialCoefficients coefficients(num_segments, 3, number_of_coefficients);
+  Eigen::VectorXd segment_times(num_segments);
+  std::vector<int> segment_way_points;
+  int segment = 0;
+  for (size_t i = 0; i < prefix.size(); i++, segment++) {
+    coefficients[segment].rightCols(prefix[i].cols()) = prefix[i];
+    segment_times(segment) = prefix_times[i];
+    segment_way_points.push_back(prefix_way_points[i]);
+  }
+  for (int i = 0; i < window.number_of_segments; i++, segment++) {
+    coefficients[segment].rightCols(window.coeff.numberOfCoefficients()) =
+        window.coeff[i];
+    segment_times(segment) = window.segment_times(i);
+    segment_way_points.push_back(window_way_points[i]);
+  }
+  for (int i = tail_start; i < trajectory_.number_of_segments;
+       i++, segment++) {
+    coefficients[segment].rightCols(trajectory_.coeff.numberOfCoefficients()) =
+        trajectory_.coeff[i];
+    segment_times(segment) = trajectory_.segment_times(i);
+    segment_way_points.push_back(segment_way_points_[i]);
+  }
+
+  trajectory_.coeff = coefficients;
+  trajectory_.number_of_segments = num_segments;
+  trajectory_.segment_times = segment_times;
+  trajectory_.T = ros::Duration(segment_times.sum());
+  trajectory_.start_state = start_state;
+  trajectory_.end_state = end_state_;
+  trajectory_.end_state.time_from_start = trajectory_.T;
+  // The window cost is only a part of it
+  trajectory_.optimization_cost =
+      minimum_snap_trajectories::implementation::computeOptimizationCost(
+          trajectory_, trajectory_settings_);
+  segment_way_points_ = segment_way_points;
+}
+
+}  // namespace polynomial_trajectories
@@ -0,0 +1,372 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <quadrotor_common/trajectory_point.h>
+#include <ros/ros.h>
+#include <Eigen/Dense>
+
+#include "polynomial_trajectories/constrained_polynomial_trajectories.h"
+#include "polynomial_trajectories/minimum_snap_trajectories.h"
+#include "polynomial_trajectories/polynomial_trajectories_common.h"
+#include "polynomial_trajectories/polynomial_trajectory_settings.h"
+#include "polynomial_trajectories/receding_horizon_minimum_snap_planner.h"
+
+namespace polynomial_trajectories {
+
+namespace mst = minimum_snap_trajectories;
+
+namespace {
+
+// Random walk through num_way_points way points
+PolynomialTrajectorySettings randomSettings(const int num_way_points,
+                                            std::mt19937* generator) {
+  std::uniform_real_distribution<double> step(-5.0, 5.0);
+  std::vector<Eigen::Vector3d> way_points;
+  Eigen::Vector3d position = Eigen::Vector3d::Zero();
+  for (int i = 0; i < num_way_points; i++) {
+    position += Eigen::Vector3d(step(*generator), step(*generator),
+                                0.2 * step(*generator));
+    way_points.push_back(position);
+  }
+  Eigen::VectorXd minimization_weights(5);
+  minimization_weights << 0.1, 1.0, 0.5, 1.0, 1.0;
+  return PolynomialTrajectorySettings(way_points, minimization_weights, 7, 4);
+}
+
+Eigen::VectorXd randomSegmentTimes(const int num_segments,
+                                   std::mt19937* generator) {
+  std::uniform_real_distribution<double> segment_time(0.5, 1.5);
+  Eigen::VectorXd segment_times(num_segments);
+  for (int i = 0; i < num_segments; i++) {
+    segment_times(i) = segment_time(*generator);
+  }
+  return segment_times;
+}
+
+void getStartAndEndState(quadrotor_common::TrajectoryPoint* start_state,
+                         quadrotor_common::TrajectoryPoint* end_state) {
+  start_state->position = Eigen::Vector3d(0.0, 0.0, 1.0);
+  start_state->velocity = Eigen::Vector3d(1.0, 0.0, 0.0);
+  end_state->position = Eigen::Vector3d(3.0, 2.0, 1.0);
+  end_state->acceleration = Eigen::Vector3d(0.0, 1.0, 0.0);
+}
+
+Eigen::VectorXd randomPolynomial(const int degree, std::mt19937* generator) {
+  std::uniform_real_distribution<double> coefficient(-1.0, 1.0);
+  Eigen::VectorXd polynomial(degree + 1);
+  for (int i = 0; i <= degree; i++) {
+    polynomial(i) = coefficient(*generator);
+  }
+  return polynomial;
+}
+
+}  // namespace
+
+TEST(MinimumSnapTrajectories, SparseSolutionMatchesDense) {
+  std::mt19937 generator(0);
+  for (const int num_way_points : {3, 10, 30}) {
+    PolynomialTrajectorySettings settings =
+        randomSettings(num_way_points, &generator);
+    quadrotor_common::TrajectoryPoint start_state, end_state;
+    getStartAndEndState(&start_state, &end_state);
+    settings.way_points = mst::implementation::addStartAndEndToWayPointList(
+        settings.way_points, start_state.position, end_state.position);
+    const int num_segments = num_way_points + 1;
+    const Eigen::VectorXd tau_dot =
+        randomSegmentTimes(num_segments, &generator).cwiseInverse();
+
+    Eigen::VectorXd way_points_x(num_segments + 1);
+    for (int i = 0; i < num_segments + 1; i++) {
+      way_points_x(i) = settings.way_points[i].x();
+    }
+    const Eigen::SparseMatrix<double> H =
+        mst::implementation::generateSparseHMatrix(settings, num_segments,
+                                                   tau_dot);
+    const Eigen::SparseMatrix<double> A_eq =
+        mst::implementation::generateSparseEqualityConstraintsAMatrix(
+            settings, num_segments, tau_dot);
+    const Eigen::VectorXd f = mst::implementation::generateFVector(
+        settings, way_points_x, num_segments);
+    const Eigen::VectorXd b_eq =
+        mst::implementation::generateEqualityConstraintsBVector(
+            settings, num_segments, way_points_x,
+            Eigen::Vector4d(start_state.position.x(),
+                            start_state.velocity.x(), 0.0, 0.0),
+            Eigen::Vector4d(end_state.position.x(), 0.0, 0.0, 0.0));
+
+    double sparse_cost, dense_cost;
+    const Eigen::VectorXd sparse_solution =
+        mst::implementation::solveQuadraticProgram(H, f, A_eq, b_eq,
+                                                   &sparse_cost);
+    const Eigen::VectorXd dense_solution =
+        mst::implementation::solveQuadraticProgram(
+            Eigen::MatrixXd(H), f, Eigen::MatrixXd(A_eq), b_eq, &dense_cost);
+
+    ASSERT_EQ(dense_solution.size(), sparse_solution.size());
+    EXPECT_LT((sparse_solution - dense_solution).cwiseAbs().maxCoeff(),
+              1e-6 * std::max(dense_solution.cwiseAbs().maxCoeff(), 1.0))
+        << num_way_points << " way points";
+    EXPECT_NEAR(sparse_cost, dense_cost, 1e-8 * std::max(dense_cost, 1.0))
+        << num_way_points << " way points";
+  }
+}
+
+TEST(MinimumSnapTrajectories, CostGradientMatchesFiniteDifference) {
+  std::mt19937 generator(1);
+  for (const bool ring_trajectory : {false, true}) {
+    PolynomialTrajectorySettings settings = randomSettings(6, &generator);
+    if (ring_trajectory) {
+      settings.minimization_weights(0) = 0.0;
+      settings.polynomial_order = 11;
+    }
+    quadrotor_common::TrajectoryPoint start_state, end_state;
+    getStartAndEndState(&start_state, &end_state);
+    const int num_segments = ring_trajectory ? 6 : 7;
+    const Eigen::VectorXd segment_times =
+        randomSegmentTimes(num_segments, &generator);
+
+    auto solve = [&](const Eigen::VectorXd& times,
+                     Eigen::VectorXd* cost_gradient) {
+      return ring_trajectory
+                 ? mst::implementation::solveMinimumSnapRingTrajectory(
+                       times, settings, cost_gradient)
+                 : mst::implementation::solveMinimumSnapTrajectory(
+                       times, start_state, end_state, settings,
+                       cost_gradient);
+    };
+
+    Eigen::VectorXd gradient;
+    const PolynomialTrajectory trajectory = solve(segment_times, &gradient);
+    ASSERT_NE(trajectory.trajectory_type, TrajectoryType::UNDEFINED);
+    ASSERT_EQ(gradient.size(), num_segments);
+
+    const double h = 1e-5;
+    for (int i = 0; i < num_segments; i++) {
+      Eigen::VectorXd times_plus = segment_times;
+      Eigen::VectorXd times_minus = segment_times;
+      times_plus(i) += h;
+      times_minus(i) -= h;
+      const double finite_difference =
+          (solve(times_plus, nullptr).optimization_cost -
+           solve(times_minus, nullptr).optimization_cost) /
+          (2.0 * h);
+      EXPECT_NEAR(gradient(i), finite_difference,
+                  1e-4 * std::max(gradient.cwiseAbs().maxCoeff(), 1.0))
+          << (ring_trajectory ? "ring" : "open") << " segment " << i;
+    }
+  }
+}
+
+TEST(MinimumSnapTrajectories, EnforcedMaximaAreJustBelowLimits) {
+  std::mt19937 generator(5);
+  for (const bool ring_trajectory : {false, true}) {
+    PolynomialTrajectorySettings settings = randomSettings(10, &generator);
+    settings.minimization_weights(0) = 0.0;
+    // from rest to rest, otherwise the maxima do not decrease with the
+    // execution time
+    quadrotor_common::TrajectoryPoint start_state, end_state;
+    end_state.position = Eigen::Vector3d(3.0, 2.0, 1.0);
+    // each of velocity, thrust and roll pitch rate is limiting once
+    for (int limiting = 0; limiting < 3; limiting++) {
+      const Eigen::Vector3d limits(limiting == 0 ? 5.0 : 50.0,
+                                   limiting == 1 ? 15.0 : 50.0,
+                                   limiting == 2 ? 1.0 : 50.0);
+      const PolynomialTrajectory trajectory =
+          ring_trajectory
+              ? mst::generateMinimumSnapRingTrajectory(
+                    Eigen::VectorXd::Ones(10), settings, limits.x(),
+                    limits.y(), limits.z())
+              : mst::generateMinimumSnapTrajectory(
+                    Eigen::VectorXd::Ones(11), start_state, end_state,
+                    settings, limits.x(), limits.y(), limits.z());
+      ASSERT_NE(trajectory.trajectory_type, TrajectoryType::UNDEFINED);
+
+      Eigen::Vector3d maxima;
+      computeQuadRelevantMaxima(trajectory, &maxima.x(), &maxima.y(),
+                                &maxima.z());
+      const Eigen::Vector3d ratios = maxima.cwiseQuotient(limits);
+      EXPECT_LE(ratios.maxCoeff(), 1.0)
+          << (ring_trajectory ? "ring" : "open") << " limit " << limiting;
+      EXPECT_GE(ratios(limiting), 0.99)
+          << (ring_trajectory ? "ring" : "open") << " limit " << limiting;
+    }
+  }
+}
+
+TEST(MinimumSnapTrajectories, RecedingHorizonCostCoversAllSegments) {
+  std::mt19937 generator(6);
+  const PolynomialTrajectorySettings settings = randomSettings(12, &generator);
+  quadrotor_common::TrajectoryPoint start_state, end_state;
+  getStartAndEndState(&start_state, &end_state);
+  const Eigen::VectorXd segment_times = randomSegmentTimes(13, &generator);
+
+  // The recomputed cost of a solved trajectory is its optimization cost
+  const PolynomialTrajectory trajectory = mst::generateMinimumSnapTrajectory(
+      segment_times, start_state, end_state, settings);
+  ASSERT_NE(trajectory.trajectory_type, TrajectoryType::UNDEFINED);
+  EXPECT_NEAR(mst::implementation::computeOptimizationCost(trajectory,
+                                                           settings),
+              trajectory.optimization_cost,
+              1e-9 * trajectory.optimization_cost);
+
+  RecedingHorizonSettings receding_horizon_settings;
+  receding_horizon_settings.refine_segment_times = false;
+  RecedingHorizonMinimumSnapPlanner planner(settings,
+                                            receding_horizon_settings);
+  ASSERT_TRUE(planner.initialize(segment_times, start_state, end_state));
+  EXPECT_NEAR(planner.getTrajectory().optimization_cost,
+              trajectory.optimization_cost,
+              1e-9 * trajectory.optimization_cost);
+
+  ASSERT_TRUE(planner.replan(0.3, settings.way_points));
+  const PolynomialTrajectory& replanned = planner.getTrajectory();
+  EXPECT_NEAR(replanned.optimization_cost,
+              mst::implementation::computeOptimizationCost(replanned,
+                                                           settings),
+              1e-9 * replanned.optimization_cost);
+  // The window only spans a few of the segments
+  EXPECT_GT(replanned.optimization_cost,
+            2.0 * planner.getStatistics().window_optimization_cost);
+}
+
+TEST(PolynomialTrajectoriesCommon, RootsMatchSampledSignChanges) {
+  std::mt19937 generator(2);
+  const int num_samples = 100000;
+  for (int r = 0; r < 20; r++) {
+    const Eigen::VectorXd polynomial = randomPolynomial(9, &generator);
+    const std::vector<double> roots =
+        implementation::polynomialRootsInInterval(polynomial, -1.0, 1.0);
+
+    std::vector<double> sign_changes;
+    double previous =
+        implementation::evaluatePolynomial(polynomial, -1.0);
+    for (int k = 1; k <= num_samples; k++) {
+      const double tau = -1.0 + 2.0 * k / num_samples;
+      const double value = implementation::evaluatePolynomial(polynomial, tau);
+      if ((previous < 0.0) != (value < 0.0)) {
+        sign_changes.push_back(tau);
+      }
+      previous = value;
+    }
+
+    ASSERT_EQ(roots.size(), sign_changes.size()) << "polynomial " << r;
+    for (size_t i = 0; i < roots.size(); i++) {
+      EXPECT_NEAR(roots[i], sign_changes[i], 2.0 / num_samples)
+          << "polynomial " << r;
+      EXPECT_NEAR(implementation::evaluatePolynomial(polynomial, roots[i]),
+                  0.0, 1e-9)
+          << "polynomial " << r;
+    }
+  }
+}
+
+TEST(PolynomialTrajectoriesCommon, MaximaMatchDenseSampling) {
+  std::mt19937 generator(3);
+  const int num_samples = 10000;
+  for (int r = 0; r < 20; r++) {
+    Eigen::MatrixXd thrust(3, 6);
+    Eigen::MatrixXd jerk(3, 4);
+    for (int d = 0; d < 3; d++) {
+      thrust.row(d) = 3.0 * randomPolynomial(5, &generator).transpose();
+      jerk.row(d) = 10.0 * randomPolynomial(3, &generator).transpose();
+    }
+    // keep the thrust away from zero as a hovering quadrotor would
+    thrust(2, 0) += 9.81;
+
+    const Eigen::VectorXd polynomial = randomPolynomial(7, &generator);
+    double sampled_maximum = -1e9;
+    double sampled_rate = 0.0;
+    for (int k = 0; k <= num_samples; k++) {
+      const double tau = double(k) / num_samples;
+      sampled_maximum =
+          std::max(sampled_maximum,
+                   implementation::evaluatePolynomial(polynomial, tau));
+
+      Eigen::Vector3d f, j;
+      for (int d = 0; d < 3; d++) {
+        f(d) = implementation::evaluatePolynomial(thrust.row(d).transpose(), tau);
+        j(d) = implementation::evaluatePolynomial(jerk.row(d).transpose(), tau);
+      }
+      sampled_rate = std::max(sampled_rate, f.cross(j).norm() / f.squaredNorm());
+    }
+
+    // The polynomial maximum is exact, sampling can only miss it slightly
+    const double maximum =
+        implementation::maximizePolynomial(polynomial, 0.0, 1.0);
+    EXPECT_GE(maximum, sampled_maximum - 1e-12) << "polynomial " << r;
+    EXPECT_NEAR(maximum, sampled_maximum, 1e-6) << "polynomial " << r;
+
+    // Both are lower bounds within the branch and bound tolerance
+    const double rate = implementation::maximizeRollPitchRate(thrust, jerk);
+    EXPECT_NEAR(rate, sampled_rate, 2e-3 * sampled_rate) << "segment " << r;
+  }
+}
+
+TEST(PolynomialTrajectoriesCommon, SampleTrajectoryMatchesPointEvaluation) {
+  std::mt19937 generator(4);
+  quadrotor_common::TrajectoryPoint start_state, end_state;
+  getStartAndEndState(&start_state, &end_state);
+  // fixed size and dynamic sampling, fully constrained trajectories are
+  // ascending in t
+  std::vector<PolynomialTrajectory> trajectories;
+  PolynomialTrajectorySettings settings = randomSettings(8, &generator);
+  trajectories.push_back(mst::generateMinimumSnapTrajectory(
+      randomSegmentTimes(9, &generator), start_state, end_state, settings));
+  settings.minimization_weights(0) = 0.0;
+  settings.polynomial_order = 13;
+  trajectories.push_back(mst::generateMinimumSnapRingTrajectory(
+      randomSegmentTimes(8, &generator), settings));
+  trajectories.push_back(
+      constrained_polynomial_trajectories::computeFixedTimeTrajectory(
+          start_state, end_state, 4, 2.0));
+
+  for (const PolynomialTrajectory& trajectory : trajectories) {
+    ASSERT_NE(trajectory.trajectory_type, TrajectoryType::UNDEFINED);
+
+    // ros::Duration rounds to whole nanoseconds, sample both at those times
+    const int num_samples = 1000;
+    Eigen::VectorXd times =
+        Eigen::VectorXd::LinSpaced(num_samples, 0.0, trajectory.T.toSec());
+    for (int k = 0; k < num_samples; k++) {
+      times(k) = ros::Duration(times(k)).toSec();
+    }
+    TrajectorySamples samples;
+    ASSERT_TRUE(sampleTrajectory(trajectory, times, &samples));
+    ASSERT_EQ(samples.position.rows(), num_samples);
+
+    for (int k = 0; k < num_samples; k++) {
+      const quadrotor_common::TrajectoryPoint point =
+          getPointFromTrajectory(trajectory, ros::Duration(times(k)));
+      const double tolerance = 1e-9;
+      EXPECT_LT((samples.position.row(k).transpose() - point.position)
+                    .cwiseAbs()
+                    .maxCoeff(),
+                tolerance * std::max(point.position.norm(), 1.0));
+      EXPECT_LT((samples.velocity.row(k).transpose() - point.velocity)
+                    .cwiseAbs()
+                    .maxCoeff(),
+                tolerance * std::max(point.velocity.norm(), 1.0));
+      EXPECT_LT((samples.acceleration.row(k).transpose() - point.acceleration)
+                    .cwiseAbs()
+                    .maxCoeff(),
+                tolerance * std::max(point.acceleration.norm(), 1.0));
+      EXPECT_LT(
+          (samples.jerk.row(k).transpose() - point.jerk).cwiseAbs().maxCoeff(),
+          tolerance * std::max(point.jerk.norm(), 1.0));
+      EXPECT_LT(
+          (samples.snap.row(k).transpose() - point.snap).cwiseAbs().maxCoeff(),
+          tolerance * std::max(point.snap.norm(), 1.0));
+    }
+  }
+}
+
+}  // namespace polynomial_trajectories
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "polynomial_trajectories_test");
+
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <polynomial_trajectories/polynomial_trajectory.h>
 #include <polynomial_trajectories/polynomial_trajectory_settings.h>
 #include <quadrotor_common/trajectory.h>
@@ -81,6 +83,36 @@ generateMinimumSnapRingTrajectoryWithSegmentRefinement(
     const double max_velocity, const double max_normalized_thrust,
     const double max_roll_pitch_rate, const double sampling_frequency);
 
+// Batch of alternative minimum snap trajectories, e.g. different way point
+// orders or segment times of which the cheapest one is flown
+struct MinimumSnapCandidate {
+  // Initial segment times if refine_segment_times is set
+  Eigen::VectorXd segment_times;
+  // Not used for ring trajectories
+  quadrotor_common::TrajectoryPoint start_state;
+  quadrotor_common::TrajectoryPoint end_state;
+  polynomial_trajectories::PolynomialTrajectorySettings trajectory_settings;
+  bool ring_trajectory = false;
+  bool refine_segment_times = false;
+};
+
+struct MinimumSnapCandidateResult {
+  // Index of the candidate in the batch
+  int candidate = -1;
+  double optimization_cost = 0.0;
+  polynomial_trajectories::PolynomialTrajectory polynomial;
+  quadrotor_common::Trajectory trajectory;
+};
+
+// Solves the candidates on num_threads threads (the number of cores if it is
+// not positive) and returns them ranked by their optimization cost, candidates
+// that could not be solved are left out.
+// Candidates with the same segment times and settings share one factorization
+// of the QP, so alternative way point orders with the same timing are cheap.
+std::vector<MinimumSnapCandidateResult> generateMinimumSnapTrajectories(
+    const std::vector<MinimumSnapCandidate>& candidates,
+    const double sampling_frequency, const int num_threads = 0);
+
 // Sampling function
 quadrotor_common::Trajectory samplePolynomial(
     const polynomial_trajectories::PolynomialTrajectory& polynomial,
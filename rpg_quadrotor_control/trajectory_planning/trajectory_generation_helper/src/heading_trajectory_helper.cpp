@@ -8,11 +8,10 @@ namespace heading {
 
 void addConstantHeading(const double heading,
                         quadrotor_common::Trajectory* trajectory) {
-  std::list<quadrotor_common::TrajectoryPoint>::iterator it;
-  for (it = trajectory->points.begin(); it != trajectory->points.end(); it++) {
-    it->heading = heading;
-    it->heading_rate = 0.0;
-    it->heading_acceleration = 0.0;
+  for (quadrotor_common::TrajectoryPoint& point : trajectory->points) {
+    point.heading = heading;
+    point.heading_rate = 0.0;
+    point.heading_acceleration = 0.0;
   }
 }
 
@@ -31,15 +30,14 @@ void addConstantHeadingRate(const double initial_heading,
 
   const double heading_rate = delta_angle / trajectory_duration;
 
-  std::list<quadrotor_common::TrajectoryPoint>::iterator it;
-  for (it = trajectory->points.begin(); it != trajectory->points.end(); it++) {
+  for (quadrotor_common::TrajectoryPoint& point : trajectory->points) {
     const double duration_ratio =
-        (it->time_from_start - trajectory->points.front().time_from_start)
+        (point.time_from_start - trajectory->points.front().time_from_start)
             .toSec() /
         trajectory_duration;
-    it->heading = initial_heading + duration_ratio * delta_angle;
-    it->heading_rate = heading_rate;
-    it->heading_acceleration = 0.0;
+    point.heading = initial_heading + duration_ratio * delta_angle;
+    point.heading_rate = heading_rate;
+    point.heading_acceleration = 0.0;
   }
 }
 
@@ -1,5 +1,12 @@
 #include "trajectory_generation_helper/polynomial_trajectory_helper.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include <polynomial_trajectories/constrained_polynomial_trajectories.h>
 #include <polynomial_trajectories/minimum_snap_trajectories.h>
 #include <polynomial_trajectories/polynomial_trajectories_common.h>
@@ -8,6 +15,75 @@ namespace trajectory_generation_helper {
 
 namespace polynomials {
 
+namespace {
+
+// Calls function(i) for all i in [0, count) on up to num_threads threads
+void parallelFor(const int count, const int num_threads,
+                 const std::function<void(const int)>& function) {
+  std::atomic<int> next(0);
+  auto worker = [&]() {
+    for (int i = next++; i < count; i = next++) {
+      function(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < std::min(num_threads, count); i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// True if both candidates are solved with the same QP matrices
+bool shareFactorization(const MinimumSnapCandidate& a,
+                        const MinimumSnapCandidate& b) {
+  const polynomial_trajectories::PolynomialTrajectorySettings& settings_a =
+      a.trajectory_settings;
+  const polynomial_trajectories::PolynomialTrajectorySettings& settings_b =
+      b.trajectory_settings;
+  return !a.refine_segment_times && !b.refine_segment_times &&
+         a.ring_trajectory == b.ring_trajectory &&
+         settings_a.polynomial_order == settings_b.polynomial_order &&
+         settings_a.continuity_order == settings_b.continuity_order &&
+         a.segment_times.size() == b.segment_times.size() &&
+         a.segment_times == b.segment_times &&
+         settings_a.minimization_weights.size() ==
+             settings_b.minimization_weights.size() &&
+         settings_a.minimization_weights == settings_b.minimization_weights;
+}
+
+// The factorization is only used without segment refinement, which changes
+// the segment times
+polynomial_trajectories::PolynomialTrajectory solveCandidate(
+    const MinimumSnapCandidate& candidate,
+    const std::shared_ptr<const polynomial_trajectories::
+                              minimum_snap_trajectories::implementation::
+                                  QuadraticProgramFactorization>&
+        factorization) {
+  namespace mst = polynomial_trajectories::minimum_snap_trajectories;
+  if (candidate.ring_trajectory) {
+    return candidate.refine_segment_times
+               ? mst::generateMinimumSnapRingTrajectoryWithSegmentRefinement(
+                     candidate.segment_times, candidate.trajectory_settings)
+               : mst::implementation::solveMinimumSnapRingTrajectory(
+                     candidate.segment_times, candidate.trajectory_settings,
+                     nullptr, factorization);
+  }
+  return candidate.refine_segment_times
+             ? mst::generateMinimumSnapTrajectoryWithSegmentRefinement(
+                   candidate.segment_times, candidate.start_state,
+                   candidate.end_state, candidate.trajectory_settings)
+             : mst::implementation::solveMinimumSnapTrajectory(
+                   candidate.segment_times, candidate.start_state,
+                   candidate.end_state, candidate.trajectory_settings,
+                   nullptr, factorization);
+}
+
+}  // namespace
+
 // Constrained Polynomials
 quadrotor_common::Trajectory computeTimeOptimalTrajectory(
     const quadrotor_common::TrajectoryPoint& s0,
@@ -160,6 +236,95 @@ generateMinimumSnapRingTrajectoryWithSegmentRefinement(
   return samplePolynomial(polynomial, sampling_frequency);
 }
 
+std::vector<MinimumSnapCandidateResult> generateMinimumSnapTrajectories(
+    const std::vector<MinimumSnapCandidate>& candidates,
+    const double sampling_frequency, const int num_threads) {
+  namespace mst = polynomial_trajectories::minimum_snap_trajectories;
+  const int num_candidates = candidates.size();
+  const int threads =
+      num_threads > 0
+          ? num_threads
+          : std::max(int(std::thread::hardware_concurrency()), 1);
+
+  // Make the settings feasible before dispatching, the solvers then find
+  // nothing to correct and do not warn from the worker threads
+  // (ROS_WARN_THROTTLE keeps unsynchronized state)
+  std::vector<MinimumSnapCandidate> feasible_candidates = candidates;
+  for (MinimumSnapCandidate& candidate : feasible_candidates) {
+    if (candidate.segment_times.size() == 0) {
+      continue;
+    }
+    candidate.trajectory_settings =
+        mst::implementation::ensureFeasibleTrajectorySettings(
+            candidate.trajectory_settings,
+            mst::implementation::minimumPolynomialOrder(
+                candidate.trajectory_settings, candidate.segment_times.size(),
+                candidate.ring_trajectory));
+  }
+
+  // Group the candidates that share a factorization, it is computed once per
+  // group and held until all candidates are solved, so neither concurrent
+  // callers nor the number of groups can evict it from the factorization
+  // cache of minimum_snap_trajectories in between
+  std::vector<std::vector<int>> groups;
+  for (int i = 0; i < num_candidates; i++) {
+    auto group = std::find_if(
+        groups.begin(), groups.end(), [&](const std::vector<int>& group) {
+          return shareFactorization(feasible_candidates[group.front()],
+                                    feasible_candidates[i]);
+        });
+    if (group == groups.end()) {
+      groups.push_back({i});
+    } else {
+      group->push_back(i);
+    }
+  }
+
+  std::vector<std::shared_ptr<const mst::implementation::
+                                  QuadraticProgramFactorization>>
+      factorizations(num_candidates);
+  parallelFor(groups.size(), threads, [&](const int g) {
+    const MinimumSnapCandidate& candidate =
+        feasible_candidates[groups[g].front()];
+    if (candidate.refine_segment_times) {
+      return;
+    }
+    const auto factorization =
+        mst::implementation::getMinimumSnapFactorization(
+            candidate.segment_times, candidate.trajectory_settings,
+            candidate.ring_trajectory);
+    for (const int i : groups[g]) {
+      factorizations[i] = factorization;
+    }
+  });
+
+  std::vector<MinimumSnapCandidateResult> results(num_candidates);
+  parallelFor(num_candidates, threads, [&](const int i) {
+    results[i].candidate = i;
+    results[i].polynomial =
+        solveCandidate(feasible_candidates[i], factorizations[i]);
+    results[i].optimization_cost = results[i].polynomial.optimization_cost;
+    results[i].trajectory =
+        samplePolynomial(results[i].polynomial, sampling_frequency);
+  });
+
+  results.erase(
+      std::remove_if(results.begin(), results.end(),
+                     [](const MinimumSnapCandidateResult& result) {
+                       return result.polynomial.trajectory_type ==
+                              polynomial_trajectories::TrajectoryType::
+                                  UNDEFINED;
+                     }),
+      results.end());
+  std::stable_sort(results.begin(), results.end(),
+                   [](const MinimumSnapCandidateResult& a,
+                      const MinimumSnapCandidateResult& b) {
+                     return a.optimization_cost < b.optimization_cost;
+                   });
+
+  return results;
+}
+
 // Sampling function
 quadrotor_common::Trajectory samplePolynomial(
     const polynomial_trajectories::PolynomialTrajectory& polynomial,
@@ -176,12 +341,31 @@ quadrotor_common::Trajectory samplePolynomial(
   const ros::Duration dt(1.0 / sampling_frequency);
   ros::Duration time_from_start = polynomial.start_state.time_from_start + dt;
 
+  std::vector<double> sample_times;
   while (time_from_start < polynomial.T) {
-    trajectory.points.push_back(polynomial_trajectories::getPointFromTrajectory(
-        polynomial, time_from_start));
+    sample_times.push_back(time_from_start.toSec());
     time_from_start += dt;
   }
 
+  trajectory.points.reserve(sample_times.size() + 2);
+  polynomial_trajectories::TrajectorySamples samples;
+  if (polynomial_trajectories::sampleTrajectory(
+          polynomial,
+          Eigen::Map<const Eigen::VectorXd>(sample_times.data(),
+                                            sample_times.size()),
+          &samples)) {
+    for (int i = 0; i < samples.times.size(); i++) {
+      quadrotor_common::TrajectoryPoint point;
+      point.time_from_start = ros::Duration(samples.times(i));
+      point.position = samples.position.row(i).transpose();
+      point.velocity = samples.velocity.row(i).transpose();
+      point.acceleration = samples.acceleration.row(i).transpose();
+      point.jerk = samples.jerk.row(i).transpose();
+      point.snap = samples.snap.row(i).transpose();
+      trajectory.points.push_back(point);
+    }
+  }
+
   trajectory.points.push_back(polynomial.end_state);
 
   trajectory.trajectory_type =
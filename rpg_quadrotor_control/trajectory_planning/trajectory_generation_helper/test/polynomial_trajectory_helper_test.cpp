@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <polynomial_trajectories/minimum_snap_trajectories.h>
+#include <polynomial_trajectories/polynomial_trajectories_common.h>
+#include <polynomial_trajectories/polynomial_trajectory_settings.h>
+#include <quadrotor_common/trajectory_point.h>
+#include <ros/ros.h>
+#include <Eigen/Dense>
+
+#include "trajectory_generation_helper/polynomial_trajectory_helper.h"
+
+namespace trajectory_generation_helper {
+
+namespace polynomials {
+
+namespace mst = polynomial_trajectories::minimum_snap_trajectories;
+
+namespace {
+
+polynomial_trajectories::PolynomialTrajectory solveIndividually(
+    const MinimumSnapCandidate& candidate) {
+  if (candidate.ring_trajectory) {
+    return candidate.refine_segment_times
+               ? mst::generateMinimumSnapRingTrajectoryWithSegmentRefinement(
+                     candidate.segment_times, candidate.trajectory_settings)
+               : mst::generateMinimumSnapRingTrajectory(
+                     candidate.segment_times, candidate.trajectory_settings);
+  }
+  return candidate.refine_segment_times
+             ? mst::generateMinimumSnapTrajectoryWithSegmentRefinement(
+                   candidate.segment_times, candidate.start_state,
+                   candidate.end_state, candidate.trajectory_settings)
+             : mst::generateMinimumSnapTrajectory(
+                   candidate.segment_times, candidate.start_state,
+                   candidate.end_state, candidate.trajectory_settings);
+}
+
+}  // namespace
+
+TEST(PolynomialTrajectoryHelperTest, BatchMatchesIndividualTrajectories) {
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> position(-3.0, 3.0);
+  const int num_way_points = 4;
+
+  // More timing groups than the factorization cache of
+  // minimum_snap_trajectories holds, with several way point orders each
+  std::vector<MinimumSnapCandidate> candidates;
+  for (int g = 0; g < 40; g++) {
+    const bool ring = g % 5 == 0;
+    const Eigen::VectorXd segment_times = Eigen::VectorXd::Constant(
+        ring ? num_way_points : num_way_points + 1, 1.0 + 0.1 * g);
+    for (int k = 0; k < 4; k++) {
+      MinimumSnapCandidate candidate;
+      candidate.segment_times = segment_times;
+      candidate.ring_trajectory = ring;
+      // Too low for the continuity order, it is raised before solving
+      candidate.trajectory_settings.polynomial_order = g % 7 == 0 ? 5 : 11;
+      candidate.trajectory_settings.continuity_order = 4;
+      candidate.trajectory_settings.minimization_weights =
+          Eigen::Vector4d(0.0, 1.0, 1.0, 1.0);
+      for (int i = 0; i < num_way_points; i++) {
+        candidate.trajectory_settings.way_points.push_back(Eigen::Vector3d(
+            position(generator), position(generator), position(generator)));
+      }
+      candidate.start_state.position =
+          Eigen::Vector3d(position(generator), 0.0, 0.0);
+      candidate.end_state.position =
+          Eigen::Vector3d(0.0, position(generator), 0.0);
+      candidates.push_back(candidate);
+    }
+  }
+  candidates[1].refine_segment_times = true;
+  candidates[5].refine_segment_times = true;
+
+  const std::vector<MinimumSnapCandidateResult> results =
+      generateMinimumSnapTrajectories(candidates, 50.0, 4);
+
+  ASSERT_EQ(results.size(), candidates.size());
+  std::vector<bool> seen(candidates.size(), false);
+  for (size_t r = 0; r < results.size(); r++) {
+    const MinimumSnapCandidateResult& result = results[r];
+    ASSERT_GE(result.candidate, 0);
+    ASSERT_LT(result.candidate, int(candidates.size()));
+    EXPECT_FALSE(seen[result.candidate]);
+    seen[result.candidate] = true;
+    if (r > 0) {
+      EXPECT_LE(results[r - 1].optimization_cost, result.optimization_cost);
+    }
+
+    const polynomial_trajectories::PolynomialTrajectory expected =
+        solveIndividually(candidates[result.candidate]);
+    ASSERT_NE(expected.trajectory_type,
+              polynomial_trajectories::TrajectoryType::UNDEFINED);
+    EXPECT_NEAR(result.optimization_cost, expected.optimization_cost,
+                1e-9 * std::max(expected.optimization_cost, 1.0));
+    ASSERT_EQ(result.polynomial.segment_times.size(),
+              expected.segment_times.size());
+    EXPECT_LT((result.polynomial.segment_times - expected.segment_times)
+                  .cwiseAbs()
+                  .maxCoeff(),
+              1e-12);
+    ASSERT_EQ(result.polynomial.coeff.size(), expected.coeff.size());
+    for (size_t i = 0; i < expected.coeff.size(); i++) {
+      ASSERT_EQ(result.polynomial.coeff[i].rows(), expected.coeff[i].rows());
+      ASSERT_EQ(result.polynomial.coeff[i].cols(), expected.coeff[i].cols());
+      EXPECT_LT((result.polynomial.coeff[i] - expected.coeff[i])
+                    .cwiseAbs()
+                    .maxCoeff(),
+                1e-9 * std::max(expected.coeff[i].cwiseAbs().maxCoeff(), 1.0));
+    }
+    EXPECT_EQ(result.trajectory.points.size(),
+              samplePolynomial(expected, 50.0).points.size());
+  }
+}
+
+}  // namespace polynomials
+
+}  // namespace trajectory_generation_helper
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "polynomial_trajectory_helper_test");
+
+  return RUN_ALL_TESTS();
+}